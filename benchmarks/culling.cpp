@@ -0,0 +1,53 @@
+#include "../tuim.hpp"
+
+#include <chrono>
+
+// Builds screens made of many panels stacked vertically, where only the first ones fit in the terminal,
+// drawing the content of every panel or only the content of visible ones.
+int main(int argc, char* argv[]) {
+    const size_t framesCount = 100;
+    const std::vector<size_t> panelsCounts = { 10, 100, 1000 };
+
+    tuim::CreateContext(argc, argv);
+
+    bool checked = false;
+    int value = 10;
+
+    auto RenderFrames = [&](const std::vector<std::string>& ids, bool culling) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < framesCount; frame++) {
+            tuim::Update(0);
+            tuim::Clear();
+            for (size_t i = 0; i < ids.size(); i++) {
+                tuim::SetCurrentCursor(tuim::vec2(0, i * 6));
+                bool visible = tuim::BeginContainer(ids[i], "", tuim::vec2(40, 6));
+                if (visible || !culling) {
+                    tuim::Print("&rPanel #ff8800{}&r\n", i);
+                    tuim::Checkbox(ids[i] + "-check", "Enabled: {}\n", &checked);
+                    tuim::IntSlider(ids[i] + "-slider", "{} {}\n", &value, 0, 20, 1, 20);
+                }
+                tuim::EndContainer();
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+    };
+
+    std::vector<std::string> results;
+    for (size_t panelsCount : panelsCounts) {
+        std::vector<std::string> ids;
+        for (size_t i = 0; i < panelsCount; i++)
+            ids.push_back(std::format("#panel-{}", i));
+
+        double all = RenderFrames(ids, false);
+        double culled = RenderFrames(ids, true);
+        results.push_back(std::format("{:>5} panels: {:.3f} ms/frame drawing all, {:.3f} ms/frame with culling", panelsCount, all, culled));
+    }
+
+    tuim::DeleteContext();
+
+    for (const std::string& result : results)
+        std::cout << result << "\n";
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "../tuim.hpp"
+
+#include <chrono>
+
+// Builds a screen of 2000 widgets with static labels, with and without the text cache.
+int main(int argc, char* argv[]) {
+    const size_t widgetsCount = 2000;
+    const size_t framesCount = 200;
+
+    tuim::CreateContext(argc, argv);
+    tuim::Context* ctx = tuim::GetCtx();
+
+    std::vector<std::string> ids;
+    std::vector<std::string> labels;
+    for (size_t i = 0; i < widgetsCount; i++) {
+        ids.push_back(std::format("#widget-{}", i));
+        labels.push_back(std::format("Widget n°{} &r— static label\n", i));
+    }
+
+    std::vector<std::string> entries = { "first", "second", "third" };
+    bool checked = true;
+    int value = 50;
+    size_t index = 1;
+
+    auto RenderFrames = [&](size_t capacity) {
+        tuim::SetTextCacheCapacity(capacity);
+        ctx->m_TextCache.Clear();
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < framesCount; frame++) {
+            tuim::Update(0);
+            tuim::Clear();
+            for (size_t i = 0; i < widgetsCount; i++) {
+                switch (i % 4) {
+                    case 0: tuim::Button(ids[i], labels[i]); break;
+                    case 1: tuim::Checkbox(ids[i], labels[i] + "{}", &checked); break;
+                    case 2: tuim::IntSlider(ids[i], "{} {}\n", &value, 0, 100, 1, 20); break;
+                    case 3: tuim::EnumInput(ids[i], "< {} >\n", &index, entries); break;
+                }
+            }
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+    };
+
+    // Only measure the labels, to isolate the cost of CalcTextWidth from the rest of the widgets.
+    auto MeasureFrames = [&](size_t capacity) {
+        tuim::SetTextCacheCapacity(capacity);
+        ctx->m_TextCache.Clear();
+
+        volatile size_t total = 0; // Prevents the measures from being optimized away.
+        auto start = std::chrono::steady_clock::now();
+        for (size_t frame = 0; frame < framesCount; frame++) {
+            for (size_t i = 0; i < widgetsCount; i++)
+                total = total + tuim::CalcTextWidth(labels[i]);
+        }
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / framesCount;
+    };
+
+    double uncachedRender = RenderFrames(0);
+    double cachedRender = RenderFrames(4096);
+    double uncachedMeasure = MeasureFrames(0);
+    double cachedMeasure = MeasureFrames(4096);
+    size_t hits = ctx->m_TextCache.m_Hits;
+    size_t misses = ctx->m_TextCache.m_Misses;
+
+    tuim::DeleteContext();
+
+    std::cout << std::format("{} widgets, {} frames\n", widgetsCount, framesCount);
+    std::cout << std::format("render without cache:  {:.3f} ms/frame\n", uncachedRender);
+    std::cout << std::format("render with cache:     {:.3f} ms/frame\n", cachedRender);
+    std::cout << std::format("measure without cache: {:.3f} ms/frame\n", uncachedMeasure);
+    std::cout << std::format("measure with cache:    {:.3f} ms/frame ({} hits, {} misses)\n", cachedMeasure, hits, misses);
+
+    return 0;
+}
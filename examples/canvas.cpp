@@ -0,0 +1,50 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - canvas");
+    tuim::SetFramerate(20.f);
+
+    // A braille canvas has 2x4 pixels per cell, a half-block one has 1x2 pixels per cell.
+    tuim::CanvasData plot(tuim::vec2(40, 10));
+    tuim::CanvasData shapes(tuim::vec2(20, 10), tuim::CANVAS_FLAGS_HALF_BLOCK);
+    shapes.SetColor(tuim::Color(0x55, 0xAA, 0xFF));
+    shapes.DrawRect(tuim::vec2(0, 0), tuim::vec2(20, 20));
+    shapes.FillCircle(tuim::vec2(9, 9), 6);
+    shapes.SetColor(tuim::Color(0xFF, 0x55, 0x55));
+    shapes.DrawLine(tuim::vec2(1, 18), tuim::vec2(18, 1));
+
+    // Start the main loop.
+    int frame = 0;
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // Only the plot changes, the glyphs of the shapes are computed once.
+        plot.Clear();
+        tuim::vec2 size = plot.GetPixelSize();
+        tuim::vec2 last;
+        for (int x = 0; x < size.x; x++) {
+            double y = std::sin((x + frame) * 0.1) * (size.y / 2 - 1) + size.y / 2;
+            tuim::vec2 point(x, static_cast<int>(y));
+            if (x > 0) plot.DrawLine(last, point);
+            last = point;
+        }
+        frame++;
+
+        tuim::Canvas(plot);
+        tuim::Print("\n");
+        tuim::Canvas(shapes);
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
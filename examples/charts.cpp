@@ -0,0 +1,44 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - charts");
+    tuim::SetFramerate(20.f);
+
+    // A static series of samples, and a ring buffer that only keeps the latest samples.
+    std::vector<float> samples(500000);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = std::sin(i * 0.0001) * 50 + std::sin(i * 0.01) * 10 + (i % 9973 == 0 ? 40 : 0);
+    tuim::SeriesBuffer series(200000);
+    size_t pushed = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // Appending a sample is O(1), the chart reads the summaries of whole blocks of samples.
+        for (int i = 0; i < 2000; i++, pushed++)
+            series.Push(std::sin(pushed * 0.0005) * 20 + (pushed % 777) * 0.01f);
+
+        tuim::Print("Extremes of each column:\n");
+        tuim::LineChart("#minmax", samples, tuim::vec2(60, 8), tuim::CHART_FLAGS_NONE, tuim::Color(0x55, 0xAA, 0xFF));
+        tuim::Print("LTTB:\n");
+        tuim::LineChart("#lttb", samples, tuim::vec2(60, 8), tuim::CHART_FLAGS_LTTB, tuim::Color(0xFF, 0xAA, 0x55));
+        tuim::Print("Ring buffer ({} samples):\n", series.GetSize());
+        tuim::LineChart("#ring", series, tuim::vec2(60, 6), tuim::CHART_FLAGS_HALF_BLOCK);
+        tuim::Sparkline(series, 60, tuim::Color(0x55, 0xFF, 0x55));
+        tuim::Print("\n");
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - dashboard");
+    tuim::SetFramerate(30.f);
+
+    // Each panel has a version that is increased when its content changes.
+    uint64_t versions[3] = { 0, 0, 0 };
+    int counters[3] = { 0, 0, 0 };
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        tuim::Print("Press a button to change its panel, the other panels are not built again.\n");
+
+        // The content of a panel is only built when its version changes or when it is hovered,
+        // otherwise the cells of the last frames are drawn again.
+        for (int i = 0; i < 3; i++) {
+            std::string id = std::format("#panel-{}", i);
+            if (tuim::BeginCachedContainer(id, "", tuim::vec2(30, 22), versions[i])) {
+                if (tuim::Button(id + "-button", std::format("Panel {}", i + 1))) {
+                    counters[i]++;
+                    versions[i]++;
+                }
+                tuim::Print("\n");
+                for (int line = 0; line < 18; line++)
+                    tuim::Print("{:>3} x {:>3} = {:>6}\n", line + 1, counters[i], (line + 1) * counters[i]);
+            }
+            tuim::EndContainer();
+            tuim::SetCurrentCursor(tuim::vec2((i + 1) * 31, 1));
+        }
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - editor");
+    tuim::SetFramerate(10.f);
+
+    // Load the file given as argument, edits never copy the whole text.
+    tuim::TextBuffer buffer("Press enter to edit the text and escape to stop.\nCtrl+Z and Ctrl+Y undo and redo the changes.\n");
+    if (argc > 1)
+        buffer.LoadFile(argv[1]);
+    size_t changes = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // Display a multi-line editor, only the visible lines are drawn.
+        if (tuim::TextEditor("#editor", buffer, tuim::vec2(80, 20))) {
+            changes++;
+        }
+        tuim::Print("\nLine {}/{}, {} changes\n", buffer.GetLineOfOffset(buffer.m_Cursor) + 1, buffer.GetLineCount(), changes);
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - image");
+    tuim::SetFramerate(10.f);
+
+    // Load the file given as argument, or generate a gradient, the pixels are converted to cells only once.
+    tuim::ImageData images[3];
+    std::string path = (argc > 1 ? argv[1] : "");
+    const tuim::ImageFlags flags[3] = { tuim::IMAGE_FLAGS_NONE, tuim::IMAGE_FLAGS_256_COLORS, tuim::IMAGE_FLAGS_16_COLORS };
+    for (int i = 0; i < 3; i++) {
+        if (!path.empty() && images[i].LoadPPM(path, tuim::vec2(40, 0), flags[i]))
+            continue;
+
+        std::vector<uint8_t> pixels(256 * 128 * 3);
+        for (int y = 0; y < 128; y++) {
+            for (int x = 0; x < 256; x++) {
+                uint8_t* pixel = &pixels[(y * 256 + x) * 3];
+                pixel[0] = x;
+                pixel[1] = y * 2;
+                pixel[2] = 255 - x;
+            }
+        }
+        images[i].SetPixels(pixels.data(), tuim::vec2(256, 128), tuim::vec2(40, 0), flags[i]);
+    }
+
+    // Lines of text are parsed once as well, as long as they do not change.
+    std::vector<std::string> art = {
+        " /\\_/\\ ",
+        "( o.o )",
+        " > ^ < "
+    };
+    int selected = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        tuim::Print("Truecolor, 256 colors and 16 colors (press enter on the cat to switch).\n");
+        tuim::Image("#picture", images[selected]);
+        if (tuim::Image("#cat", art, tuim::IMAGE_FLAGS_CLICKABLE))
+            selected = (selected + 1) % 3;
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
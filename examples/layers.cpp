@@ -0,0 +1,70 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - layers");
+    tuim::SetFramerate(10.f);
+
+    bool showMenu = false;
+    bool showModal = false;
+    std::string choice = "none";
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // The content of the screen is drawn in the base layer, as usual.
+        tuim::Print("Choice: {}\n", choice);
+        if (tuim::Button("#menu", "Open menu"))
+            showMenu = !showMenu;
+        tuim::Print("\n");
+        if (tuim::Button("#quit", "Quit"))
+            showModal = true;
+        tuim::Print("\n");
+        for (int i = 0; i < 15; i++)
+            tuim::Print("Some content below the popups ({})\n", i + 1);
+
+        // The menu is drawn over the content, next to its button.
+        if (showMenu) {
+            tuim::BeginLayer(tuim::LAYER_POPUP);
+            tuim::SetCurrentCursor(tuim::vec2(16, 1));
+            tuim::BeginContainer("#menu-popup", "", tuim::vec2(14, 5));
+            for (const char* option : { "First", "Second", "Third" }) {
+                if (tuim::Button(std::format("#menu-{}", option), option)) {
+                    choice = option;
+                    showMenu = false;
+                }
+                tuim::Print("\n");
+            }
+            tuim::EndContainer();
+            tuim::EndLayer();
+        }
+
+        // While the modal is open, only its buttons can be navigated to.
+        if (showModal) {
+            tuim::BeginLayer(tuim::LAYER_MODAL);
+            tuim::SetCurrentCursor(tuim::vec2(10, 6));
+            tuim::BeginContainer("#modal", "", tuim::vec2(26, 6));
+            tuim::Print("Do you want to quit?\n\n");
+            if (tuim::Button("#modal-yes", "Yes"))
+                keyCode = tuim::Key::F1;
+            tuim::Print("\n");
+            if (tuim::Button("#modal-no", "No"))
+                showModal = false;
+            tuim::EndContainer();
+            tuim::EndLayer();
+        }
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - layout");
+    tuim::SetFramerate(10.f);
+
+    using tuim::LayoutSize;
+    size_t selected = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // The sizes are only solved again when the terminal is resized.
+        tuim::BeginLayout("#main", { LayoutSize::Fixed(1), LayoutSize::Flex(), LayoutSize::Fixed(1) }, tuim::LAYOUT_FLAGS_COLUMN);
+
+        tuim::NextLayoutCell();
+        tuim::Print("Header (resize the terminal)");
+
+        // A sidebar between 20 and 30 characters, the content takes the rest.
+        if (tuim::NextLayoutCell()) {
+            tuim::BeginLayout("#body", { LayoutSize::Percent(25).Clamp(20, 30), LayoutSize::Flex() }, tuim::LAYOUT_FLAGS_NONE, tuim::vec2(0, 0), 1);
+            if (tuim::NextLayoutCell(tuim::CONTAINER_FLAGS_NONE)) {
+                for (size_t i = 0; i < 5; i++)
+                    tuim::Print("{} Item {}\n", i == selected ? ">" : " ", i + 1);
+            }
+
+            // The content is a grid of panels with the same size.
+            if (tuim::NextLayoutCell()) {
+                tuim::BeginGrid("#panels", { LayoutSize::Flex(), LayoutSize::Flex() }, { LayoutSize::Flex(), LayoutSize::Flex() });
+                for (int i = 0; tuim::NextLayoutCell(tuim::CONTAINER_FLAGS_NONE); i++)
+                    tuim::Print("Panel {} of item {}", i + 1, selected + 1);
+                tuim::EndLayout();
+            }
+            tuim::EndLayout();
+        }
+
+        tuim::NextLayoutCell();
+        tuim::Print("UP/DOWN to change the item, F1 to quit");
+        tuim::EndLayout();
+
+        if (tuim::IsKeyPressed(tuim::Key::UP)) selected = (selected + 4) % 5;
+        if (tuim::IsKeyPressed(tuim::Key::DOWN)) selected = (selected + 1) % 5;
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - log view");
+    tuim::SetFramerate(10.f);
+
+    // Map the file given as argument, its lines are indexed in the background.
+    std::string path = (argc > 1 ? argv[1] : "/var/log/syslog");
+    tuim::LogFile log;
+    bool opened = log.Open(path);
+    size_t selected = 0;
+
+    // The matches of the query are searched in the background while typing.
+    tuim::TextSearch search;
+    std::string query = "";
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        if (!opened) {
+            tuim::Print("&bCannot open {}&r\n", path);
+        }
+        else {
+            tuim::Print("&b{}&r ({} lines{})\n", path, log.m_LineCount, log.IsIndexing() ? ", indexing..." : "");
+
+            // Jump to the next match when enter is pressed in the search input, long queries scroll within 30 columns.
+            if (tuim::TextInput("#search", "Search: {}", &query, tuim::INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER, 30)) {
+                size_t index = search.FindMatch(selected + 1);
+                if (index < search.GetMatchCount())
+                    selected = search.GetMatch(index).m_Line;
+            }
+            search.Search(log, query, tuim::TEXT_SEARCH_FLAGS_IGNORE_CASE);
+            tuim::Print(" {} matches{}\n", search.GetMatchCount(), search.IsSearching() ? "..." : "");
+
+            // Only the visible lines are read from the file, the view follows the lines appended to it.
+            tuim::LogView("#log", log, tuim::vec2(100, 30), &selected, tuim::LOG_VIEW_FLAGS_FOLLOW, &search);
+        }
+
+        tuim::Display();
+    }
+
+    // The search reads the file in the background, it has to be stopped before the file is closed.
+    search.Cancel();
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - mouse");
+    tuim::SetFramerate(30.f);
+
+    // The mouse is reported once enabled, it hovers the items, clicks press them and the wheel scrolls lists.
+    tuim::SetMouseEnabled(true);
+    int clicks = 0;
+    bool checked = false;
+    size_t selected = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        const tuim::MouseEvent& mouse = tuim::GetMouseEvent();
+        tuim::Print("Mouse at {},{} (F1 to quit)\n", mouse.m_Pos.x, mouse.m_Pos.y);
+
+        if (tuim::Button("#button", std::format("Clicked {} times", clicks)))
+            clicks++;
+        tuim::Print("\n");
+        tuim::Checkbox("#checkbox", "Checked", &checked);
+        tuim::Print("\n");
+
+        tuim::ScrollList("#list", tuim::vec2(30, 12), &selected, 1000, [](size_t index, bool highlighted) {
+            if (highlighted) tuim::Print("&n> Row {}&r", index + 1);
+            else tuim::Print("  Row {}", index + 1);
+        });
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks (the mouse reporting is disabled as well).
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - navigation");
+    tuim::SetFramerate(10.f);
+
+    // The arrows move the focus to the nearest item in their direction.
+    tuim::SetSpatialNavigation(tuim::NAVIGATION_FLAGS_VERTICAL | tuim::NAVIGATION_FLAGS_HORIZONTAL);
+    int volume = 5;
+    std::string pressed = "none";
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        tuim::Print("Move with the arrows, pressed: {}\n", pressed);
+
+        // Buttons in three columns, drawn column by column.
+        using tuim::LayoutSize;
+        tuim::BeginLayout("#columns", { LayoutSize::Fixed(16), LayoutSize::Fixed(16), LayoutSize::Fixed(16) }, tuim::LAYOUT_FLAGS_NONE, tuim::vec2(0, 8));
+        for (int column = 0; column < 3; column++) {
+            tuim::NextLayoutCell(tuim::CONTAINER_FLAGS_NONE);
+            for (int row = 0; row < column + 4; row++) {
+                std::string label = std::format("{}-{}", char('A' + column), row + 1);
+                if (tuim::Button("#button-" + label, label))
+                    pressed = label;
+                tuim::Print("\n");
+            }
+        }
+        tuim::EndLayout();
+
+        // The slider keeps LEFT/RIGHT for its value while it is hovered.
+        tuim::IntSlider("#volume", "Volume: {}", &volume, 0, 10, 1, 20);
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
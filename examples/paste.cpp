@@ -0,0 +1,38 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings (the bracketed paste is enabled with the context).
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - paste");
+    tuim::SetFramerate(30.f);
+
+    std::string line = "";
+    tuim::TextBuffer buffer("Paste a text here, it is inserted at once and undone with a single Ctrl+Z.\n");
+    size_t pasted = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // A paste comes as a single key, its text stays valid until the next poll.
+        if (keyCode == tuim::Key::PASTE)
+            pasted = tuim::GetPastedText().size();
+        tuim::Print("Last paste: {} bytes (F1 to quit)\n", pasted);
+
+        // The line breaks of a paste are removed in a single line input.
+        tuim::TextInput("#line", "Line: {}", &line, tuim::INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER, 60);
+        tuim::Print("\n");
+        tuim::TextEditor("#editor", buffer, tuim::vec2(80, 20));
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
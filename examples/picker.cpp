@@ -0,0 +1,45 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - picker");
+    tuim::SetFramerate(30.f);
+
+    // Generate a large amount of host names to pick from.
+    const char* roles[] = { "web", "db", "cache", "queue", "api", "worker" };
+    const char* regions[] = { "par", "fra", "nyc", "sfo", "tok", "syd" };
+    std::vector<std::string> hosts;
+    for (size_t i = 0; i < 200000; i++)
+        hosts.push_back(std::format("{}-{:03}.{}.example.com", roles[i % 6], (i * 7919) % 1000, regions[(i / 6) % 6]));
+
+    // The entries are scored against the query on background threads.
+    tuim::FuzzyFilter filter;
+    filter.SetEntries(hosts);
+    size_t selected = 0;
+    std::string picked = "";
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        tuim::Print("Press ENTER to type a query, then ENTER again to pick the selected host.\n");
+
+        // Typing more characters only scores the previous matches again.
+        if (tuim::FuzzyPicker("#hosts", filter, tuim::vec2(50, 15), &selected))
+            picked = filter.GetMatch(selected);
+        tuim::Print("\n{} matches{}\n", filter.GetMatchCount(), filter.IsBusy() ? "..." : "");
+        tuim::Print("Picked: {}\n", picked);
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - scrolling");
+    tuim::SetFramerate(1.f);
+
+    // Only the visible rows of the list are built, so the number of rows does not matter.
+    size_t rowCount = 1000000;
+    size_t selected = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        tuim::Print("Use UP/DOWN, PAGE_UP/PAGE_DOWN and HOME/END to scroll.\n");
+
+        // Display a scrollable list that calls the lambda for each visible row.
+        tuim::ScrollList("#list", tuim::vec2(40, 12), &selected, rowCount, [](size_t index, bool highlighted) {
+            if (highlighted) tuim::Print("&n> Row {}&r", index + 1);
+            else tuim::Print("  Row {}", index + 1);
+        });
+        tuim::Print("\nSelected: {}\n", selected + 1);
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - table");
+    tuim::SetFramerate(10.f);
+
+    // Fill the table with a large amount of rows, they are stored by column.
+    tuim::TableData data;
+    data.AddColumn("PID", 8, tuim::TABLE_COLUMN_FLAGS_NUMERIC);
+    data.AddColumn("Name", 16);
+    data.AddColumn("Memory", 0, tuim::TABLE_COLUMN_FLAGS_NUMERIC);
+    for (size_t i = 0; i < 500000; i++) {
+        data.AddRow({
+            std::to_string(i + 1),
+            std::format("process-{}", (i * 7919) % 1000),
+            std::to_string((i * 104729) % 65536)
+        });
+    }
+
+    std::string filter = "";
+    size_t selected = 0;
+    int sortColumn = -1;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        // Sorting and filtering run in the background, the table keeps displaying the previous rows meanwhile.
+        if (tuim::IsKeyPressed(tuim::Key::F2)) {
+            sortColumn = (sortColumn + 2) % 4 - 1;
+            data.Sort(sortColumn, sortColumn != 2);
+        }
+        if (tuim::TextInput("#filter", "Filter: {}", &filter, tuim::INPUT_TEXT_FLAGS_NONE)) {
+            data.Filter(filter);
+        }
+        tuim::Print("\n");
+
+        tuim::Table("#table", data, tuim::vec2(40, 15), &selected);
+        tuim::Print("\n{} rows, sorted by column {} (F2) {}\n", data.GetDisplayedRowCount(), sortColumn, data.IsBusy() ? "..." : "");
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
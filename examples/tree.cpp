@@ -0,0 +1,48 @@
+#include "../tuim.hpp"
+
+int main(int argc, char* argv[]) {
+
+    // Setup tuim settings.
+    tuim::CreateContext(argc, argv);
+    tuim::SetTitle("tuim - tree");
+    tuim::SetFramerate(10.f);
+
+    // The children of a node are only listed when it is expanded, on a background thread.
+    // Here, each group holds a hundred thousand metrics made of a few values.
+    tuim::TreeData tree([](uint64_t id, std::vector<tuim::TreeItem>& children) {
+        if (id == 0) {
+            for (uint64_t i = 0; i < 10; i++)
+                children.push_back({ i + 1, std::format("group-{}", i), true });
+        }
+        else if (id <= 10) {
+            for (uint64_t i = 0; i < 100000; i++)
+                children.push_back({ (id << 32) | i, std::format("metric-{}", i), true });
+        }
+        else {
+            for (const char* name : { "min", "max", "average", "count" })
+                children.push_back({ 0, name, false });
+        }
+    });
+    size_t selected = 0;
+
+    // Start the main loop.
+    char32_t keyCode = 0;
+    while (keyCode != tuim::Key::F1) {
+        keyCode = tuim::PollKeyCode();
+        tuim::Update(keyCode);
+        tuim::Clear();
+
+        tuim::Print("Use RIGHT/LEFT to expand and collapse nodes, ENTER to toggle them.\n");
+
+        // Only the visible rows are drawn, whatever the number of expanded nodes.
+        tuim::Tree("#tree", tree, tuim::vec2(40, 15), &selected);
+        tuim::Print("\n{} rows{}\n", tree.GetRowCount(), tree.IsLoading() ? ", loading..." : "");
+
+        tuim::Display();
+    }
+
+    // Delete the context to avoid memory leaks.
+    tuim::DeleteContext();
+
+    return 0;
+}
@@ -7,4 +7,1256 @@ TEST_SUITE("module") {
     TEST_CASE("function") {
         
     }
-}
\ No newline at end of file
+}
+TEST_SUITE("unicode") {
+    TEST_CASE("GetGraphemeBreak") {
+        CHECK(tuim::GetGraphemeBreak(U'a') == tuim::GraphemeBreak::OTHER);
+        CHECK(tuim::GetGraphemeBreak(U'\r') == tuim::GraphemeBreak::CR);
+        CHECK(tuim::GetGraphemeBreak(U'\u0301') == tuim::GraphemeBreak::EXTEND);
+        CHECK(tuim::GetGraphemeBreak(U'\u200D') == tuim::GraphemeBreak::ZWJ);
+        CHECK(tuim::GetGraphemeBreak(U'\U0001F1EB') == tuim::GraphemeBreak::REGIONAL_INDICATOR);
+        CHECK(tuim::GetGraphemeBreak(U'\U0001F600') == tuim::GraphemeBreak::EXTENDED_PICTOGRAPHIC);
+        CHECK(tuim::GetGraphemeBreak(U'가') == tuim::GraphemeBreak::LV);
+        CHECK(tuim::GetGraphemeBreak(U'각') == tuim::GraphemeBreak::LVT);
+    }
+
+    TEST_CASE("Utf8GraphemeLength") {
+        CHECK(tuim::Utf8GraphemeLength("ab", 0) == 1);
+        CHECK(tuim::Utf8GraphemeLength("\r\n", 0) == 2);
+        CHECK(tuim::Utf8GraphemeLength("e\u0301x", 0) == 3); // combining acute accent
+        CHECK(tuim::Utf8GraphemeLength("\U0001F468\u200D\U0001F469\u200D\U0001F467", 0) == 18); // family ZWJ sequence
+        CHECK(tuim::Utf8GraphemeLength("\U0001F1EB\U0001F1F7\U0001F1E9\U0001F1EA", 0) == 8); // two flags
+        CHECK(tuim::Utf8GraphemeLength("\xFF" "a", 0) == 1); // invalid byte
+    }
+
+    TEST_CASE("Utf8FitWidth") {
+        CHECK(tuim::Utf8FitWidth("abcdef", 3) == 3);
+        CHECK(tuim::Utf8FitWidth("ab", 3) == 2);
+        CHECK(tuim::Utf8FitWidth("e\u0301x", 1) == 3); // the combining mark is kept with its character
+        CHECK(tuim::Utf8FitWidth("abc", 0) == 0);
+        CHECK(tuim::Utf8FitWidth(std::string(1 << 24, 'x') + "\u00E9", 10) == 10);
+    }
+
+    TEST_CASE("IsSameCell") {
+        // The same cluster has a different index in the pool of each frame.
+        tuim::ClusterPool previous, current;
+        previous.Intern(U"e\u0301");
+        tuim::Cell prevCell(U'a'), cell(U'a');
+        prevCell.m_Cluster = previous.Intern(U"a\u0301");
+        cell.m_Cluster = current.Intern(U"a\u0301");
+        CHECK(prevCell != cell);
+        CHECK(tuim::IsSameCell(&cell, current, &prevCell, previous));
+
+        // The same index refers to different clusters.
+        prevCell.m_Cluster = 1;
+        CHECK(prevCell == cell);
+        CHECK(!tuim::IsSameCell(&cell, current, &prevCell, previous));
+        CHECK(tuim::IsSameCell(nullptr, current, nullptr, previous));
+        CHECK(!tuim::IsSameCell(&cell, current, nullptr, previous));
+    }
+}
+
+TEST_SUITE("string") {
+    TEST_CASE("Utf8DecodeString") {
+        std::u32string chars;
+        std::vector<uint32_t> offsets;
+        tuim::Utf8DecodeString("abcdefghijklmnopqrstuvwxyz é\xFFz", chars, &offsets);
+        CHECK(chars == U"abcdefghijklmnopqrstuvwxyz é�z");
+        CHECK(offsets.size() == chars.size() + 1);
+        CHECK(offsets[27] == 27);
+        CHECK(offsets[28] == 29);
+        CHECK(offsets.back() == 31);
+    }
+
+    TEST_CASE("Utf8DecodeNext") {
+        // Overlong encodings, surrogates and values beyond U+10FFFF are replaced byte by byte.
+        const char* invalid[] = { "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xE0\x9F\xBF", "\xF0\x80\x80\xAF", "\xF0\x8F\xBF\xBF", "\xED\xA0\x80", "\xED\xBF\xBF", "\xF4\x90\x80\x80" };
+        for (const char* bytes : invalid) {
+            char32_t ch = 0;
+            CHECK(tuim::Utf8DecodeNext(bytes, 0, ch) == 1);
+            CHECK(ch == 0xFFFD);
+
+            // The bulk decoder gives the same result after a run of ASCII characters.
+            std::string text = std::string(20, 'a') + bytes;
+            std::u32string chars;
+            tuim::Utf8DecodeString(text, chars, nullptr);
+            CHECK(chars.substr(0, 21) == std::u32string(20, U'a') + U"\uFFFD");
+            CHECK(chars.find_first_not_of(U"a\uFFFD") == std::u32string::npos);
+        }
+
+        // The smallest and largest valid values of each length.
+        char32_t ch = 0;
+        CHECK(tuim::Utf8DecodeNext("\xC2\x80", 0, ch) == 2);
+        CHECK(ch == 0x80);
+        CHECK(tuim::Utf8DecodeNext("\xE0\xA0\x80", 0, ch) == 3);
+        CHECK(ch == 0x800);
+        CHECK(tuim::Utf8DecodeNext("\xEE\x80\x80", 0, ch) == 3);
+        CHECK(ch == 0xE000);
+        CHECK(tuim::Utf8DecodeNext("\xF4\x8F\xBF\xBF", 0, ch) == 4);
+        CHECK(ch == 0x10FFFF);
+    }
+
+    TEST_CASE("CalcTextMetrics") {
+        tuim::TextMetrics metrics = tuim::CalcTextMetrics("#ff0000red&r\n##tag\n");
+        CHECK(metrics.m_Width == 4);
+        CHECK(metrics.m_LineWidths == std::vector<size_t>{ 3, 4, 0 });
+    }
+
+    TEST_CASE("FindSubstring") {
+        std::string text = "the quick brown fox jumps over the lazy dog, THE END";
+        CHECK(tuim::FindSubstring(text, "the") == 0);
+        CHECK(tuim::FindSubstring(text, "the", 1) == 31);
+        CHECK(tuim::FindSubstring(text, "the", 32) == std::string_view::npos);
+        CHECK(tuim::FindSubstring(text, "the", 32, true) == 45);
+        CHECK(tuim::FindSubstring(text, "dog, the end", 0, true) == 40);
+        CHECK(tuim::FindSubstring(text, "cat") == std::string_view::npos);
+    }
+
+    TEST_CASE("IndexNewlines") {
+        std::string text = "first line\nsecond line that is longer\n\nlast";
+        std::vector<uint64_t> starts;
+        tuim::IndexNewlines(text.data(), 0, text.size(), starts);
+        CHECK(starts == std::vector<uint64_t>{ 11, 38, 39 });
+
+        starts.clear();
+        tuim::IndexNewlines(text.data(), 11, 38, starts);
+        CHECK(starts == std::vector<uint64_t>{ 38 });
+    }
+}
+
+TEST_SUITE("cache") {
+    TEST_CASE("LruCache") {
+        tuim::LruCache<int> cache(2);
+        cache.Insert("a", 1);
+        cache.Insert("b", 2);
+        CHECK(*cache.Find("a") == 1);
+
+        // "b" is the least recently used entry, it is evicted first.
+        cache.Insert("c", 3);
+        CHECK(cache.Find("b") == nullptr);
+        CHECK(*cache.Find("a") == 1);
+        CHECK(*cache.Find("c") == 3);
+        CHECK(cache.m_Hits == 3);
+        CHECK(cache.m_Misses == 1);
+
+        // Inserting an existing key replaces its value without evicting anything.
+        cache.Insert("a", 4);
+        CHECK(cache.m_Entries.size() == 2);
+        CHECK(*cache.Find("a") == 4);
+
+        cache.SetCapacity(1);
+        CHECK(cache.m_Entries.size() == 1);
+        CHECK(cache.Find("c") == nullptr);
+    }
+
+    TEST_CASE("TextCache") {
+        tuim::TextCache cache(8);
+        const tuim::TextMetrics& metrics = cache.Get("ab\n\u00e9cde\n");
+        CHECK(metrics.m_LineWidths.size() == 3);
+        CHECK(metrics.m_LineStarts == std::vector<size_t>{ 0, 3, 9 });
+        CHECK(&cache.Get("ab\n\u00e9cde\n") == &metrics);
+        CHECK(cache.m_Hits == 1);
+        CHECK(cache.m_Misses == 1);
+    }
+}
+
+TEST_SUITE("paragraph") {
+    // Returns the words of each line of a paragraph, separated by '|'.
+    std::string BreakLines(std::string_view text, uint width, tuim::ParagraphFlags flags) {
+        tuim::ParagraphLayout layout;
+        layout.m_Words = tuim::TokenizeParagraph(text);
+        layout.m_Width = width;
+        layout.m_Flags = flags;
+        tuim::BreakParagraph(layout);
+
+        std::string lines;
+        for (const tuim::ParagraphLayout::Line& line : layout.m_Lines) {
+            if (!lines.empty())
+                lines += '|';
+            for (size_t w = line.m_First; w < line.m_Last; w++) {
+                const tuim::ParagraphLayout::Word& word = layout.m_Words[w];
+                lines += std::string(text.substr(word.m_Offset, word.m_Length)) + (w + 1 < line.m_Last ? " " : "");
+            }
+        }
+        return lines;
+    }
+
+    TEST_CASE("TokenizeParagraph") {
+        std::vector<tuim::ParagraphLayout::Word> words = tuim::TokenizeParagraph("a  #ff0000bc\nd");
+        CHECK(words.size() == 3);
+        CHECK(words[1].m_Offset == 3);
+        CHECK(words[1].m_Width == 2);
+        CHECK(words[1].m_LineBreak);
+    }
+
+    TEST_CASE("BreakParagraph") {
+        // Greedy fit fills each line, optimal fit balances them.
+        CHECK(BreakLines("aaa bb cc ddddd", 6, tuim::PARAGRAPH_FLAGS_NONE) == "aaa bb|cc|ddddd");
+        CHECK(BreakLines("aaa bb cc ddddd", 6, tuim::PARAGRAPH_FLAGS_OPTIMAL_FIT) == "aaa|bb cc|ddddd");
+
+        // Line breaks end a block in both modes.
+        CHECK(BreakLines("a b\nc d", 10, tuim::PARAGRAPH_FLAGS_NONE) == "a b|c d");
+        CHECK(BreakLines("a b\nc d", 10, tuim::PARAGRAPH_FLAGS_OPTIMAL_FIT) == "a b|c d");
+
+        // A word wider than the line is left alone on its own line.
+        CHECK(BreakLines("a wordtoolong b", 5, tuim::PARAGRAPH_FLAGS_NONE) == "a|wordtoolong|b");
+        CHECK(BreakLines("a wordtoolong b", 5, tuim::PARAGRAPH_FLAGS_OPTIMAL_FIT) == "a|wordtoolong|b");
+
+        // Only the lines that are not the last of a block are justified.
+        tuim::ParagraphLayout layout;
+        layout.m_Words = tuim::TokenizeParagraph("aaa bb cc\ndd ee");
+        layout.m_Width = 6;
+        layout.m_Flags = tuim::PARAGRAPH_FLAGS_NONE;
+        tuim::BreakParagraph(layout);
+        CHECK(layout.m_Lines.size() == 3);
+        CHECK(layout.m_Lines[0].m_Justified);
+        CHECK(!layout.m_Lines[1].m_Justified);
+        CHECK(!layout.m_Lines[2].m_Justified);
+        CHECK(layout.m_Lines[0].m_Width == 6);
+    }
+}
+
+TEST_SUITE("drawing") {
+    // Returns the characters of a row of the current frame.
+    std::u32string GetRow(int y, int width) {
+        std::u32string row;
+        for (int x = 0; x < width; x++) {
+            std::shared_ptr<tuim::Cell> cell = tuim::GetCtx()->m_Frame->Get(x, y);
+            row += (cell != nullptr ? cell->m_Character : U'.');
+        }
+        return row;
+    }
+
+    TEST_CASE("Display") {
+        tuim::ctx = new tuim::Context();
+        int lastRow = tuim::Terminal::GetTerminalSize().y - 1;
+        auto DisplayFrame = [&](const std::string& bottom) {
+            tuim::Clear();
+            tuim::Print("top line");
+            tuim::SetCurrentCursor(tuim::vec2(0, lastRow));
+            tuim::Print(bottom);
+
+            std::ostringstream output;
+            std::streambuf* buffer = std::cout.rdbuf(output.rdbuf());
+            tuim::Display();
+            std::cout.rdbuf(buffer);
+            return output.str();
+        };
+
+        // The last row is not erased when it has not changed since the previous frame.
+        DisplayFrame("bottom line");
+        std::string output = DisplayFrame("bottom line");
+        CHECK(output.find("line") == std::string::npos);
+        CHECK(output.find("\033[0J") == std::string::npos);
+        CHECK(output.find("\033[0K") == std::string::npos);
+
+        // Only the changed end of the last row is printed, its start is kept.
+        output = DisplayFrame("bottom lane");
+        CHECK(output.find("a") != std::string::npos);
+        CHECK(output.find("bottom") == std::string::npos);
+        CHECK(output.find("\033[0J") == std::string::npos);
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("DrawText") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+        tuim::CellStyle style{ tuim::Color(0xff, 0x00, 0x00), std::nullopt, tuim::Style::NONE };
+
+        // Formatting tags are drawn as they are, line breaks go back to the first column.
+        tuim::SetCurrentCursor(tuim::vec2(1, 0));
+        tuim::DrawText("a&rb\ncd", style);
+        CHECK(GetRow(0, 6) == U".a&rb.");
+        CHECK(GetRow(1, 6) == U"cd....");
+        CHECK(tuim::GetCtx()->m_Frame->Get(1, 0)->m_Foreground == style.m_Foreground);
+
+        // The text stops before exceeding the maximum width.
+        tuim::SetCurrentCursor(tuim::vec2(0, 2));
+        tuim::DrawText("abcdef", style, 3);
+        CHECK(GetRow(2, 6) == U"abc...");
+        CHECK(tuim::GetCurrentCursor() == tuim::vec2(3, 2));
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("FillRect") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+
+        // The rectangle is filled without moving the cursor.
+        tuim::SetCurrentCursor(tuim::vec2(5, 5));
+        tuim::FillRect(tuim::vec2(1, 1), tuim::vec2(3, 2), U'#', tuim::CellStyle());
+        CHECK(GetRow(0, 5) == U".....");
+        CHECK(GetRow(1, 5) == U".###.");
+        CHECK(GetRow(2, 5) == U".###.");
+        CHECK(GetRow(3, 5) == U".....");
+        CHECK(tuim::GetCurrentCursor() == tuim::vec2(5, 5));
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("DrawBar") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+        tuim::CellStyle filled{ tuim::Color(0x00, 0xff, 0x00), std::nullopt, tuim::Style::NONE };
+        tuim::CellStyle empty{ tuim::Color(0x55, 0x55, 0x55), std::nullopt, tuim::Style::NONE };
+
+        // The first cells up to the fraction of the width have the filled style.
+        tuim::DrawBar(4, 0.5f, U'=', filled, empty);
+        CHECK(GetRow(0, 5) == U"====.");
+        CHECK(tuim::GetCtx()->m_Frame->Get(1, 0)->m_Foreground == filled.m_Foreground);
+        CHECK(tuim::GetCtx()->m_Frame->Get(2, 0)->m_Foreground == empty.m_Foreground);
+        CHECK(tuim::GetCurrentCursor() == tuim::vec2(4, 0));
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+}
+
+// Returns the character of a cell of the current frame ('.' if it is empty).
+char32_t GetChar(int x, int y) {
+    std::shared_ptr<tuim::Cell> cell = tuim::GetCtx()->m_Frame->Get(x, y);
+    return (cell != nullptr ? cell->m_Character : U'.');
+}
+
+TEST_SUITE("containers") {
+    TEST_CASE("ClippedContainers") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+
+        // The content of the outer container (8x3 inside its border) is clipped to its width.
+        CHECK(tuim::BeginContainer("#outer", "", tuim::vec2(10, 5)));
+        tuim::Print("0123456789\n");
+        CHECK(GetChar(8, 1) == U'7');
+        CHECK(GetChar(9, 1) != U'8');
+
+        // A nested container partially outside of its parent is clipped to the parent content area.
+        tuim::SetCurrentCursor(tuim::vec2(4, 1));
+        CHECK(tuim::BeginContainer("#inner", "", tuim::vec2(6, 4)));
+        tuim::Print("xyzxyz\nXYZ");
+        tuim::EndContainer();
+        CHECK(GetChar(6, 3) == U'x');
+        CHECK(GetChar(8, 3) == U'z');
+        CHECK(GetChar(9, 3) != U'x');
+        CHECK(GetChar(6, 4) != U'X');
+        tuim::EndContainer();
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("CulledContainers") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+        CHECK(tuim::BeginContainer("#outer", "", tuim::vec2(10, 5)));
+
+        // A nested container outside of its parent is culled, its content is not drawn but its item is kept.
+        tuim::SetCurrentCursor(tuim::vec2(20, 0));
+        CHECK(!tuim::BeginContainer("#hidden", "", tuim::vec2(4, 3)));
+        tuim::Print("hidden");
+        tuim::EndContainer();
+        tuim::EndContainer();
+        for (int x = 0; x < 30; x++)
+            CHECK(GetChar(x, 0) != U'h');
+        CHECK(tuim::GetCtx()->m_Items.contains(tuim::StringToId("#hidden")));
+        CHECK(tuim::GetCtx()->m_Items.at(tuim::StringToId("#hidden"))->m_Size == tuim::vec2(4, 3));
+
+        // A container below the screen is culled as well.
+        tuim::SetCurrentCursor(tuim::vec2(0, 30));
+        CHECK(!tuim::BeginContainer("#below", "", tuim::vec2(4, 3)));
+        tuim::EndContainer();
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("CachedContainers") {
+        tuim::ctx = new tuim::Context();
+        bool first = false;
+        bool second = false;
+        bool built = false;
+        auto Frame = [&](char32_t keyCode) {
+            tuim::Update(keyCode);
+            tuim::Clear();
+            built = tuim::BeginCachedContainer("#panel", "", tuim::vec2(12, 3), 1);
+            if (built)
+                tuim::Checkbox("#first", "first", &first);
+            tuim::EndContainer();
+            tuim::Checkbox("#second", "second", &second);
+        };
+
+        // The content is built while it is hovered.
+        Frame(0);
+        Frame(0);
+        CHECK(built);
+        CHECK(GetChar(2, 1) == U'x');
+
+        // Once the focus leaves, the content is built once more without the hover highlight, then reused.
+        Frame(tuim::Key::DOWN);
+        CHECK(tuim::GetCtx()->m_HoveredItemId == tuim::StringToId("#second"));
+        CHECK(built);
+        CHECK(GetChar(2, 1) == U' ');
+        Frame(0);
+        CHECK_FALSE(built);
+        CHECK(GetChar(2, 1) == U' ');
+        CHECK(GetChar(5, 1) == U'f');
+
+        // The reused items can still be navigated to, which builds the content again.
+        Frame(tuim::Key::UP);
+        CHECK(built);
+        CHECK(GetChar(2, 1) == U'x');
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("ScrollNavigate") {
+        tuim::ScrollState state;
+        state.m_RowCount = 25;
+        state.m_VisibleRows = 10;
+
+        // Pages move by the number of visible rows and stop at both ends of the list.
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::PAGE_DOWN));
+        CHECK(state.m_Selected == 10);
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::PAGE_DOWN));
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::PAGE_DOWN));
+        CHECK(state.m_Selected == 24);
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::PAGE_UP));
+        CHECK(state.m_Selected == 14);
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::PAGE_UP));
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::PAGE_UP));
+        CHECK(state.m_Selected == 0);
+
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::END));
+        CHECK(state.m_Selected == 24);
+        CHECK(tuim::ScrollNavigate(state, tuim::Key::HOME));
+        CHECK(state.m_Selected == 0);
+
+        // UP on the first row and DOWN on the last one leave the list.
+        CHECK(!tuim::ScrollNavigate(state, tuim::Key::UP));
+        CHECK(state.m_Selected == 0);
+        state.m_Selected = 24;
+        CHECK(!tuim::ScrollNavigate(state, tuim::Key::DOWN));
+        CHECK(state.m_Selected == 24);
+
+        // Empty lists never handle a key.
+        tuim::ScrollState empty;
+        CHECK(!tuim::ScrollNavigate(empty, tuim::Key::PAGE_DOWN));
+        CHECK(!tuim::ScrollNavigate(empty, tuim::Key::END));
+    }
+
+    TEST_CASE("ScrollList") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+
+        // Only the visible rows are built, the view follows the selected row to the end of the list.
+        size_t selected = 999;
+        std::vector<size_t> rows;
+        tuim::ScrollList("#list", tuim::vec2(20, 6), &selected, 1000, [&](size_t index, bool) { rows.push_back(index); });
+        CHECK(!rows.empty());
+        CHECK(rows.size() <= 6);
+        CHECK(rows.back() == 999);
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+}
+
+TEST_SUITE("layers") {
+    TEST_CASE("ComposeLayers") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+        tuim::Print("0123456789\n0123456789\n0123456789");
+
+        // The containers of a layer hide the base below them, even where nothing is drawn.
+        tuim::BeginLayer(tuim::LAYER_POPUP);
+        tuim::SetCurrentCursor(tuim::vec2(2, 0));
+        tuim::BeginContainer("#popup", "", tuim::vec2(5, 3));
+        tuim::Print("P");
+        tuim::EndContainer();
+        tuim::EndLayer();
+
+        // Upper layers are drawn over the lower ones, only where they have cells.
+        tuim::BeginLayer(tuim::LAYER_TOOLTIP);
+        tuim::SetCurrentCursor(tuim::vec2(3, 1));
+        tuim::Print("T");
+        tuim::SetCurrentCursor(tuim::vec2(0, 2));
+        tuim::Print("t");
+        tuim::EndLayer();
+        tuim::ComposeLayers();
+
+        CHECK(GetChar(1, 0) == U'1');
+        CHECK(GetChar(2, 0) == U'+');
+        CHECK(GetChar(3, 0) == U'-');
+        CHECK(GetChar(2, 1) == U'|');
+        CHECK(GetChar(3, 1) == U'T');
+        CHECK(GetChar(4, 1) == U'.');
+        CHECK(GetChar(7, 1) == U'7');
+        CHECK(GetChar(0, 2) == U't');
+        CHECK(GetChar(1, 2) == U'1');
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("CulledLayers") {
+        tuim::ctx = new tuim::Context();
+        bool popup = true;
+        bool drawn = false;
+        auto Frame = [&]() {
+            tuim::Clear();
+            drawn = tuim::BeginContainer("#base", "", tuim::vec2(10, 4));
+            if (drawn)
+                tuim::Print("base");
+            tuim::EndContainer();
+            if (popup) {
+                tuim::BeginLayer(tuim::LAYER_POPUP);
+                tuim::BeginContainer("#popup", "", tuim::vec2(12, 6));
+                tuim::Print("popup");
+                tuim::EndContainer();
+                tuim::EndLayer();
+            }
+
+            std::ostringstream output;
+            std::streambuf* buffer = std::cout.rdbuf(output.rdbuf());
+            tuim::Display();
+            std::cout.rdbuf(buffer);
+            return output.str();
+        };
+
+        // The base container is drawn until the popup is known to cover it.
+        Frame();
+        CHECK(drawn);
+        tuim::Frame* layer = tuim::GetCtx()->m_Layers[tuim::LAYER_POPUP].get();
+        Frame();
+        CHECK_FALSE(drawn);
+        CHECK(GetChar(1, 1) == U'p');
+        CHECK(tuim::GetCtx()->m_Layers[tuim::LAYER_POPUP].get() == layer); // the frame of the layer is reused
+
+        // The frame in which the popup is closed is not displayed, the next one draws the base container again.
+        popup = false;
+        CHECK(Frame().empty());
+        CHECK_FALSE(drawn);
+        std::string output = Frame();
+        CHECK(drawn);
+        CHECK(output.find("base") != std::string::npos);
+        CHECK(GetChar(1, 1) == U'b');
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("ModalFocus") {
+        tuim::ctx = new tuim::Context();
+        bool value = false;
+        bool modal = true;
+        auto Frame = [&](char32_t keyCode) {
+            tuim::Update(keyCode);
+            tuim::Clear();
+            tuim::Checkbox("#base", "base", &value);
+            tuim::Print("\n");
+            if (modal) {
+                tuim::BeginLayer(tuim::LAYER_MODAL);
+                tuim::SetCurrentCursor(tuim::vec2(0, 5));
+                tuim::Checkbox("#first", "first", &value);
+                tuim::Print("\n");
+                tuim::Checkbox("#second", "second", &value);
+                tuim::EndLayer();
+            }
+            tuim::ComposeLayers();
+        };
+        tuim::ItemId& hovered = tuim::GetCtx()->m_HoveredItemId;
+
+        // The focus goes to the modal layer and cannot leave it.
+        Frame(0);
+        Frame(0);
+        CHECK(hovered == tuim::StringToId("#first"));
+        Frame(tuim::Key::UP);
+        CHECK(hovered == tuim::StringToId("#first"));
+        Frame(tuim::Key::DOWN);
+        Frame(tuim::Key::DOWN);
+        CHECK(hovered == tuim::StringToId("#second"));
+
+        // The items below the modal layer cannot be clicked either.
+        tuim::GetCtx()->m_MouseEvent = { tuim::vec2(5, 0), tuim::MOUSE_ACTION_PRESS, tuim::MOUSE_BUTTON_LEFT };
+        Frame(tuim::Key::MOUSE);
+        CHECK(hovered == tuim::StringToId("#second"));
+        CHECK_FALSE(value);
+
+        // Once the modal layer is closed, the base items can be navigated to again.
+        modal = false;
+        Frame(0);
+        Frame(0);
+        CHECK(hovered == tuim::StringToId("#base"));
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+}
+
+TEST_SUITE("table") {
+    TEST_CASE("TableData") {
+        tuim::TableData data;
+        data.AddColumn("Id", 0, tuim::TABLE_COLUMN_FLAGS_NUMERIC);
+        data.AddColumn("Name");
+        data.AddRow({ "10", "b" });
+        data.AddRow({ "9", "a" });
+        data.AddRow({ "100", "b" });
+        CHECK(data.m_Rows == std::vector<uint32_t>{ 0, 1, 2 });
+        CHECK(data.m_Columns[0].m_MaxWidth == 3);
+
+        data.Sort(0);
+        data.Wait();
+        CHECK(data.Poll());
+        CHECK(data.m_Rows == std::vector<uint32_t>{ 1, 0, 2 });
+
+        data.Sort(1, false);
+        data.Wait();
+        data.Poll();
+        CHECK(data.m_Rows == std::vector<uint32_t>{ 0, 2, 1 }); // equal cells keep their insertion order
+
+        data.Filter("b");
+        data.Wait();
+        data.Poll();
+        CHECK(data.m_Rows == std::vector<uint32_t>{ 0, 2 });
+    }
+
+    TEST_CASE("TableDataAddRows") {
+        tuim::TableData data;
+        data.AddColumn("Value", 0, tuim::TABLE_COLUMN_FLAGS_NUMERIC);
+        for (int i = 0; i < 10; i++)
+            data.AddRow({ std::to_string((i * 7) % 10) });
+
+        // The rows added while a sort is running are stored once its result is swapped in, instead of discarding it.
+        int applied = 0;
+        for (int i = 0; i < 50; i++) {
+            data.Sort(0, i % 2 == 0);
+            data.AddRow({ std::to_string((i * 13) % 50) });
+            data.Wait();
+            applied += data.Poll();
+        }
+        CHECK(applied == 50);
+        CHECK(data.GetRowCount() == 60);
+        CHECK(data.GetDisplayedRowCount() == 60);
+
+        // Without a running job, the rows are inserted at their sorted position right away.
+        data.AddRow({ "25" });
+        data.AddRow({ "-1" });
+        CHECK(data.GetDisplayedRowCount() == 62);
+        for (size_t i = 1; i < data.GetDisplayedRowCount(); i++)
+            CHECK(std::stod(data.m_Columns[0].m_Cells[data.GetRow(i - 1)]) >= std::stod(data.m_Columns[0].m_Cells[data.GetRow(i)]));
+        CHECK(data.m_Columns[0].m_Cells[data.GetRow(61)] == "-1");
+    }
+}
+
+TEST_SUITE("log") {
+    // Create a temporary file containing some text, returns its path.
+    std::string WriteTempFile(std::string_view text) {
+        char path[] = "/tmp/tuim-test-XXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE(fd >= 0);
+        CHECK(write(fd, text.data(), text.size()) == (ssize_t) text.size());
+        close(fd);
+        return path;
+    }
+
+    void WaitIndexing(tuim::LogFile& log) {
+        log.Poll();
+        while (log.IsIndexing())
+            std::this_thread::yield();
+        log.Poll();
+    }
+
+    void WaitSearch(tuim::TextSearch& search, tuim::LogFile& log, std::string_view query) {
+        search.Search(log, query);
+        while (search.IsSearching())
+            std::this_thread::yield();
+    }
+
+    TEST_CASE("LogView") {
+        tuim::ctx = new tuim::Context();
+        tuim::Clear();
+
+        // A very long line is only drawn up to the width of the list.
+        std::string path = WriteTempFile("first\n" + std::string(1 << 22, 'x') + " ERROR\nlast");
+        tuim::LogFile log;
+        REQUIRE(log.Open(path));
+        WaitIndexing(log);
+        CHECK(log.GetLineCount() == 3);
+
+        size_t selected = 0;
+        tuim::LogView("#log", log, tuim::vec2(12, 5), &selected, tuim::LOG_VIEW_FLAGS_NONE);
+        for (int x = 1; x <= 10; x++)
+            CHECK(GetChar(x, 2) == U'x');
+        CHECK(GetChar(11, 2) != U'x');
+
+        log.Close();
+        std::remove(path.c_str());
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("TextSearch") {
+        std::string text;
+        for (int i = 0; i < 100; i++)
+            text += (i % 10 == 0) ? "line ERROR\n" : "line\n";
+        std::string path = WriteTempFile(text);
+        tuim::LogFile log;
+        REQUIRE(log.Open(path));
+        WaitIndexing(log);
+
+        tuim::TextSearch search;
+        WaitSearch(search, log, "ERROR");
+        CHECK(search.GetMatchCount() == 10);
+        CHECK(search.GetMatch(9).m_Line == 90);
+        CHECK(search.GetSearchedLines() == 100);
+
+        // The matches of a truncated file are searched again from its first line.
+        FILE* file = std::fopen(path.c_str(), "w");
+        std::fputs("ERROR\nERROR\nERROR\nERROR\nERROR\n", file);
+        std::fclose(file);
+        WaitIndexing(log);
+        CHECK(log.GetLineCount() == 5);
+        WaitSearch(search, log, "ERROR");
+        CHECK(search.GetMatchCount() == 5);
+        CHECK(search.GetMatch(4).m_Line == 4);
+
+        // A line without its line break is searched again when it is completed.
+        file = std::fopen(path.c_str(), "a");
+        std::fputs("partial", file);
+        std::fflush(file);
+        WaitIndexing(log);
+        WaitSearch(search, log, "ERROR");
+        CHECK(search.GetMatchCount() == 5);
+        CHECK(search.GetSearchedLines() == 5);
+
+        std::fputs(" ERROR\n", file);
+        std::fclose(file);
+        WaitIndexing(log);
+        WaitSearch(search, log, "ERROR");
+        CHECK(search.GetMatchCount() == 6);
+        CHECK(search.GetMatch(5).m_Line == 5);
+        CHECK(search.GetMatch(5).m_Offset == 8);
+        CHECK(search.GetSearchedLines() == 6);
+
+        search.Cancel();
+        log.Close();
+        std::remove(path.c_str());
+    }
+}
+
+TEST_SUITE("editor") {
+    TEST_CASE("TextBuffer") {
+        tuim::TextBuffer buffer("first\nsecond\nthird");
+        CHECK(buffer.GetLineCount() == 3);
+        CHECK(buffer.GetLineStart(1) == 6);
+        CHECK(buffer.GetLineEnd(1) == 12);
+
+        buffer.Insert(6, "new\n");
+        buffer.Erase(0, 2);
+        CHECK(buffer.GetText() == "rst\nnew\nsecond\nthird");
+        CHECK(buffer.GetLineCount() == 4);
+        CHECK(buffer.GetLineOfOffset(8) == 2);
+
+        CHECK(buffer.Undo());
+        CHECK(buffer.GetText() == "first\nnew\nsecond\nthird");
+        CHECK(buffer.Undo());
+        CHECK(buffer.GetText() == "first\nsecond\nthird");
+        CHECK_FALSE(buffer.Undo());
+        CHECK(buffer.Redo());
+        CHECK(buffer.GetText() == "first\nnew\nsecond\nthird");
+    }
+
+    TEST_CASE("TextEditor") {
+        tuim::ctx = new tuim::Context();
+        tuim::TextBuffer buffer("first\nsecond");
+        auto Frame = [&](char32_t keyCode) {
+            tuim::Update(keyCode);
+            tuim::Clear();
+            return tuim::TextEditor("#editor", buffer, tuim::vec2(20, 5));
+        };
+        Frame(0);
+        Frame(tuim::Key::ENTER);
+
+        // A paste is inserted as a single edit, undone at once.
+        tuim::GetCtx()->m_Paste = "one\ntwo\n";
+        CHECK(Frame(tuim::Key::PASTE));
+        CHECK(buffer.GetText() == "one\ntwo\nfirst\nsecond");
+        CHECK(buffer.GetLineCount() == 4);
+        CHECK(buffer.Undo());
+        CHECK(buffer.GetText() == "first\nsecond");
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("GapBuffer") {
+        tuim::GapBuffer buffer("héllo");
+        buffer.Insert(0, "> ");
+        buffer.Insert(buffer.GetSize(), "!");
+        buffer.Erase(2, 1);
+        CHECK(buffer.GetText() == "> éllo!");
+        CHECK(buffer.NextIndex(2) == 4);
+        CHECK(buffer.PrevIndex(4) == 2);
+
+        std::string range;
+        buffer.GetRange(1, 5, range);
+        CHECK(range == " éll");
+
+        CHECK(buffer.Equals("> éllo!"));
+        CHECK_FALSE(buffer.Equals("> ello!!"));
+        CHECK_FALSE(buffer.Equals("> éllo"));
+    }
+
+    TEST_CASE("TextInput") {
+        tuim::ctx = new tuim::Context();
+        std::string value = "abc";
+        std::string live = "abc";
+        bool changed = false;
+        bool liveChanged = false;
+        auto Frame = [&](char32_t keyCode) {
+            tuim::Update(keyCode);
+            tuim::Clear();
+            changed = tuim::TextInput("#input", "{}", &value, tuim::INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER, 20);
+            tuim::Print("\n");
+            liveChanged = tuim::TextInput("#live", "{}", &live, tuim::INPUT_TEXT_FLAGS_NONE, 20);
+        };
+        Frame(0);
+
+        // The value is only written once the edit is confirmed.
+        Frame(tuim::Key::ENTER);
+        Frame(U'd');
+        Frame(U'e');
+        CHECK(value == "abc");
+        Frame(tuim::Key::BACKSPACE);
+        Frame(tuim::Key::ENTER);
+        CHECK(changed);
+        CHECK(value == "abcd");
+
+        // Leaving the input keeps the edits.
+        Frame(tuim::Key::ENTER);
+        Frame(tuim::Key::HOME);
+        Frame(U'>');
+        Frame(tuim::Key::ESCAPE);
+        CHECK_FALSE(changed);
+        CHECK(value == ">abcd");
+
+        // Without confirmation, the value follows each edit.
+        Frame(tuim::Key::DOWN);
+        Frame(tuim::Key::ENTER);
+        Frame(U'!');
+        CHECK(liveChanged);
+        CHECK(live == "abc!");
+        Frame(tuim::Key::LEFT);
+        Frame(tuim::Key::BACKSPACE);
+        CHECK(live == "ab!");
+        Frame(tuim::Key::ESCAPE);
+        CHECK(live == "ab!");
+
+        // A paste is inserted at once, without its line breaks.
+        tuim::GetCtx()->m_Paste = "12\n34";
+        Frame(tuim::Key::ENTER);
+        Frame(tuim::Key::PASTE);
+        CHECK(liveChanged);
+        CHECK(live == "ab!1234");
+
+        // The value changed by the caller while the input is active is edited instead of the previous one.
+        live = "ab!12\u00E9";
+        Frame(tuim::Key::BACKSPACE);
+        CHECK(live == "ab!12");
+        Frame(U'x');
+        CHECK(live == "ab!12x");
+
+        // A new value of the same size is noticed by its address, even if it only differs far from the cursor.
+        live = std::string(20, 'a');
+        Frame(tuim::Key::HOME);
+        std::string other = std::string(19, 'a') + "b";
+        live.swap(other);
+        Frame(U'x');
+        CHECK(live == "x" + std::string(19, 'a') + "b");
+        CHECK(tuim::FindState<tuim::TextInputState>(tuim::StringToId("#live"))->m_Buffer.Equals(live));
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+}
+
+TEST_SUITE("tree") {
+    TEST_CASE("TreeData") {
+        tuim::TreeData tree([](uint64_t id, std::vector<tuim::TreeItem>& children) {
+            if (id < 10) {
+                for (uint64_t i = 0; i < 3; i++)
+                    children.push_back({ id * 10 + i + 1, std::to_string(id * 10 + i + 1), id == 0 });
+            }
+        });
+        tree.Wait();
+        CHECK(tree.Poll());
+        CHECK(tree.GetRowCount() == 3);
+
+        // The children are inserted right after their parent once loaded.
+        tree.Expand(1);
+        CHECK(tree.GetNode(1).m_Loading);
+        tree.Wait();
+        CHECK(tree.Poll());
+        CHECK(tree.GetRowCount() == 6);
+        CHECK(tree.GetNode(2).m_Item.m_Label == "21");
+        CHECK(tree.GetNode(5).m_Item.m_Label == "3");
+
+        // Loaded children are kept when collapsed.
+        tree.Collapse(1);
+        CHECK(tree.GetRowCount() == 3);
+        tree.Expand(1);
+        CHECK(tree.GetRowCount() == 6);
+        CHECK(tree.GetRow(tree.m_Rows[4]) == 4);
+    }
+}
+
+TEST_SUITE("fuzzy") {
+    TEST_CASE("FuzzyFilter") {
+        CHECK(tuim::FuzzyScore("web-01.example.com", "wez") == -1);
+        CHECK(tuim::FuzzyScore("web-01.example.com", "web") > tuim::FuzzyScore("worker-b.example.com", "web"));
+
+        tuim::FuzzyFilter filter;
+        filter.SetEntries({ "cache-01", "web-01", "web-02", "database" });
+        filter.Filter("WEB");
+        filter.Wait();
+        CHECK(filter.Poll());
+        CHECK(filter.GetMatchCount() == 2);
+        CHECK(filter.GetMatch(0) == "web-01");
+
+        // A longer query only scores the previous matches again.
+        filter.Filter("web2");
+        filter.Wait();
+        CHECK(filter.Poll());
+        CHECK(filter.GetMatchCount() == 1);
+        CHECK(filter.GetMatch(0) == "web-02");
+    }
+}
+
+TEST_SUITE("canvas") {
+    TEST_CASE("CanvasData") {
+        tuim::CanvasData canvas(tuim::vec2(9, 2));
+        canvas.SetPixel(0, 0);
+        canvas.SetPixel(1, 3);
+        canvas.DrawLine(tuim::vec2(2, 4), tuim::vec2(17, 4));
+        const std::vector<char32_t>& glyphs = canvas.GetGlyphs();
+        CHECK(glyphs[0] == 0x2881);
+        CHECK(glyphs[1] == 0);
+        for (int x = 1; x < 9; x++)
+            CHECK(glyphs[9 + x] == 0x2809);
+
+        // The shape stops the fill, which spreads everywhere else.
+        tuim::CanvasData blocks(tuim::vec2(4, 2), tuim::CANVAS_FLAGS_HALF_BLOCK);
+        blocks.DrawRect(tuim::vec2(0, 0), tuim::vec2(3, 3));
+        blocks.Fill(tuim::vec2(3, 3));
+        CHECK_FALSE(blocks.GetPixel(1, 1));
+        CHECK(blocks.GetGlyphs()[0] == U'█');
+        CHECK(blocks.GetGlyphs()[1] == U'▀');
+        CHECK(blocks.GetGlyphs()[7] == U'█');
+    }
+}
+
+TEST_SUITE("charts") {
+    TEST_CASE("SeriesBuffer") {
+        tuim::SeriesBuffer series(300);
+        for (int i = 0; i < 1000; i++)
+            series.Push((i * 37) % 101);
+        CHECK(series.GetSize() == 300);
+        CHECK(series.At(0) == (700 * 37) % 101);
+
+        // The block summaries give the same result as reading every sample.
+        for (size_t first : { 0, 5, 64, 100 }) {
+            for (size_t last : { 120, 200, 299, 300 }) {
+                float min = 1000, max = -1000, expectedMin = 1000, expectedMax = -1000;
+                series.GetRange(first, last, min, max);
+                for (size_t i = first; i < last; i++) {
+                    expectedMin = std::min(expectedMin, series.At(i));
+                    expectedMax = std::max(expectedMax, series.At(i));
+                }
+                CHECK(min == expectedMin);
+                CHECK(max == expectedMax);
+            }
+        }
+    }
+    TEST_CASE("DownsampleLTTB") {
+        std::vector<float> samples(1000, 0.f);
+        samples[500] = 10.f;
+        std::vector<size_t> indices;
+        tuim::DownsampleLTTB(samples.size(), 20, [&](size_t i) { return samples[i]; }, indices);
+        CHECK(indices.size() == 20);
+        CHECK(indices.front() == 0);
+        CHECK(indices.back() == 999);
+        CHECK(std::find(indices.begin(), indices.end(), 500) != indices.end());
+    }
+}
+
+TEST_SUITE("image") {
+    TEST_CASE("ImageData") {
+        // A 2x4 image is averaged down to a single column of two half blocks.
+        std::vector<uint8_t> rgb = {
+            0, 0, 0,  100, 0, 0,
+            200, 0, 0,  100, 0, 0,
+            0, 0, 255,  0, 0, 255,
+            0, 50, 0,  0, 150, 0
+        };
+        tuim::ImageData image;
+        image.SetPixels(rgb.data(), tuim::vec2(2, 4), tuim::vec2(1, 2));
+        CHECK(image.m_Size == tuim::vec2(1, 2));
+        CHECK(image.m_Cells[0]->m_Character == U'▀');
+        CHECK(*image.m_Cells[0]->m_Foreground == tuim::Color(50, 0, 0));
+        CHECK(*image.m_Cells[0]->m_Background == tuim::Color(150, 0, 0, true));
+        CHECK(*image.m_Cells[1]->m_Background == tuim::Color(0, 100, 0, true));
+
+        // The missing dimension keeps the aspect ratio.
+        image.SetPixels(rgb.data(), tuim::vec2(2, 4), tuim::vec2(2, 0));
+        CHECK(image.m_Size == tuim::vec2(2, 2));
+    }
+    TEST_CASE("QuantizeColor") {
+        CHECK(tuim::QuantizeColor(tuim::Color(100, 100, 101), tuim::IMAGE_FLAGS_256_COLORS) == tuim::Color(98, 98, 98));
+        CHECK(tuim::QuantizeColor(tuim::Color(200, 30, 20), tuim::IMAGE_FLAGS_256_COLORS) == tuim::Color(215, 0, 0));
+        CHECK(tuim::QuantizeColor(tuim::Color(200, 30, 20, true), tuim::IMAGE_FLAGS_16_COLORS) == tuim::Color(255, 0, 0, true));
+        CHECK(tuim::QuantizeColor(tuim::Color(1, 2, 3), tuim::IMAGE_FLAGS_NONE) == tuim::Color(1, 2, 3));
+    }
+}
+
+TEST_SUITE("layout") {
+    TEST_CASE("SolveLayout") {
+        using tuim::LayoutSize;
+        std::vector<int> sizes;
+        tuim::SolveLayout({ LayoutSize::Fixed(10), LayoutSize::Flex(), LayoutSize::Flex(2) }, 100, 0, sizes);
+        CHECK(sizes == std::vector<int>({ 10, 30, 60 }));
+
+        // The flexible cells out of their bounds are clamped, the others share the rest.
+        tuim::SolveLayout({ LayoutSize::Fixed(10), LayoutSize::Flex().Clamp(0, 20), LayoutSize::Flex(2) }, 100, 0, sizes);
+        CHECK(sizes == std::vector<int>({ 10, 20, 70 }));
+        tuim::SolveLayout({ LayoutSize::Percent(25), LayoutSize::Flex().Clamp(50), LayoutSize::Flex() }, 60, 0, sizes);
+        CHECK(sizes == std::vector<int>({ 15, 50, 0 }));
+
+        // The gaps are removed first and the characters left by the rounding go to the first cells.
+        tuim::SolveLayout({ LayoutSize::Flex(), LayoutSize::Flex(), LayoutSize::Flex() }, 10, 1, sizes);
+        CHECK(sizes == std::vector<int>({ 3, 3, 2 }));
+    }
+}
+
+TEST_SUITE("navigation") {
+    TEST_CASE("ItemIndex") {
+        // A grid of 50x100 items of 8x1 characters, 10 characters apart.
+        std::vector<std::shared_ptr<tuim::Item>> items;
+        for (int i = 0; i < 5000; i++) {
+            std::shared_ptr<tuim::Item> item = std::make_shared<tuim::Item>();
+            item->m_Pos = tuim::vec2((i % 50) * 10, i / 50);
+            item->m_Size = tuim::vec2(8, 1);
+            items.push_back(item);
+        }
+        tuim::ItemIndex index;
+        index.Build(items);
+        auto All = [](size_t) { return true; };
+        CHECK(index.FindNearest(2525, tuim::Key::RIGHT, All) == 2526);
+        CHECK(index.FindNearest(2525, tuim::Key::LEFT, All) == 2524);
+        CHECK(index.FindNearest(2525, tuim::Key::DOWN, All) == 2575);
+        CHECK(index.FindNearest(2525, tuim::Key::UP, All) == 2475);
+        CHECK(index.FindNearest(49, tuim::Key::RIGHT, All) == -1);
+
+        // The items refused by the filter are skipped.
+        CHECK(index.FindNearest(2525, tuim::Key::RIGHT, [](size_t i) { return i % 50 != 26; }) == 2527);
+
+        // Hit-testing returns the last item added at a position.
+        CHECK(index.FindAt(tuim::vec2(253, 50), All) == 2525);
+        CHECK(index.FindAt(tuim::vec2(259, 50), All) == -1);
+        std::shared_ptr<tuim::Item> popup = std::make_shared<tuim::Item>();
+        popup->m_Pos = tuim::vec2(250, 50);
+        index.Add(*popup);
+        index.Resize(5000, tuim::vec2(40, 2));
+        CHECK(index.FindAt(tuim::vec2(285, 51), All) == 5000);
+        CHECK(index.FindAt(tuim::vec2(253, 50), [](size_t i) { return i != 5000; }) == 2525);
+    }
+
+    TEST_CASE("MouseClick") {
+        tuim::ctx = new tuim::Context();
+        bool popup = false;
+        bool base = false;
+        size_t selected = 0;
+        size_t clicked = 0;
+        auto Frame = [&](char32_t keyCode) {
+            tuim::Update(keyCode);
+            tuim::Clear();
+            tuim::BeginLayer(tuim::LAYER_POPUP);
+            tuim::Checkbox("#popup", "popup", &popup);
+            tuim::EndLayer();
+            tuim::Checkbox("#base", "base", &base);
+            tuim::Print("\n");
+            tuim::ScrollList("#list", tuim::vec2(10, 5), &selected, 20, [&](size_t index, [[maybe_unused]] bool highlighted) {
+                if (highlighted && tuim::IsKeyPressed(tuim::Key::ENTER))
+                    clicked = index;
+                tuim::Print("{}", index);
+            });
+        };
+        auto Click = [&](tuim::vec2 pos) {
+            tuim::GetCtx()->m_MouseEvent = { pos, tuim::MOUSE_ACTION_PRESS, tuim::MOUSE_BUTTON_LEFT };
+            Frame(tuim::Key::MOUSE);
+        };
+        tuim::ItemId& hovered = tuim::GetCtx()->m_HoveredItemId;
+        Frame(0);
+
+        // The popup is drawn before the base, but its item is still the one clicked.
+        Click(tuim::vec2(1, 0));
+        CHECK(hovered == tuim::StringToId("#popup"));
+        CHECK(popup);
+        CHECK_FALSE(base);
+
+        // The clicked row of a list is selected before it is pressed (the first row is below its top border).
+        Click(tuim::vec2(3, 3));
+        CHECK(hovered == tuim::StringToId("#list"));
+        CHECK(selected == 1);
+        CHECK(clicked == 1);
+        Frame(tuim::Key::PAGE_DOWN);
+        Click(tuim::vec2(3, 4));
+        CHECK(selected == tuim::FindState<tuim::ScrollState>(tuim::StringToId("#list"))->m_Offset + 2);
+        CHECK(clicked == selected);
+
+        // The border and the rows past the end are not selected.
+        size_t previous = selected;
+        Click(tuim::vec2(3, 1));
+        CHECK(selected == previous);
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+
+    TEST_CASE("SpatialNavigation") {
+        tuim::ctx = new tuim::Context();
+        bool value = false;
+        int volume = 5;
+        auto Frame = [&](char32_t keyCode) {
+            tuim::Update(keyCode);
+            tuim::Clear();
+            tuim::Checkbox("#left", "left", &value);
+            tuim::SetCurrentCursor(tuim::vec2(20, 0));
+            tuim::Checkbox("#right", "right", &value);
+            tuim::SetCurrentCursor(tuim::vec2(40, 0));
+            tuim::IntSlider("#slider", "{}", &volume, 0, 10, 1, 10);
+        };
+        tuim::ItemId& hovered = tuim::GetCtx()->m_HoveredItemId;
+        Frame(0);
+        Frame(0);
+        CHECK(hovered == tuim::StringToId("#left"));
+
+        // By default, LEFT/RIGHT are left to the hovered item.
+        Frame(tuim::Key::RIGHT);
+        CHECK(hovered == tuim::StringToId("#left"));
+        CHECK(tuim::IsKeyPressed(tuim::Key::RIGHT));
+
+        // Once enabled, they move the focus, except from the items using them.
+        tuim::SetSpatialNavigation(tuim::NAVIGATION_FLAGS_HORIZONTAL);
+        Frame(tuim::Key::RIGHT);
+        CHECK(hovered == tuim::StringToId("#right"));
+        Frame(tuim::Key::RIGHT);
+        CHECK(hovered == tuim::StringToId("#slider"));
+        int previous = volume;
+        Frame(tuim::Key::LEFT);
+        CHECK(hovered == tuim::StringToId("#slider"));
+        CHECK(volume == previous - 1);
+
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+}
+
+TEST_SUITE("inputs") {
+    TEST_CASE("ParseKeyCode") {
+        char32_t keyCode = 0;
+        tuim::MouseEvent mouse;
+        CHECK(tuim::ParseKeyCode("a", keyCode, mouse) == 1);
+        CHECK(keyCode == U'a');
+        CHECK(tuim::ParseKeyCode("\xc3\xa9!", keyCode, mouse) == 2);
+        CHECK(keyCode == U'é');
+        CHECK(tuim::ParseKeyCode("\x1b[Ab", keyCode, mouse) == 3);
+        CHECK(keyCode == tuim::Key::UP);
+        CHECK(tuim::ParseKeyCode("\x1b[5~", keyCode, mouse) == 4);
+        CHECK(keyCode == tuim::Key::PAGE_UP);
+
+        // Incomplete keys are left for the next read.
+        CHECK(tuim::ParseKeyCode("\x1b", keyCode, mouse) == 0);
+        CHECK(tuim::ParseKeyCode("\xc3", keyCode, mouse) == 0);
+        CHECK(tuim::ParseKeyCode("\x1b[<0;10", keyCode, mouse) == 0);
+
+        // Mouse events in SGR format.
+        CHECK(tuim::ParseKeyCode("\x1b[<0;10;5M", keyCode, mouse) == 10);
+        CHECK(keyCode == tuim::Key::MOUSE);
+        CHECK(mouse.m_Pos == tuim::vec2(9, 4));
+        CHECK(mouse.m_Action == tuim::MOUSE_ACTION_PRESS);
+        CHECK(mouse.m_Button == tuim::MOUSE_BUTTON_LEFT);
+        tuim::ParseKeyCode("\x1b[<0;10;5m", keyCode, mouse);
+        CHECK(mouse.m_Action == tuim::MOUSE_ACTION_RELEASE);
+        tuim::ParseKeyCode("\x1b[<35;120;40M", keyCode, mouse);
+        CHECK(mouse.m_Action == tuim::MOUSE_ACTION_MOVE);
+        CHECK(mouse.m_Pos == tuim::vec2(119, 39));
+        tuim::ParseKeyCode("\x1b[<65;1;1M", keyCode, mouse);
+        CHECK(mouse.m_Action == tuim::MOUSE_ACTION_WHEEL_DOWN);
+
+        // Bracketed paste, the text is given at once as a view into the input.
+        std::string_view paste;
+        std::string input = "\x1b[200~one\rtwo\x1b[201~a";
+        CHECK(tuim::ParseKeyCode(input, keyCode, mouse, &paste) == input.size() - 1);
+        CHECK(keyCode == tuim::Key::PASTE);
+        CHECK(paste == "one\rtwo");
+        CHECK(paste.data() == input.data() + 6);
+        CHECK(tuim::ParseKeyCode("\x1b[200~one\rtw", keyCode, mouse, &paste) == 0);
+    }
+
+    TEST_CASE("PollKeyCode") {
+        tuim::ctx = new tuim::Context();
+        int fds[2];
+        REQUIRE(pipe(fds) == 0);
+        int input = dup(STDIN_FILENO);
+        dup2(fds[0], STDIN_FILENO);
+        auto Write = [&](std::string_view bytes) {
+            CHECK(write(fds[1], bytes.data(), bytes.size()) == (ssize_t) bytes.size());
+        };
+
+        // A complete paste is a single key.
+        Write("\x1b[200~one\ntwo\x1b[201~a");
+        CHECK(tuim::PollKeyCode() == tuim::Key::PASTE);
+        CHECK(tuim::GetPastedText() == "one\ntwo");
+        CHECK(tuim::PollKeyCode() == U'a');
+
+        // Without its end marker, the text read so far is pasted and the next polls continue the paste.
+        Write("\x1b[200~[one");
+        CHECK(tuim::PollKeyCode() == tuim::Key::PASTE);
+        CHECK(tuim::GetPastedText() == "[one");
+        Write("two\x1b[20");
+        CHECK(tuim::PollKeyCode() == tuim::Key::PASTE);
+        CHECK(tuim::GetPastedText() == "two");
+        Write("1~b");
+        CHECK(tuim::PollKeyCode() == 0);
+        CHECK(tuim::PollKeyCode() == U'b');
+
+        dup2(input, STDIN_FILENO);
+        close(input);
+        close(fds[0]);
+        close(fds[1]);
+        delete tuim::ctx;
+        tuim::ctx = nullptr;
+    }
+}
+
+TEST_SUITE("states") {
+    TEST_CASE("StatePool") {
+        tuim::StatePool<int> pool;
+        pool.Get(1, 0) = 10;
+        pool.Get(2, 0) = 20;
+        pool.Get(3, 5) = 30;
+        CHECK(pool.Get(1, 5) == 10);
+
+        // Only the state of item 2 has not been used for more than 3 frames.
+        pool.CollectGarbage(6, 3);
+        CHECK(pool.m_States.size() == 2);
+        CHECK(pool.Find(2) == nullptr);
+        CHECK(*pool.Find(1) == 10);
+        CHECK(*pool.Find(3) == 30);
+    }
+}
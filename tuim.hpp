@@ -25,7 +25,11 @@ namespace tuim {
 #include <string> // std::string
 #include <string_view> // std::string_view
 #include <vector> // std::vector
+#include <list> // std::list
+#include <deque> // std::deque
+#include <span> // std::span
 #include <stack> // std::stack
+#include <array> // std::array
 #include <cstdint> // uint32_t...
 #include <functional> // std::function
 #include <format> // std::format
@@ -34,12 +38,29 @@ namespace tuim {
 #include <unordered_map> // std::unordered_map
 #include <optional> // std::optional
 #include <charconv> // std::from_chars
+#include <limits> // std::numeric_limits
+#include <cstring> // std::memcpy
+#include <cmath> // std::sqrt
+#include <algorithm> // std::stable_sort, std::inplace_merge
+#include <thread> // std::thread
+#include <mutex> // std::mutex, std::lock_guard
+#include <atomic> // std::atomic
+#include <regex> // std::regex
+#include <fstream> // std::ifstream
+
+#ifdef __SSE2__
+#include <emmintrin.h> // _mm_loadu_si128, _mm_movemask_epi8...
+#endif
 
 #ifdef __linux__
 #include <unistd.h> // STDOUT_FILENO
 #include <termios.h> // termios, tcgetattr, tcsetattr
 #include <sys/ioctl.h> // winsize, ioctl
 #include <sys/select.h> // select
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <csignal> // std::raise, SIGINT
 #elif _WIN32
 #error "Windows is not supported yet."
 #else
@@ -68,7 +89,15 @@ namespace tuim {
     using ContainerFlags = uint32_t;
     using InputTextFlags = uint32_t;
     using ImageFlags = uint32_t;
+    using ParagraphFlags = uint32_t;
+    using TableColumnFlags = uint32_t;
+    using LogViewFlags = uint32_t;
+    using TextSearchFlags = uint32_t;
+    using CanvasFlags = uint32_t;
+    using ChartFlags = uint32_t;
+    using LayoutFlags = uint32_t;
     using AlignFlags = uint32_t;
+    using NavigationFlags = uint32_t;
 
     /***********************************************************
     *                           MATH                           *
@@ -110,6 +139,52 @@ namespace tuim {
         }
     };
 
+    struct rect {
+        int x, y, w, h;
+
+        rect() : rect(0, 0, 0, 0) {}
+        rect(int x, int y, int w, int h) : x(x), y(y), w(std::max(0, w)), h(std::max(0, h)) {}
+        ~rect() = default;
+
+        inline bool IsEmpty() const {
+            return w <= 0 || h <= 0;
+        }
+
+        inline bool Contains(const vec2 &pos) const {
+            return pos.x >= x && pos.y >= y && pos.x < x + w && pos.y < y + h;
+        }
+
+        inline bool Contains(const rect &other) const {
+            return other.x >= x && other.y >= y && other.x + other.w <= x + w && other.y + other.h <= y + h;
+        }
+
+        inline bool operator==(const rect &other) const {
+            return x == other.x && y == other.y && w == other.w && h == other.h;
+        }
+
+        inline bool operator!=(const rect &other) const {
+            return !(*this == other);
+        }
+
+        inline rect Intersect(const rect &other) const {
+            int left = std::max(x, other.x);
+            int top = std::max(y, other.y);
+            int right = std::min(x + w, other.x + other.w);
+            int bottom = std::min(y + h, other.y + other.h);
+            return rect(left, top, right - left, bottom - top);
+        }
+
+        inline rect Union(const rect &other) const {
+            if (IsEmpty()) return other;
+            if (other.IsEmpty()) return *this;
+            int left = std::min(x, other.x);
+            int top = std::min(y, other.y);
+            int right = std::max(x + w, other.x + other.w);
+            int bottom = std::max(y + h, other.y + other.h);
+            return rect(left, top, right - left, bottom - top);
+        }
+    };
+
     /***********************************************************
     *                         INPUTS                           *
     ***********************************************************/
@@ -122,6 +197,10 @@ namespace tuim {
         NONE = 0,
         
         // Controls
+        CTRL_A     = 1,
+        CTRL_C     = 3,
+        CTRL_Y     = 25,
+        CTRL_Z     = 26,
         TAB        = 9,
         ENTER      = 10,
         ESCAPE     = 27,
@@ -155,6 +234,12 @@ namespace tuim {
         DELETE    = TUIM_MAKE_KEY4(27, 91, 51, 126), // ESC [ 3 ~
         PAGE_UP   = TUIM_MAKE_KEY4(27, 91, 53, 126), // ESC [ 5 ~
         PAGE_DOWN = TUIM_MAKE_KEY4(27, 91, 54, 126), // ESC [ 6 ~
+
+        // Mouse
+        MOUSE = TUIM_MAKE_KEY3(27, 91, '<'), // ESC [ < (see GetMouseEvent)
+
+        // Bracketed paste
+        PASTE = TUIM_MAKE_KEY4(27, 91, 50, 48), // ESC [ 2 0 0 ~ (see GetPastedText)
     
         // Digits
         DIGIT_0 = '0',
@@ -197,10 +282,34 @@ namespace tuim {
         Z = 'z',
     };
     
+    enum MouseButton : uint8_t {
+        MOUSE_BUTTON_LEFT = 0,
+        MOUSE_BUTTON_MIDDLE,
+        MOUSE_BUTTON_RIGHT,
+        MOUSE_BUTTON_NONE,
+    };
+
+    enum MouseAction : uint8_t {
+        MOUSE_ACTION_PRESS = 0,
+        MOUSE_ACTION_RELEASE,
+        MOUSE_ACTION_MOVE, // The mouse moved, with a button pressed or not.
+        MOUSE_ACTION_WHEEL_UP,
+        MOUSE_ACTION_WHEEL_DOWN,
+    };
+
+    struct MouseEvent {
+        vec2 m_Pos; // Position of the cell below the pointer.
+        MouseAction m_Action = MOUSE_ACTION_MOVE;
+        MouseButton m_Button = MOUSE_BUTTON_NONE;
+    };
+
     char32_t PollKeyCode(); // Wait until timeout for a key to be pressed
+    size_t ParseKeyCode(std::string_view input, char32_t& keyCode, MouseEvent& mouse, std::string_view* paste = nullptr); // Parse the first key of an input, returns its length in bytes (0 if it is incomplete).
     Key GetPressedKey(); // Get the current frame pressed key as an enum key
     bool IsKeyPressed(); // Check if a key has been pressed
     bool IsKeyPressed(Key key); // Check if a specific key has been pressed
+    const MouseEvent& GetMouseEvent(); // Returns the last mouse event (when Key::MOUSE has been pressed)
+    std::string_view GetPastedText(); // Returns the text pasted during this frame (when Key::PASTE has been pressed)
 
     /***********************************************************
     *                         COLORS                           *
@@ -277,6 +386,13 @@ namespace tuim {
         ITEM_FLAGS_NONE        = 0,
         ITEM_FLAGS_DISABLED    = 1 << 0,
         ITEM_FLAGS_STAY_ACTIVE = 1 << 1,
+        ITEM_FLAGS_USE_LEFT_RIGHT = 1 << 2, // LEFT/RIGHT are used by the item while hovered, so they do not move the focus.
+    };
+
+    enum NavigationFlags_ : uint32_t {
+        NAVIGATION_FLAGS_NONE = 0,
+        NAVIGATION_FLAGS_VERTICAL = 1 << 0, // UP/DOWN move the focus to the nearest item in their direction instead of the previous/next item.
+        NAVIGATION_FLAGS_HORIZONTAL = 1 << 1, // LEFT/RIGHT move the focus to the nearest item in their direction, unless the hovered item uses them.
     };
     
     enum ContainerFlags_ : uint32_t {
@@ -295,6 +411,47 @@ namespace tuim {
         IMAGE_FLAGS_NONE = 0,
         IMAGE_FLAGS_CLICKABLE = 1 << 0,
         IMAGE_FLAGS_BORDERLESS = 1 << 1,
+        IMAGE_FLAGS_256_COLORS = 1 << 2, // Quantize the pixels to the xterm 256-color palette.
+        IMAGE_FLAGS_16_COLORS = 1 << 3, // Quantize the pixels to the 16 standard terminal colors.
+    };
+    
+    enum ParagraphFlags_ : uint32_t {
+        PARAGRAPH_FLAGS_NONE = 0,
+        PARAGRAPH_FLAGS_OPTIMAL_FIT = 1 << 0, // Minimize the raggedness of the whole paragraph instead of filling lines greedily.
+    };
+    
+    enum TableColumnFlags_ : uint32_t {
+        TABLE_COLUMN_FLAGS_NONE = 0,
+        TABLE_COLUMN_FLAGS_NUMERIC = 1 << 0, // Sort the cells by numeric value and align them to the right.
+    };
+    
+    enum LogViewFlags_ : uint32_t {
+        LOG_VIEW_FLAGS_NONE = 0,
+        LOG_VIEW_FLAGS_BORDERLESS = 1 << 0,
+        LOG_VIEW_FLAGS_FOLLOW = 1 << 1, // Keep the last line selected when lines are appended to the file.
+        LOG_VIEW_FLAGS_MARKUP = 1 << 2, // Apply the formatting tags of the lines, like Print.
+    };
+    
+    enum TextSearchFlags_ : uint32_t {
+        TEXT_SEARCH_FLAGS_NONE = 0,
+        TEXT_SEARCH_FLAGS_IGNORE_CASE = 1 << 0, // Ignore the case of ASCII letters.
+        TEXT_SEARCH_FLAGS_REGEX = 1 << 1, // Interpret the query as an ECMAScript regular expression.
+    };
+    
+    enum CanvasFlags_ : uint32_t {
+        CANVAS_FLAGS_NONE = 0,
+        CANVAS_FLAGS_HALF_BLOCK = 1 << 0, // Draw 1x2 pixels per cell with half blocks instead of 2x4 braille dots.
+    };
+    
+    enum ChartFlags_ : uint32_t {
+        CHART_FLAGS_NONE = 0,
+        CHART_FLAGS_LTTB = 1 << 0, // Keep the most significant samples (Largest-Triangle-Three-Buckets) instead of the extremes of each column.
+        CHART_FLAGS_HALF_BLOCK = 1 << 1, // Draw with half blocks instead of braille dots.
+    };
+
+    enum LayoutFlags_ : uint32_t {
+        LAYOUT_FLAGS_NONE = 0, // The cells are placed side by side.
+        LAYOUT_FLAGS_COLUMN = 1 << 0, // The cells are placed below each other.
     };
     
     enum AlignFlags_ : uint32_t {
@@ -321,6 +478,12 @@ namespace tuim {
     void SetFullscreen(bool fullscreen); // Change the terminal to full screen
     void SetFramerate(float framerate); // Change the delay between two frame are calculated and drawn
 
+    void SetTextCacheCapacity(size_t capacity); // Change the maximum number of texts measurements kept in cache
+    void SetStateLifetime(uint32_t frames); // Change the number of frames after which the states of the items that are not drawn anymore are removed
+    void SetMouseEnabled(bool enabled); // Report the clicks, the wheel and the motion of the mouse (SGR 1006 mode)
+    void CaptureSignalKeys(); // Receive Ctrl+Z, Ctrl+Y... as keys instead of signals during this frame, call it every frame to keep them (Ctrl+C still interrupts)
+    void SetSpatialNavigation(NavigationFlags flags); // Move the focus with the arrows to the nearest item in their direction (disabled by default, LEFT/RIGHT are then left to the hovered item)
+
     void DefineStyle(char tag, Style style);
     void DefineColor(char tag, Color color);
 
@@ -340,6 +503,10 @@ namespace tuim {
         void SetCursorVisibility(bool visible); // Change the terminal visibility
         void SetUserInputsVisibility(bool visible); // Change the user inputs visibility
         void SetAlternateBuffer(bool enabled); // Toggle the terminal alternate buffer
+        void SetMouseReporting(bool enabled); // Toggle the reporting of the mouse events in SGR format
+        void SetSignalKeys(bool enabled); // Toggle the signals sent by Ctrl+C, Ctrl+Z and the special characters like Ctrl+Y (ISIG and IEXTEN)
+        void SetBracketedPaste(bool enabled); // Toggle the markers around the pasted text
+        bool ReadInput(std::string& buffer, int timeout); // Append the bytes available within a timeout (in microseconds) to a buffer, returns false if there are none
         void SetCursorPos(const vec2& pos); // Change the cursor position
 
         void Clear(); // Clear the whole terminal
@@ -356,11 +523,13 @@ namespace tuim {
     class Cell {
     public:
         Cell();
-        Cell(char32_t ch, Style style = Style()) : m_Character(ch), m_Style(style) {}
+        Cell(char32_t ch, Style style = Style()) : m_Character(ch), m_Cluster(0), m_Style(style) {}
         ~Cell() = default;
 
+        // Clusters are compared by index, only cells of the same frame can be compared this way (see IsSameCell).
         bool operator==(const Cell& other) const {
             return m_Character == other.m_Character &&
+                   m_Cluster == other.m_Cluster &&
                    m_Style == other.m_Style &&
                    m_Foreground == other.m_Foreground &&
                    m_Background == other.m_Background;
@@ -370,16 +539,45 @@ namespace tuim {
             return !(*this == other);
         }
 
-        char32_t m_Character;
+        char32_t m_Character; // First character of the grapheme cluster.
+        uint32_t m_Cluster; // Index of the cluster in the frame cluster pool (0 if it is a single character).
         Style m_Style;
         std::optional<Color> m_Foreground;
         std::optional<Color> m_Background;
     };
 
+    // Colors and styles applied to the cells drawn directly, without formatting tags.
+    struct CellStyle {
+        std::optional<Color> m_Foreground;
+        std::optional<Color> m_Background;
+        Style m_Style = Style::NONE;
+
+        bool operator==(const CellStyle& other) const = default;
+    };
+
+    // Pool of grapheme clusters made of several characters (emoji sequences, combining marks...)
+    // referenced by cells. It is filled while the frame is built and cleared with it.
+    class ClusterPool {
+    public:
+        ClusterPool() = default;
+        ~ClusterPool() = default;
+
+        uint32_t Intern(std::u32string_view cluster); // Returns the index of a cluster, adding it to the pool if needed.
+        std::u32string_view Get(uint32_t index) const; // Returns the cluster at a given index.
+        void Clear();
+
+        std::vector<std::u32string> m_Clusters;
+        std::unordered_map<std::u32string, uint32_t> m_Indices;
+    };
+
+    // Compare two cells of different frames (or null cells), their clusters are looked up in the pool of each frame.
+    bool IsSameCell(const Cell* cell, const ClusterPool& clusters, const Cell* other, const ClusterPool& otherClusters);
+
     class Frame {
     public:
         Frame();
         Frame(const vec2& size);
+        Frame(std::shared_ptr<Frame> target, const vec2& offset, const rect& clip); // Viewport drawing directly into the cells of another frame.
         ~Frame() = default;
     
         vec2 GetSize() const;
@@ -387,28 +585,66 @@ namespace tuim {
         std::shared_ptr<Cell> Get(size_t x, size_t y);
         bool Has(size_t x, size_t y) const;
         void Set(const vec2& pos, std::shared_ptr<Cell> cell);
-        void Clear();
+        void DrawCluster(std::u32string_view cluster, const CellStyle& style, const vec2& bounds); // Draw a grapheme cluster at the cursor and move it (nothing is drawn beyond bounds).
+        void Clear(); // Remove the cells, only in the area where some have been set.
 
         vec2 m_Cursor;
         std::vector<std::vector<std::shared_ptr<Cell>>> m_Cells;
+        rect m_Drawn; // Area of the cells set since the last Clear (empty for viewports).
+
+        std::shared_ptr<Frame> m_Target; // Frame that owns the cells if this frame is a viewport (nullptr otherwise).
+        vec2 m_Offset; // Position of the viewport origin in the target frame.
+        rect m_Clip; // Area of the target frame in which the viewport can draw.
     };
 
     /***********************************************************
     *                    COMPONENTS/ITEMS                      *
     ***********************************************************/
 
+    // Layers drawn over each other, from the bottom one to the top one.
+    enum Layer : uint8_t {
+        LAYER_BASE = 0,
+        LAYER_POPUP,
+        LAYER_TOOLTIP,
+        LAYER_MODAL, // Only the items of this layer can be navigated to when it has some.
+        LAYER_COUNT
+    };
+
     class Item {
     public:
-        Item() : m_Id(0), m_Size(vec2(0, 0)), m_Pos(vec2(0, 0)), m_Flags(ITEM_FLAGS_NONE) {}
+        Item() : m_Id(0), m_Size(vec2(0, 0)), m_Pos(vec2(0, 0)), m_Flags(ITEM_FLAGS_NONE), m_Layer(LAYER_BASE) {}
         virtual ~Item() = default;
 
         ItemId m_Id;
         vec2 m_Size;
-        vec2 m_Pos;
+        vec2 m_Pos; // Position on the screen (given in the current frame by the widgets, and moved when the item is added).
         ItemFlags m_Flags;
+        Layer m_Layer; // Layer in which the item has been drawn.
+    };
+
+    // Areas of the items sorted into buckets, to find the nearest item in a direction without going through all of them.
+    class ItemIndex {
+    public:
+        ItemIndex() : m_Buckets(1), m_GridSize(1, 1) {}
+        ~ItemIndex() = default;
+
+        void Clear(vec2 size); // Remove the items, the buckets cover an area of the given size (items outside go to the closest buckets).
+        void Add(const Item& item); // Add the area of the next item.
+        void Resize(size_t index, vec2 size); // Change the size of an item already added.
+        void Build(const std::vector<std::shared_ptr<Item>>& items); // Add all the items, with buckets covering them.
+        int FindNearest(size_t from, Key direction, const std::function<bool(size_t)>& filter) const; // Returns the index of the nearest item accepted by the filter, or -1.
+        int FindAt(vec2 pos, const std::function<bool(size_t)>& filter) const; // Returns the index of the last item accepted by the filter at a position, or -1.
+
+        static constexpr int BUCKET_WIDTH = 16;
+        static constexpr int BUCKET_HEIGHT = 4;
+
+        std::vector<rect> m_Areas; // Area of each item on the screen.
+        std::vector<std::vector<uint32_t>> m_Buckets; // Items overlapping each bucket, line by line.
+        vec2 m_GridSize; // Number of buckets.
     };
 
     ItemId GetCurrentItemId();
+    void FitItemToCursor(); // Size the last item from its position to the cursor, for the items whose size is only known once drawn.
     uint32_t GetItemIndex(ItemId id);
     uint32_t getHoveredItemIndex();
     bool WasItemActive();
@@ -424,28 +660,233 @@ namespace tuim {
 
     class Container : public Item {
     public:
-        Container() : Item(), m_ContainerFlags(CONTAINER_FLAGS_NONE), m_AlignFlags(ALIGN_NONE), m_Frame(nullptr) {}
-        Container(std::shared_ptr<Frame> frame, ContainerFlags flags = CONTAINER_FLAGS_NONE, AlignFlags align = ALIGN_NONE) : Item(), m_ContainerFlags(flags), m_AlignFlags(align), m_Frame(frame) {}
+        Container() : Item(), m_ContainerFlags(CONTAINER_FLAGS_NONE), m_AlignFlags(ALIGN_NONE), m_Frame(nullptr), m_Recording(false), m_FirstItem(0) {}
+        Container(std::shared_ptr<Frame> frame, ContainerFlags flags = CONTAINER_FLAGS_NONE, AlignFlags align = ALIGN_NONE) : Item(), m_ContainerFlags(flags), m_AlignFlags(align), m_Frame(frame), m_Recording(false), m_FirstItem(0) {}
         ~Container() = default;
 
         ContainerFlags m_ContainerFlags;
         AlignFlags m_AlignFlags;
-        std::shared_ptr<Frame> m_Frame;
+        vec2 m_Origin; // Position of the container (border included) in its parent, after alignment.
+        std::shared_ptr<Frame> m_Frame; // Viewport drawing the content directly into the screen frame.
+        bool m_Recording; // Whether the content is kept by EndContainer to be reused by the next frames.
+        size_t m_FirstItem; // Index of the first item of the content in the ordered items.
     };
 
-    void BeginContainer(std::string_view id, std::string_view label, vec2 size, ContainerFlags flags = CONTAINER_FLAGS_NONE, AlignFlags align = ALIGN_NONE);
+    bool BeginContainer(std::string_view id, std::string_view label, vec2 size, ContainerFlags flags = CONTAINER_FLAGS_NONE, AlignFlags align = ALIGN_NONE); // Returns false if the container is fully clipped, so its content can be skipped (EndContainer must still be called).
+    bool BeginCachedContainer(std::string_view id, std::string_view label, vec2 size, uint64_t version, ContainerFlags flags = CONTAINER_FLAGS_NONE, AlignFlags align = ALIGN_NONE); // Returns false if the content can be skipped, because it is clipped or because the cells of the last frames are reused as long as the version does not change (EndContainer must still be called).
     void EndContainer();
 
-    void MergeContainer(std::shared_ptr<Container> container); // Merge a given container into the current context frame (can be global or another container).
+    /***********************************************************
+    *                         LAYERS                           *
+    ***********************************************************/
+
+    void BeginLayer(Layer layer); // Draw the next items in a layer, from the top left corner of the screen.
+    void EndLayer();
+    bool ComposeLayers(); // Merge the upper layers into the screen frame from the top one (called by Display). Returns false if base containers were not drawn below areas that are not covered anymore.
+
+    /***********************************************************
+    *                         LAYOUTS                          *
+    ***********************************************************/
+
+    // Size of a cell of a layout along one axis.
+    struct LayoutSize {
+        enum Unit : uint8_t { FIXED, PERCENT, FLEX };
+
+        Unit m_Unit = FLEX;
+        float m_Value = 1.f; // Number of characters, percentage of the available size or weight of the remaining size.
+        int m_Min = 0;
+        int m_Max = std::numeric_limits<int>::max();
+
+        static LayoutSize Fixed(int size) { return { FIXED, static_cast<float>(size) }; }
+        static LayoutSize Percent(float percent) { return { PERCENT, percent }; }
+        static LayoutSize Flex(float weight = 1.f) { return { FLEX, weight }; }
+        LayoutSize Clamp(int min, int max = std::numeric_limits<int>::max()) const { return { m_Unit, m_Value, min, max }; }
+
+        bool operator==(const LayoutSize& other) const = default;
+    };
+
+    // Cells of a layout, solved again only when the available size or the sizes change.
+    struct LayoutState {
+        bool m_Valid = false;
+        vec2 m_Available;
+        int m_Gap = 0;
+        std::vector<LayoutSize> m_Columns;
+        std::vector<LayoutSize> m_Rows;
+        std::vector<rect> m_Cells; // Area of each cell relative to the layout, line by line.
+    };
+
+    // Layout being drawn, its cells are opened one after the other.
+    struct LayoutScope {
+        std::string m_Name;
+        ItemId m_Id;
+        vec2 m_Origin;
+        vec2 m_Size;
+        size_t m_Next = 0; // Index of the next cell to open.
+        bool m_IsCellOpen = false;
+    };
+
+    void SolveLayout(const std::vector<LayoutSize>& sizes, int available, int gap, std::vector<int>& out); // Compute the size of each cell along one axis.
+    void BeginLayout(std::string_view id, const std::vector<LayoutSize>& sizes, LayoutFlags flags = LAYOUT_FLAGS_NONE, vec2 size = vec2(0, 0), int gap = 0); // Start a row (or a column) of cells at the cursor, a 0 size takes the remaining size of the current container.
+    void BeginGrid(std::string_view id, const std::vector<LayoutSize>& columns, const std::vector<LayoutSize>& rows, vec2 size = vec2(0, 0), int gap = 0); // Start a grid of cells at the cursor, opened line by line.
+    bool NextLayoutCell(ContainerFlags flags = CONTAINER_FLAGS_BORDERLESS); // Close the previous cell and open the next one as a container, returns false if it is clipped or if there is no cell left.
+    void EndLayout();
+
+    /***********************************************************
+    *                     WIDGET STATES                        *
+    ***********************************************************/
+
+    class StatePoolBase {
+    public:
+        virtual ~StatePoolBase() = default;
+        virtual void CollectGarbage(uint64_t frame, uint64_t lifetime) = 0;
+    };
+
+    // States of a single type stored contiguously, with an index from the item ids to their slot.
+    template <typename T> class StatePool : public StatePoolBase {
+    public:
+        StatePool() = default;
+        ~StatePool() = default;
+
+        T& Get(ItemId id, uint64_t frame); // Returns the state of an item (created if needed) and marks it as used during a frame.
+        T* Find(ItemId id); // Returns the state of an item, or nullptr if it has none.
+        void CollectGarbage(uint64_t frame, uint64_t lifetime) override; // Removes the states of the items that have not been used for a number of frames.
+
+        std::vector<T> m_States;
+        std::vector<ItemId> m_Ids;
+        std::vector<uint64_t> m_LastFrames; // Last frame during which each state was used.
+        std::unordered_map<ItemId, uint32_t> m_Slots;
+    };
+
+    size_t NextStateType(); // Returns a new index for a type of state.
+    template <typename T> size_t GetStateType(); // Returns the index of the pool of a type of state.
+    template <typename T> T& GetState(ItemId id); // Returns the state of an item retained between frames (the reference is invalidated when a new state of the same type is created).
+    template <typename T> T* FindState(ItemId id); // Returns the state of an item if it exists, without marking it as used.
+
+    /***********************************************************
+    *                       SCROLLING                          *
+    ***********************************************************/
+
+    // Scroll position of a list, retained between frames and moved by Update when the list is hovered.
+    struct ScrollState {
+        size_t m_Offset = 0; // Index of the first visible row.
+        size_t m_Selected = 0; // Index of the selected row.
+        size_t m_LastSelected = 0; // Selected row when the list was last drawn, to detect navigation.
+        size_t m_RowCount = 0;
+        size_t m_VisibleRows = 0;
+        int m_Top = 0; // Screen row of the first visible row, to select the clicked rows.
+    };
+
+    template <typename Func> bool ScrollList(const std::string& id, vec2 size, size_t* selected, size_t rowCount, Func&& row, ContainerFlags flags = CONTAINER_FLAGS_NONE); // Print a scrollable container that only calls row(index, highlighted) for its visible rows.
+    bool ScrollNavigate(ScrollState& state, char32_t keyCode); // Move the selected row of a list, returns false when the key leaves the list.
+
+    /***********************************************************
+    *                        DRAWING                           *
+    ***********************************************************/
+
+    CellStyle GetCurrentCellStyle(); // Returns the styles set by the formatting tags of the last Print.
+    void SetCurrentCellStyle(const CellStyle& style); // Changes the styles applied by the next Print.
+
+    void DrawGlyph(char32_t ch, const CellStyle& style); // Draw a single character at the cursor of the current frame.
+    void DrawText(std::string_view text, const CellStyle& style, int maxWidth = -1); // Draw a string at the cursor of the current frame, without parsing formatting tags (stops before exceeding maxWidth columns).
+    void FillRect(const vec2& pos, const vec2& size, char32_t ch, const CellStyle& style); // Fill a rectangle of the current frame with a character.
+    void DrawBar(int width, float fraction, char32_t ch, const CellStyle& filled, const CellStyle& empty); // Draw an horizontal bar of a given width at the cursor of the current frame.
+
+    template <typename Func> void PrintFields(std::string_view fmt, Func&& field); // Print the literal parts of a format string and call field(index, spec) for each replacement field.
+
+    /***********************************************************
+    *                       GAP BUFFER                         *
+    ***********************************************************/
+
+    // Text stored with a gap at the last edited position, so that successive insertions
+    // and deletions at the cursor only move the bytes between the old and new positions.
+    class GapBuffer {
+    public:
+        GapBuffer(std::string_view text = "");
+        ~GapBuffer() = default;
+
+        void SetText(std::string_view text);
+        std::string GetText() const;
+        void GetRange(size_t offset, size_t length, std::string& out) const; // Replaces out with a part of the text.
+        bool Equals(std::string_view text) const; // Compares the text without copying it.
+
+        size_t GetSize() const { return m_Data.size() - (m_GapEnd - m_GapStart); }
+        char At(size_t index) const { return m_Data[index < m_GapStart ? index : index + (m_GapEnd - m_GapStart)]; }
+        size_t PrevIndex(size_t index) const; // Returns the index of the UTF-8 character before an index.
+        size_t NextIndex(size_t index) const; // Returns the index of the UTF-8 character after an index.
+
+        void Insert(size_t index, std::string_view text);
+        void Erase(size_t index, size_t length);
+
+        std::vector<char> m_Data;
+        size_t m_GapStart;
+        size_t m_GapEnd;
+
+    private:
+        void MoveGap(size_t index);
+        void Reserve(size_t length); // Grows the gap to hold at least length bytes.
+    };
+
+    /***********************************************************
+    *                         IMAGES                           *
+    ***********************************************************/
+
+    // Block of cells computed once, from lines of text or from pixels, and copied into the frame when drawn.
+    class ImageData {
+    public:
+        ImageData() : m_Size(0, 0) {}
+        ~ImageData() = default;
+
+        void SetLines(const std::vector<std::string>& lines); // Measure and parse formatted lines (like Print).
+        void SetCells(const Frame& frame, const rect& area, const rect& clip); // Copy the cells of an area of a frame (cells outside of clip are left transparent).
+        void SetPixels(const uint8_t* rgb, vec2 pixelSize, vec2 size = vec2(0, 0), ImageFlags flags = IMAGE_FLAGS_NONE); // Convert RGB pixels to half blocks, scaled to size cells (a 0 keeps the aspect ratio).
+        bool LoadPPM(const std::string& path, vec2 size = vec2(0, 0), ImageFlags flags = IMAGE_FLAGS_NONE); // Load a binary (P6) or plain (P3) PPM file, returns false if it cannot be read.
+
+        vec2 m_Size; // Size in cells.
+        std::vector<std::shared_ptr<Cell>> m_Cells; // Cells by line, nullptr for transparent cells.
+        std::vector<std::pair<size_t, std::u32string>> m_Clusters; // Clusters of the cells made of several characters, interned again when drawn.
+    };
+
+    struct ImageState {
+        std::vector<std::string> m_Lines; // Lines of the cached image.
+        ImageData m_Image;
+    };
+
+    // Content of a cached container, drawn again instead of its items while nothing changes.
+    struct ContainerCache {
+        bool m_Valid = false;
+        uint64_t m_Version = 0; // Version given by the user when the content was built.
+        uint64_t m_Frame = 0; // Frame at which the content was built.
+        bool m_WasInteracting = false; // Whether one of the items was hovered or active when the content was built.
+        vec2 m_Offset; // Position of the content in the screen frame.
+        rect m_Clip; // Visible area of the content in the screen frame.
+        ImageData m_Image; // Cells of the content, from its position to the end of its visible area.
+        std::vector<std::shared_ptr<Item>> m_Items; // Items of the content, added again so that they can still be navigated to.
+    };
+
+    void ScaleImage(const uint8_t* rgb, vec2 size, std::vector<uint8_t>& out, vec2 outSize); // Resize RGB pixels by averaging the area covered by each output pixel.
+    void AccumulateRow(const uint8_t* row, uint32_t* sums, size_t count); // Add bytes to 32-bit sums.
+    Color QuantizeColor(const Color& color, ImageFlags flags); // Returns the nearest color of the palette selected by the flags.
+    void DrawImage(const ImageData& image); // Copy the cells of an image at the cursor.
 
     /***********************************************************
     *                         ITEMS                            *
     ***********************************************************/
 
     template <typename... Args> void Print(const std::string& fmt, Args&&... args); // Print a formatted string to the current frame.
+    void PrintUnformatted(std::string_view str); // Print a string to the current frame without formatting arguments.
+    size_t ParseFormattingTag(std::u32string_view chars, size_t index, CellStyle& style); // Apply the formatting tag at an index to a style, returns its length (0 if there is none).
     bool Button(const std::string& id, const std::string& text, ItemFlags flags = ITEM_FLAGS_NONE); // Print a button that can be pressed.
     
-    bool TextInput(const std::string& id, std::string_view fmt, std::string* value, InputTextFlags flags = INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER); // Print an string input.
+    struct TextInputState {
+        GapBuffer m_Buffer; // Value being edited, only used while the input is active.
+        size_t m_Cursor = 0; // Position of the cursor in the value (in bytes).
+        size_t m_Scroll = 0; // Position of the first visible character of the value (in bytes).
+        bool m_Editing = false; // Whether the buffer has edits that have not been written to the value yet.
+        const char* m_ValueData = nullptr; // Address of the value's characters at the end of the last frame, to notice the caller's changes.
+        size_t m_ValueSize = 0; // Size of the value at the end of the last frame.
+    };
+
+    bool TextInput(const std::string& id, std::string_view fmt, std::string* value, InputTextFlags flags = INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER, int width = 0); // Print an string input, scrolled to fit in width columns (0 to fill the container). Without INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER, each edit is also applied to the std::string, in O(n) for a value of n bytes.
     bool Checkbox(const std::string& id, std::string_view fmt, bool* value); // Print a checkbox
 
     bool IntSlider(const std::string& id, std::string_view fmt, int* value, int min, int max, int step = 1, uint width = 100); // Print an integer slider.
@@ -453,8 +894,507 @@ namespace tuim {
     
     bool EnumInput(const std::string& id, std::string_view fmt, size_t* index, const std::vector<std::string>& entries); // Print an enum input.
     
-    bool Image(const std::string& id, const std::vector<std::string>& lines, ImageFlags flags = IMAGE_FLAGS_NONE); // Print an ascii art image in the form of a vector of strings.
-    void Paragraph(const std::string& id, const std::string& text, uint width); // Print a paragraph with automatic line breaks and word spacing
+    bool Image(const std::string& id, const std::vector<std::string>& lines, ImageFlags flags = IMAGE_FLAGS_NONE); // Print an ascii art image in the form of a vector of strings (only parsed again when they change).
+    bool Image(const std::string& id, const ImageData& image, ImageFlags flags = IMAGE_FLAGS_NONE); // Print an image whose cells have already been computed.
+    void Paragraph(const std::string& id, const std::string& text, uint width, ParagraphFlags flags = PARAGRAPH_FLAGS_NONE); // Print a paragraph with automatic line breaks and word spacing
+
+    struct ParagraphLayout {
+        struct Word {
+            size_t m_Offset; // Position of the word in the text (in bytes).
+            size_t m_Length; // Length of the word (in bytes).
+            size_t m_Width; // Width of the word (in columns, formatting excluded).
+            bool m_LineBreak; // Whether the word is followed by a line break.
+            size_t m_FirstGlyph = 0; // Index of the first glyph of the word.
+            size_t m_LastGlyph = 0; // Index after the last glyph of the word.
+            CellStyle m_EndStyle; // Style active after the word, used by the spaces that follow it.
+        };
+
+        // Grapheme cluster of a word with its style, the formatting tags are parsed only once.
+        struct Glyph {
+            uint32_t m_Offset; // Position of the cluster in the characters.
+            uint32_t m_Length; // Length of the cluster (in characters).
+            CellStyle m_Style;
+        };
+
+        struct Line {
+            size_t m_First; // Index of the first word of the line.
+            size_t m_Last; // Index after the last word of the line.
+            size_t m_Width; // Width of the words and single spaces between them.
+            bool m_Justified; // Whether additional spaces must be distributed to reach the paragraph width.
+        };
+
+        uint m_Width;
+        ParagraphFlags m_Flags;
+        std::vector<Word> m_Words;
+        std::vector<Line> m_Lines;
+
+        CellStyle m_BaseStyle; // Style active before the paragraph when its glyphs were parsed.
+        std::u32string m_Chars; // Characters of the glyphs.
+        std::vector<Glyph> m_Glyphs;
+    };
+
+    std::vector<ParagraphLayout::Word> TokenizeParagraph(std::string_view text); // Split a text into measured words.
+    void ShapeParagraph(ParagraphLayout& layout, std::string_view text, const CellStyle& style); // Parse the words into glyphs, starting from a style.
+    void BreakParagraph(ParagraphLayout& layout); // Compute the lines of a paragraph from its words, width and flags.
+
+    /***********************************************************
+    *                         TABLE                            *
+    ***********************************************************/
+
+    struct TableColumn {
+        std::string m_Header;
+        int m_Width; // Fixed width (in columns), or 0 to fit the largest cell.
+        TableColumnFlags m_Flags;
+        std::vector<std::string> m_Cells;
+        std::vector<uint32_t> m_CellWidths; // Width of each cell, measured once when the row is added.
+        size_t m_MaxWidth; // Width of the largest cell (header included).
+    };
+
+    // Rows of a table stored by column. The rows are displayed through a list of row indices
+    // that is filtered and sorted on background threads, then swapped in by Poll.
+    class TableData {
+    public:
+        TableData() : m_RowCount(0), m_SortColumn(-1), m_SortAscending(true), m_Stale(false), m_Generation(0) {}
+        TableData(const TableData&) = delete;
+        TableData& operator=(const TableData&) = delete;
+        ~TableData();
+
+        size_t AddColumn(std::string_view header, int width = 0, TableColumnFlags flags = TABLE_COLUMN_FLAGS_NONE); // Returns the index of the new column.
+        void AddRow(const std::vector<std::string>& cells); // Adds a row at the end (missing cells are left empty).
+        void Clear(); // Removes all the rows, but keeps the columns.
+
+        void Sort(int column, bool ascending = true); // Sort the rows by a column in the background (-1 restores the insertion order).
+        void Filter(std::string_view query); // Only keep the rows with a cell containing the query, in the background.
+        bool Poll(); // Swaps in the rows computed in the background, returns true if the displayed rows changed.
+        void Wait(); // Waits for the background job to finish.
+        bool IsBusy(); // Returns true while a background job is running or waiting to be swapped in.
+
+        size_t GetRowCount() const { return m_RowCount + m_Appended.size(); } // Number of added rows.
+        size_t GetDisplayedRowCount() const { return m_Rows.size(); } // Number of rows left after filtering.
+        uint32_t GetRow(size_t index) const { return m_Rows[index]; } // Returns the stored row displayed at a given position.
+
+        std::vector<TableColumn> m_Columns;
+        size_t m_RowCount;
+        std::vector<uint32_t> m_Rows; // Indices of the displayed rows, after filtering and sorting.
+        int m_SortColumn;
+        bool m_SortAscending;
+        std::string m_Filter;
+
+    private:
+        void Start(); // Starts computing the displayed rows in the background.
+        void Cancel(); // Stops the background job and discards its result.
+        void StoreRow(const std::vector<std::string>& cells); // Adds a row to the columns and to the displayed rows.
+        void StoreAppendedRows(); // Stores the rows added while the background job was running.
+        bool MatchesFilter(uint32_t row, std::string_view query) const;
+        static double ParseNumericCell(const std::string& cell);
+        std::vector<uint32_t> ComputeRows(uint64_t generation, int sortColumn, bool ascending, std::string query) const;
+
+        bool m_Stale; // The displayed rows must be computed again (a job was cancelled).
+        std::vector<std::vector<std::string>> m_Appended; // Rows added while the background job reads the columns.
+        std::thread m_Worker;
+        std::mutex m_Mutex;
+        std::optional<std::vector<uint32_t>> m_Pending; // Result of the background job, guarded by m_Mutex.
+        std::atomic<uint64_t> m_Generation; // Incremented to cancel the running job.
+    };
+
+    template <typename Func> void ParallelFor(size_t count, Func&& func); // Call func(index) for each index on its own thread, and wait for all of them.
+    bool Table(const std::string& id, TableData& data, vec2 size, size_t* selected, ContainerFlags flags = CONTAINER_FLAGS_NONE); // Print a table with headers, only drawing the visible rows (selected is a displayed row position).
+
+    /***********************************************************
+    *                        LOG VIEW                          *
+    ***********************************************************/
+
+    // Read-only file mapped in memory, whose line offsets are indexed in the background.
+    // The file is never copied, so only the index grows with its size.
+    class LogFile {
+    public:
+        LogFile() : m_Fd(-1), m_Data(nullptr), m_Size(0), m_LineCount(0), m_Resets(0), m_Readers(0), m_Indexed(0), m_Indexing(false), m_Stop(false) {}
+        LogFile(const LogFile&) = delete;
+        LogFile& operator=(const LogFile&) = delete;
+        ~LogFile();
+
+        bool Open(const std::string& path); // Map a file and start indexing its lines, returns false if it cannot be opened.
+        void Close();
+        bool Poll(); // Index the data appended to the file since the last call, returns true if the number of lines changed.
+        bool IsIndexing() const { return m_Indexing; }
+
+        size_t GetLineCount(); // Number of lines indexed so far.
+        size_t GetCompleteLineCount(); // Number of lines indexed so far that end with a line break.
+        size_t GetIndexedSize(); // Size of the data indexed so far.
+        std::string_view GetLine(size_t index); // Returns a line without its line break (only valid until the next Poll).
+        void GetLineBounds(size_t first, size_t last, std::vector<uint64_t>& bounds); // Copies the offsets of lines [first, last) followed by the end of the last one.
+
+        int m_Fd;
+        const char* m_Data;
+        size_t m_Size; // Size of the mapped data.
+        size_t m_LineCount; // Number of lines during the last Poll.
+        size_t m_Resets; // Incremented when the lines are indexed again from the start (e.g. the file was truncated).
+        std::atomic<int> m_Readers; // Number of background searches reading the data, which cannot be remapped meanwhile.
+
+    private:
+        bool Map(size_t size);
+        void StartIndexing(size_t begin);
+        void StopIndexing();
+
+        std::thread m_Worker;
+        std::mutex m_Mutex;
+        std::vector<uint64_t> m_LineStarts; // Offset of each line, guarded by m_Mutex.
+        size_t m_Indexed; // End of the indexed data, guarded by m_Mutex.
+        std::atomic<bool> m_Indexing;
+        std::atomic<bool> m_Stop;
+    };
+
+    void IndexNewlines(const char* data, size_t begin, size_t end, std::vector<uint64_t>& starts); // Append the offset following each line break of data[begin, end).
+    /***********************************************************
+    *                      TEXT SEARCH                         *
+    ***********************************************************/
+
+    struct TextMatch {
+        size_t m_Line;
+        size_t m_Offset; // Position of the match in the line (in bytes).
+        size_t m_Length; // Length of the match (in bytes).
+    };
+
+    // Matches of a query in the lines of a log file, searched on a background thread. The matches are
+    // published after each chunk of lines, so they can be displayed while the rest of the file is searched.
+    class TextSearch {
+    public:
+        TextSearch() : m_Flags(TEXT_SEARCH_FLAGS_NONE), m_Valid(true), m_Log(nullptr), m_LogResets(0), m_SearchedLines(0), m_SearchedSize(0), m_Generation(0), m_Searching(false) {}
+        TextSearch(const TextSearch&) = delete;
+        TextSearch& operator=(const TextSearch&) = delete;
+        ~TextSearch();
+
+        bool Search(LogFile& log, std::string_view query, TextSearchFlags flags = TEXT_SEARCH_FLAGS_NONE); // Restarts the search if the query changed, or searches the appended lines (to call every frame). Returns false if the query is an invalid regex.
+        void Cancel(); // Stops the search and removes the matches (must be called before closing the file).
+        bool IsSearching() const { return m_Searching; }
+        size_t GetSearchedLines() const { return m_SearchedLines; } // Number of complete lines searched so far.
+
+        size_t GetMatchCount();
+        TextMatch GetMatch(size_t index);
+        size_t FindMatch(size_t line); // Returns the index of the first match at or after a line (the number of matches if there is none).
+        void GetLineMatches(size_t line, std::vector<TextMatch>& matches); // Appends the matches found in a line.
+
+        std::string m_Query;
+        TextSearchFlags m_Flags;
+        bool m_Valid; // Whether the query is a valid regex.
+
+    private:
+        void Start(size_t firstLine);
+        void Stop();
+        void SearchLines(const std::vector<uint64_t>& bounds, size_t firstLine, std::vector<TextMatch>& matches) const;
+
+        LogFile* m_Log;
+        size_t m_LogResets; // Resets of the file when the search started from its first line.
+        std::optional<std::regex> m_Regex;
+        std::thread m_Worker;
+        std::mutex m_Mutex;
+        std::vector<TextMatch> m_Matches; // Matches ordered by line and offset, guarded by m_Mutex.
+        std::atomic<size_t> m_SearchedLines;
+        std::atomic<size_t> m_SearchedSize; // Size of the indexed data when the last search finished.
+        std::atomic<uint64_t> m_Generation; // Incremented to cancel the running search.
+        std::atomic<bool> m_Searching;
+    };
+
+    size_t FindSubstring(std::string_view text, std::string_view query, size_t from = 0, bool ignoreCase = false); // Returns the position of the first occurrence of query after from (or std::string_view::npos).
+
+    bool LogView(const std::string& id, LogFile& log, vec2 size, size_t* selected, LogViewFlags flags = LOG_VIEW_FLAGS_FOLLOW, TextSearch* search = nullptr); // Print the visible lines of a log file, following the appended lines (and highlighting the matches of a search).
+
+    /***********************************************************
+    *                      TEXT EDITOR                         *
+    ***********************************************************/
+
+    // Text stored as a piece table: the pieces refer to the original text or to the inserted text, which
+    // is only appended to. They are kept in a persistent balanced tree (treap) ordered by position, where
+    // an edit only copies the O(log n) nodes on its path, so previous versions are kept for undo/redo.
+    class TextBuffer {
+    public:
+        struct Piece {
+            bool m_Added; // Whether the piece refers to the inserted text instead of the original one.
+            size_t m_Start;
+            size_t m_Length;
+            size_t m_Newlines;
+        };
+
+        struct Node {
+            Piece m_Piece;
+            uint32_t m_Priority;
+            size_t m_Length; // Length of the subtree.
+            size_t m_Newlines; // Number of line breaks in the subtree.
+            std::shared_ptr<const Node> m_Left;
+            std::shared_ptr<const Node> m_Right;
+        };
+        using NodePtr = std::shared_ptr<const Node>;
+
+        struct Snapshot {
+            NodePtr m_Root;
+            size_t m_Cursor;
+            size_t m_Anchor;
+        };
+
+        TextBuffer(std::string_view text = "");
+        ~TextBuffer() = default;
+
+        void SetText(std::string_view text); // Replaces the whole text and clears the history.
+        bool LoadFile(const std::string& path); // Replaces the whole text with the content of a file.
+        std::string GetText() const;
+
+        size_t GetSize() const;
+        size_t GetLineCount() const;
+        size_t GetLineStart(size_t line) const;
+        size_t GetLineEnd(size_t line) const; // Returns the offset of the line break ending a line (or the size of the text).
+        size_t GetLineOfOffset(size_t offset) const;
+        void GetRange(size_t offset, size_t length, std::string& out) const; // Replaces out with a part of the text.
+
+        void Insert(size_t offset, std::string_view text);
+        void Erase(size_t offset, size_t length);
+        void EraseSelection();
+        bool Undo();
+        bool Redo();
+        void BreakUndoGroup(); // Starts a new undo step at the next edit, even if it continues the last one.
+
+        bool HasSelection() const { return m_Cursor != m_Anchor; }
+
+        size_t m_Cursor; // Offset of the cursor (in bytes).
+        size_t m_Anchor; // Other end of the selection, equal to the cursor if nothing is selected.
+        int m_PreferredColumn; // Column kept when moving between lines of different widths (-1 if unset).
+        size_t m_ScrollLine; // First visible line.
+        int m_ScrollColumn; // First visible column.
+
+    private:
+        enum class EditKind { NONE, INSERT, ERASE };
+
+        NodePtr MakeNode(const Piece& piece, uint32_t priority, NodePtr left, NodePtr right) const;
+        std::pair<NodePtr, NodePtr> Split(const NodePtr& node, size_t offset);
+        NodePtr Merge(const NodePtr& left, const NodePtr& right) const;
+        Piece MakePiece(bool added, size_t start, size_t length) const;
+        size_t FindNewline(size_t index) const; // Returns the offset of the n-th line break (starting at 1).
+        void Collect(const NodePtr& node, size_t begin, size_t end, size_t base, std::string& out) const;
+        void PushUndo();
+        uint32_t NextPriority();
+
+        std::string m_Original;
+        std::string m_Added;
+        std::vector<uint64_t> m_OriginalLines; // Offsets following each line break of the original text.
+        std::vector<uint64_t> m_AddedLines; // Offsets following each line break of the inserted text.
+        NodePtr m_Root;
+        std::vector<Snapshot> m_UndoStack;
+        std::vector<Snapshot> m_RedoStack;
+        EditKind m_LastEdit;
+        size_t m_LastEditOffset;
+        uint32_t m_Seed;
+    };
+
+    bool EditText(TextBuffer& buffer, char32_t keyCode, size_t pageLines); // Applies a key pressed in a text editor, returns true if the text changed.
+    bool TextEditor(const std::string& id, TextBuffer& buffer, vec2 size, ContainerFlags flags = CONTAINER_FLAGS_NONE); // Print a multi-line text editor, only drawing its visible lines. Returns true if the text changed.
+
+    /***********************************************************
+    *                        TREE VIEW                         *
+    ***********************************************************/
+
+    struct TreeItem {
+        uint64_t m_Id; // Given back to the provider to list the children of the item (0 is used for the roots).
+        std::string m_Label;
+        bool m_HasChildren;
+    };
+
+    // Hierarchy whose children are only requested from a provider when their parent is expanded, on a background thread.
+    // The visible nodes are kept in a flattened list of rows, which is only updated around the expanded or collapsed node.
+    class TreeData {
+    public:
+        using Provider = std::function<void(uint64_t id, std::vector<TreeItem>& children)>; // Fill the children of an item, called from a background thread.
+
+        struct Node {
+            TreeItem m_Item;
+            uint32_t m_Parent;
+            uint32_t m_FirstChild; // Children are stored next to each other once loaded.
+            uint32_t m_ChildCount;
+            uint16_t m_Depth;
+            bool m_Loaded;
+            bool m_Loading;
+            bool m_Expanded;
+        };
+
+        TreeData(Provider provider); // The roots are requested right away.
+        TreeData(const TreeData&) = delete;
+        TreeData& operator=(const TreeData&) = delete;
+        ~TreeData();
+
+        void Expand(size_t row); // Shows the children of a row, they are loaded in the background the first time.
+        void Collapse(size_t row);
+        void Toggle(size_t row);
+        bool Poll(); // Inserts the children loaded in the background, returns true if the rows changed.
+        void Wait(); // Waits until all the requested children are loaded (they are inserted by Poll).
+        bool IsLoading();
+
+        size_t GetRowCount() const { return m_Rows.size(); }
+        const Node& GetNode(size_t row) const { return m_Nodes[m_Rows[row]]; }
+        size_t GetRow(uint32_t node) const; // Returns the row of a node, or the number of rows if it is hidden.
+
+        std::deque<Node> m_Nodes; // Loaded nodes, the first one is the invisible root (a deque never moves them when growing).
+        std::vector<uint32_t> m_Rows; // Indices of the visible nodes, in display order.
+
+    private:
+        struct Request {
+            uint32_t m_Node;
+            uint64_t m_Id;
+            uint16_t m_Depth;
+        };
+
+        void Load(uint32_t node);
+        void Work();
+        void InsertRows(size_t position, uint32_t node); // Inserts the visible descendants of a node at a row.
+
+        Provider m_Provider;
+        std::thread m_Worker;
+        std::mutex m_Mutex;
+        std::vector<Request> m_Requests; // Nodes whose children must be loaded, guarded by m_Mutex.
+        std::vector<std::pair<uint32_t, std::vector<Node>>> m_Results; // Loaded children waiting for Poll, guarded by m_Mutex.
+        bool m_Working; // Guarded by m_Mutex.
+        bool m_Stop; // Guarded by m_Mutex.
+    };
+
+    bool Tree(const std::string& id, TreeData& data, vec2 size, size_t* selected, ContainerFlags flags = CONTAINER_FLAGS_NONE); // Print a tree, only drawing its visible rows (RIGHT/LEFT expand and collapse, ENTER toggles).
+
+    /***********************************************************
+    *                      FUZZY FILTER                        *
+    ***********************************************************/
+
+    struct FuzzyMatch {
+        uint32_t m_Index; // Index of the entry.
+        int m_Score;
+    };
+
+    // Entries filtered by a fuzzy query on background threads, best matches first. When the query
+    // only gets longer, the previous matches are scored again instead of all the entries.
+    class FuzzyFilter {
+    public:
+        FuzzyFilter() : m_Generation(0) {}
+        FuzzyFilter(const FuzzyFilter&) = delete;
+        FuzzyFilter& operator=(const FuzzyFilter&) = delete;
+        ~FuzzyFilter();
+
+        void SetEntries(const std::vector<std::string>& entries);
+        void Filter(std::string_view query); // Score the entries against a query in the background.
+        bool Poll(); // Swaps in the matches computed in the background, returns true if they changed.
+        void Wait(); // Waits for the background job to finish.
+        bool IsBusy();
+
+        size_t GetEntryCount() const { return m_Masks.size(); }
+        std::string_view GetEntry(size_t index) const { return std::string_view(m_Text).substr(m_Offsets[index], m_Offsets[index + 1] - m_Offsets[index]); }
+        size_t GetMatchCount() const { return m_Matches.size(); }
+        std::string_view GetMatch(size_t index) const { return GetEntry(m_Matches[index].m_Index); }
+
+        std::string m_Text; // Entries stored one after the other, so that they are scanned without following pointers.
+        std::vector<size_t> m_Offsets; // Start of each entry in the text, followed by the end of the last one.
+        std::vector<uint64_t> m_Masks; // Characters contained by each entry, to reject most of them without scanning.
+        std::vector<FuzzyMatch> m_Matches; // Sorted by decreasing score, then by index.
+        std::string m_Query; // Last requested query.
+        std::string m_MatchedQuery; // Lowercase query of the displayed matches.
+
+    private:
+        void Cancel();
+        std::vector<FuzzyMatch> ComputeMatches(uint64_t generation, const std::string& query, const std::vector<uint32_t>* candidates) const;
+
+        std::thread m_Worker;
+        std::mutex m_Mutex;
+        std::optional<std::pair<std::string, std::vector<FuzzyMatch>>> m_Pending; // Query and result of the background job, guarded by m_Mutex.
+        std::atomic<uint64_t> m_Generation; // Incremented to cancel the running job.
+    };
+
+    void SortFuzzyMatches(std::vector<FuzzyMatch>& matches); // Sort matches by decreasing score, keeping the order of equal ones.
+    uint64_t FuzzyMask(std::string_view text); // Returns a bit for each kind of character of a text (case-insensitive).
+    int FuzzyScore(std::string_view text, std::string_view query, std::vector<size_t>* positions = nullptr); // Score a lowercase query as a subsequence of text, or -1 if it does not match.
+    bool FuzzyPicker(const std::string& id, FuzzyFilter& filter, vec2 size, size_t* selected, ContainerFlags flags = CONTAINER_FLAGS_NONE); // Print a query input above the matching entries. Returns true when an entry is picked with enter.
+
+    /***********************************************************
+    *                         CANVAS                           *
+    ***********************************************************/
+
+    // Bit of each pixel of a braille cell, the dots are numbered by column (1, 2, 3, 7 then 4, 5, 6, 8).
+    constexpr uint8_t BRAILLE_DOTS[4][2] = { { 0x01, 0x08 }, { 0x02, 0x10 }, { 0x04, 0x20 }, { 0x40, 0x80 } };
+
+    // Pixels packed in one byte per cell (the bits of braille dots, or the two halves of a block),
+    // whose glyphs are only computed again when they changed.
+    class CanvasData {
+    public:
+        CanvasData(vec2 size = vec2(0, 0), CanvasFlags flags = CANVAS_FLAGS_NONE); // Size in cells.
+        ~CanvasData() = default;
+
+        void Resize(vec2 size);
+        void Clear();
+        void SetColor(std::optional<Color> color) { m_Color = color; } // Color of the cells drawn from now on.
+
+        vec2 GetPixelSize() const { return m_PixelSize; }
+        bool GetPixel(int x, int y) const;
+        void SetPixel(int x, int y, bool on = true); // Pixels out of the canvas are ignored.
+
+        void DrawLine(vec2 from, vec2 to);
+        void DrawRect(vec2 pos, vec2 size);
+        void FillRect(vec2 pos, vec2 size);
+        void DrawCircle(vec2 center, int radius);
+        void FillCircle(vec2 center, int radius);
+        void Fill(vec2 pos); // Turns on the pixels connected to an unset pixel.
+
+        const std::vector<char32_t>& GetGlyphs(); // Returns the glyph of each cell (0 if empty).
+
+        vec2 m_Size; // Size in cells.
+        vec2 m_PixelSize;
+        CanvasFlags m_Flags;
+        std::vector<uint8_t> m_Cells;
+        std::vector<std::optional<Color>> m_Colors;
+        std::optional<Color> m_Color;
+
+    private:
+        void FillSpan(int x0, int x1, int y); // Turns on the pixels [x0, x1] of a row.
+
+        std::vector<char32_t> m_Glyphs;
+        bool m_Dirty;
+    };
+
+    void ConvertBrailleCells(const uint8_t* cells, char32_t* glyphs, size_t count); // Turn dot bits into braille characters (0 if empty).
+    void Canvas(CanvasData& canvas); // Print a canvas at the cursor.
+
+    /***********************************************************
+    *                         CHARTS                           *
+    ***********************************************************/
+
+    constexpr size_t SERIES_BLOCK_SIZE = 64; // Number of samples summarized by each block of a series.
+
+    // Ring buffer of samples that keeps the minimum and maximum of each block of samples, so that
+    // appending a sample is O(1) and a range is reduced without reading most of its samples.
+    class SeriesBuffer {
+    public:
+        SeriesBuffer(size_t capacity = 1024);
+        ~SeriesBuffer() = default;
+
+        void Push(float value); // Append a sample, replacing the oldest one when the buffer is full.
+        void Clear();
+
+        size_t GetSize() const { return m_Size; }
+        size_t GetCapacity() const { return m_Samples.size(); }
+        float At(size_t index) const { return m_Samples[(m_Start + index) % m_Samples.size()]; } // Index 0 is the oldest sample.
+        void GetRange(size_t first, size_t last, float& min, float& max) const; // Extend min and max with the samples [first, last).
+
+        std::vector<float> m_Samples;
+        size_t m_Start; // Position of the oldest sample.
+        size_t m_Size;
+        uint64_t m_PushCount; // Number of samples pushed since the last clear, used to number the blocks.
+
+    private:
+        std::vector<float> m_BlockMin;
+        std::vector<float> m_BlockMax;
+    };
+
+    void FindMinMax(const float* data, size_t count, float& min, float& max); // Extend min and max with values (NaN are ignored).
+    template <typename Func> void DownsampleLTTB(size_t count, size_t threshold, Func&& at, std::vector<size_t>& indices); // Select threshold samples keeping the shape of the series, at(index) returns a sample.
+
+    void LineChart(const std::string& id, std::span<const float> samples, vec2 size, ChartFlags flags = CHART_FLAGS_NONE, std::optional<Color> color = std::nullopt); // Print a line chart of size cells, downsampled to its pixels.
+    void LineChart(const std::string& id, const SeriesBuffer& series, vec2 size, ChartFlags flags = CHART_FLAGS_NONE, std::optional<Color> color = std::nullopt);
+    void Sparkline(std::span<const float> samples, int width, std::optional<Color> color = std::nullopt); // Print the maximum of each column with block characters.
+    void Sparkline(const SeriesBuffer& series, int width, std::optional<Color> color = std::nullopt);
+
+    template <typename RangeFunc, typename AtFunc> void PlotSeries(CanvasData& canvas, size_t count, ChartFlags flags, RangeFunc&& range, AtFunc&& at); // Draw a series in a canvas, range(first, last, min, max) extends min and max with samples.
+    template <typename RangeFunc> void DrawSparkline(size_t count, int width, std::optional<Color> color, RangeFunc&& range);
 
     /***********************************************************
     *                    STRING FUNCTIONS                      *
@@ -467,7 +1407,9 @@ namespace tuim {
     uint8_t Utf8CharLength(char c); // Returns the expected UTF-8 length of a specific character
     std::string Utf8Char32ToString(char32_t ch); // Returns a string from a UTF-8 character
     char32_t Utf8Decode(const char* bytes, size_t length); // Returns a 32 bytes UTF-8 character from an array of bytes
-    void Utf8IterateString(std::string_view sv, std::function<void(char32_t, size_t)> func); // Iterate over UTF-8 characters in a regular string
+    uint8_t Utf8DecodeNext(std::string_view sv, size_t index, char32_t& ch); // Decode the character at index and returns its length (invalid bytes are decoded as U+FFFD).
+    template <typename Func> void Utf8IterateString(std::string_view sv, Func&& func); // Iterate over UTF-8 characters in a regular string, calling func(ch, index)
+    void Utf8DecodeString(std::string_view sv, std::u32string& chars, std::vector<uint32_t>* offsets); // Decode a whole string, with the byte offset of each character (and the string size at the end).
     ItemId StringToId(std::string_view sv); // Hash a string to get an integer.
     bool IsPrintable(char32_t ch); // Determines if a character is "printable".
 
@@ -477,7 +1419,102 @@ namespace tuim {
     bool IsDigit(const std::string& str);
     bool IsAlphaNumeric(const std::string& str);
 
-    size_t CalcTextWidth(std::string_view sv);
+    size_t CalcTextWidth(std::string_view sv); // Returns the width of the largest line of a text (cached by content).
+    size_t CalcPlainTextWidth(std::string_view sv); // Returns the width of a single line of text, without parsing formatting tags.
+
+    /***********************************************************
+    *                       TEXT CACHE                         *
+    ***********************************************************/
+
+    struct TextMetrics {
+        size_t m_Width; // Width of the largest line.
+        std::vector<size_t> m_LineWidths; // Width of each line (separated by line breaks).
+        std::vector<size_t> m_LineStarts; // Byte offset of the start of each line.
+    };
+
+    TextMetrics CalcTextMetrics(std::string_view sv); // Measures each line of a text, without using the cache.
+    const TextMetrics& GetTextMetrics(std::string_view sv); // Returns the width and the line breaks of a text (cached by content).
+
+    // Bounded map from a text content to a value. The least recently used entries are evicted first.
+    template <typename T> class LruCache {
+    public:
+        using Entry = std::pair<std::string, T>;
+
+        LruCache(size_t capacity) : m_Capacity(capacity), m_Hits(0), m_Misses(0) {}
+        ~LruCache() = default;
+
+        T* Find(std::string_view key); // Returns the value of a key (or nullptr) and marks it as recently used.
+        T& Insert(std::string_view key, T value); // Adds a value to the cache, evicting old entries if it is full.
+        void SetCapacity(size_t capacity); // Changes the maximum number of entries.
+        void Clear();
+
+        size_t m_Capacity;
+        size_t m_Hits;
+        size_t m_Misses;
+        std::list<Entry> m_Entries; // Entries ordered from the most to the least recently used.
+        std::unordered_map<std::string_view, typename std::list<Entry>::iterator> m_Index; // Keys are views over the entries keys.
+    };
+
+    // Cache of text measurements keyed by the text content so that static labels only cost a lookup per frame.
+    class TextCache : public LruCache<TextMetrics> {
+    public:
+        TextCache(size_t capacity = 4096) : LruCache<TextMetrics>(capacity) {}
+        ~TextCache() = default;
+
+        const TextMetrics& Get(std::string_view sv); // Returns the measurements of a text, measuring it if needed (0 capacity disables the cache).
+
+        TextMetrics m_Uncached; // Last measurement when the cache is disabled.
+    };
+
+    /***********************************************************
+    *                         UNICODE                          *
+    ***********************************************************/
+
+    // Grapheme_Cluster_Break property values (see UAX #29).
+    enum class GraphemeBreak : uint8_t {
+        OTHER = 0,
+        CR,
+        LF,
+        CONTROL,
+        EXTEND,
+        ZWJ,
+        REGIONAL_INDICATOR,
+        PREPEND,
+        SPACING_MARK,
+        L,
+        V,
+        T,
+        LV,
+        LVT,
+        EXTENDED_PICTOGRAPHIC,
+    };
+
+    struct GraphemeBreakRange {
+        char32_t first;
+        char32_t last;
+        GraphemeBreak value;
+    };
+
+    GraphemeBreak GetGraphemeBreak(char32_t ch); // Returns the grapheme cluster break property of a character.
+    bool IsGraphemeBreak(GraphemeBreak prev, GraphemeBreak next, bool pictographicZwj, size_t regionalCount); // Determines if a cluster ends between two characters.
+
+    // State of the segmentation of a grapheme cluster, fed one character at a time.
+    struct GraphemeSegmenter {
+        GraphemeSegmenter(char32_t first);
+
+        bool Next(char32_t ch); // Returns true if the character starts a new cluster, otherwise adds it to the current one.
+
+        GraphemeBreak m_Prev;
+        bool m_Pictographic; // The cluster ends with ExtPict Extend*
+        bool m_PictographicZwj; // The cluster ends with ExtPict Extend* ZWJ
+        size_t m_RegionalCount; // Number of consecutive regional indicators at the end of the cluster.
+    };
+
+    size_t GraphemeLength(std::u32string_view chars, size_t index); // Returns the number of characters of the grapheme cluster starting at index.
+    size_t Utf8GraphemeLength(std::string_view sv, size_t index); // Returns the length in bytes of the grapheme cluster starting at index.
+    size_t Utf8FitWidth(std::string_view sv, int maxWidth); // Returns the length in bytes of the grapheme clusters at the start of a line that fit in maxWidth columns.
+    std::u32string Utf8DecodeString(std::string_view sv); // Returns the UTF-32 characters of a regular string.
+    int GraphemeWidth(std::u32string_view cluster); // Returns the width (in columns) of a grapheme cluster.
 
     /**********************************************************
     *                        CONTEXT                          *
@@ -492,13 +1529,23 @@ namespace tuim {
             m_Frame = std::make_shared<Frame>();
             m_PrevFrame = nullptr;
             m_DefaultContainer = std::make_shared<Container>(m_Frame, CONTAINER_FLAGS_BORDERLESS);
-            m_DefaultContainer->m_Size = tuim::Terminal::GetTerminalSize();
+            m_TerminalSize = tuim::Terminal::GetTerminalSize();
+            m_DefaultContainer->m_Size = m_TerminalSize;
             m_DefaultContainer->m_Pos = vec2(0, 0);
 
             m_HoveredItemId = 0;
             m_ActiveItemId = 0;
             m_LastActiveItemId = 0;
 
+            m_FrameCount = 0;
+            m_StateLifetime = 60;
+            m_SpatialNavigation = NAVIGATION_FLAGS_NONE;
+            m_MouseEnabled = false;
+            m_CaptureSignalKeys = false;
+            m_SignalKeysCaptured = false;
+            m_PasteLength = 0;
+            m_Pasting = false;
+
             m_CurrentForeground = std::nullopt;
             m_CurrentBackground = std::nullopt;
             m_CurrentStyle = Style::NONE;
@@ -510,18 +1557,54 @@ namespace tuim {
         std::shared_ptr<Container> m_DefaultContainer; // Default container object that represents the screen frame.
         std::shared_ptr<Frame> m_Frame; // Final screen frame that is going to be displayed to the screen.
         std::shared_ptr<Frame> m_PrevFrame; // Last displayed frame to compare with when building the new one.
+        vec2 m_TerminalSize; // Size of the terminal, only read once per frame by Clear().
         std::vector<std::shared_ptr<Item>> m_ItemsOrdered; // Insertion order of items.
         std::unordered_map<ItemId, std::shared_ptr<Item>> m_Items; // Mapped addresses of the frame items.
         std::stack<ItemId> m_ContainersStack;
+        std::vector<LayoutScope> m_LayoutsStack;
         ItemId m_HoveredItemId; // Id of the item hovered during current frame.
         ItemId m_ActiveItemId; // Id of the active item during current frame.
         ItemId m_LastActiveItemId; // Id of the active item during last frame
 
+        // Frames of the layers drawn over the screen frame, kept between frames and cleared when a layer is used again.
+        std::array<std::shared_ptr<Frame>, LAYER_COUNT> m_Layers;
+        std::array<bool, LAYER_COUNT> m_LayersUsed = {}; // Whether each layer is used during current frame.
+        std::array<std::vector<rect>, LAYER_COUNT> m_OpaqueAreas; // Areas of the containers of each layer, hiding everything below.
+        std::vector<rect> m_CullingAreas; // Opaque areas of the upper layers during last frame, the base containers inside them are not drawn.
+        std::vector<rect> m_CulledAreas; // Areas of the base containers that have not been drawn during current frame.
+        bool m_CullingDisabled = false; // Set when the last frame has not been displayed because some culled containers were visible.
+        std::stack<Layer> m_LayersStack;
+        std::vector<uint8_t> m_Coverage; // Cells covered by an upper layer while composing (kept cleared between frames).
+
         // Current active styles applied during Print operations
         std::optional<Color> m_CurrentForeground;
         std::optional<Color> m_CurrentBackground;
         Style m_CurrentStyle;
 
+        // Grapheme clusters referenced by the cells of the current and last displayed frames.
+        ClusterPool m_Clusters;
+        ClusterPool m_PrevClusters;
+
+        TextCache m_TextCache; // Measurements of the texts printed during the last frames.
+        LruCache<ParagraphLayout> m_ParagraphCache = LruCache<ParagraphLayout>(256); // Layouts of the paragraphs printed during the last frames.
+
+        // States of the items retained between frames, one pool per type of state.
+        std::vector<std::unique_ptr<StatePoolBase>> m_StatePools;
+        uint64_t m_FrameCount;
+        uint32_t m_StateLifetime;
+
+        NavigationFlags m_SpatialNavigation; // Arrows moving the focus by position instead of order.
+        ItemIndex m_ItemIndex; // Areas of the items, filled as they are added.
+
+        std::string m_Input; // Bytes read from the terminal that have not been parsed into keys yet.
+        bool m_MouseEnabled;
+        bool m_CaptureSignalKeys; // Whether a widget needs the keys that send signals during this frame.
+        bool m_SignalKeysCaptured; // Whether the terminal currently delivers these keys instead of signals.
+        MouseEvent m_MouseEvent; // Last mouse event read.
+        std::string_view m_Paste; // Text pasted during this frame, it stays in the input until the next poll.
+        size_t m_PasteLength; // Bytes of the paste (with its markers) to remove from the input at the next poll.
+        bool m_Pasting; // Whether the end marker of the current paste has not been read yet, the next input is still pasted text.
+
         // User-defined style maps.
         std::unordered_map<char, Style> m_UserStyles;
         std::unordered_map<char, Color> m_UserColors;
@@ -564,84 +1647,166 @@ inline char32_t tuim::PollKeyCode() {
     newState.c_cc[VTIME] = 0;
     tcsetattr(STDIN_FILENO, TCSANOW, &newState);
 
-    // Wait for an input using a timeout.
-    fd_set set;
-    FD_ZERO(&set);
-    FD_SET(STDIN_FILENO, &set);
-    timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = ((int) (1000 / ctx->m_Framerate)) * 1000;
-    
-    if (select(STDIN_FILENO + 1, &set, NULL, NULL, &timeout) != 1) {
+    // The text pasted during the last frame is only removed now, so that it is never copied.
+    ctx->m_Input.erase(0, ctx->m_PasteLength);
+    ctx->m_PasteLength = 0;
+    ctx->m_Paste = std::string_view();
+
+    // Wait for an input using a timeout, unless there are bytes left from the last read.
+    if (ctx->m_Input.empty() && !tuim::Terminal::ReadInput(ctx->m_Input, ((int) (1000 / ctx->m_Framerate)) * 1000)) {
         tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
         return 0;
     }
-    
-    char buffer[4] = {0};
-    ssize_t totalBytes = 0;
-    ssize_t expectedBytes = 0;
 
-    // Read the first byte.
-    if (read(STDIN_FILENO, &buffer[0], 1) != 1) {
+    // Wait a bit for the rest of an incomplete key, if nothing comes a lone escape is the Escape key.
+    char32_t keyCode = 0;
+    MouseEvent mouse;
+    std::string_view paste;
+    size_t length = 0;
+    auto IsPasting = [ctx]() { return ctx->m_Pasting || ctx->m_Input.starts_with("\033[200~"); };
+    if (!IsPasting()) {
+        length = tuim::ParseKeyCode(ctx->m_Input, keyCode, mouse, &paste);
+        while (length == 0 && !IsPasting() && tuim::Terminal::ReadInput(ctx->m_Input, 1000 * 5))
+            length = tuim::ParseKeyCode(ctx->m_Input, keyCode, mouse, &paste);
+    }
+
+    if (length == 0 && IsPasting()) {
+        // A paste is read until its end marker, it may take several reads for long texts (only the new bytes are searched).
+        // If the marker does not come in time, the text read so far is given as a paste, and the next polls give the rest.
+        const std::string_view marker = "\033[201~";
+        size_t start = ctx->m_Pasting ? 0 : 6;
+        size_t scanned = start;
+        size_t end = std::string::npos;
+        do {
+            end = ctx->m_Input.find(marker, std::max(start, scanned - std::min(scanned, marker.size() - 1)));
+            scanned = ctx->m_Input.size();
+        } while (end == std::string::npos && tuim::Terminal::ReadInput(ctx->m_Input, 1000 * 100));
+
+        // The beginning of an end marker split between two reads is left for the next poll.
+        size_t textEnd = ctx->m_Input.size();
+        for (size_t k = marker.size() - 1; end == std::string::npos && k > 0; k--) {
+            if (textEnd - start >= k && std::string_view(ctx->m_Input).ends_with(marker.substr(0, k))) {
+                textEnd -= k;
+                break;
+            }
+        }
+        if (end != std::string::npos)
+            textEnd = end;
+        ctx->m_Pasting = (end == std::string::npos);
+        ctx->m_Paste = std::string_view(ctx->m_Input).substr(start, textEnd - start);
+        ctx->m_PasteLength = (end != std::string::npos) ? end + marker.size() : textEnd;
+        keyCode = !ctx->m_Paste.empty() ? static_cast<char32_t>(Key::PASTE) : 0;
+    }
+    else if (length == 0) {
+        keyCode = (ctx->m_Input.front() == Key::ESCAPE) ? static_cast<char32_t>(Key::ESCAPE) : 0;
+        ctx->m_Input.erase(0, 1);
+    }
+    else if (keyCode == Key::PASTE) {
+        ctx->m_Paste = paste;
+        ctx->m_PasteLength = length;
+    }
+    else ctx->m_Input.erase(0, length);
+
+    // Only the last of the consecutive motions of the mouse is kept, so that they do not take a frame each.
+    if (keyCode == Key::MOUSE && mouse.m_Action == MOUSE_ACTION_MOVE) {
+        tuim::Terminal::ReadInput(ctx->m_Input, 0);
+        char32_t nextKeyCode = 0;
+        MouseEvent nextMouse;
+        while ((length = tuim::ParseKeyCode(ctx->m_Input, nextKeyCode, nextMouse)) != 0 && nextKeyCode == Key::MOUSE && nextMouse.m_Action == MOUSE_ACTION_MOVE) {
+            mouse = nextMouse;
+            ctx->m_Input.erase(0, length);
+        }
+    }
+    if (keyCode == Key::MOUSE)
+        ctx->m_MouseEvent = mouse;
+
+    // Ctrl+C does not send a signal while the keys are captured, it still has to interrupt the program.
+    if (keyCode == Key::CTRL_C && ctx->m_SignalKeysCaptured) {
         tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
+        std::raise(SIGINT);
         return 0;
     }
-    totalBytes = 1;
 
-    // Handle Escape sequences by initializing the number of expected bytes
-    // to 5 in order to avoid the next step of calculating expected bytes
-    // for UTF8 characters.
-    // TODO: handle special keys better, including F6, F7... which are 5 bytes escape sequences.
-    if (static_cast<unsigned char>(buffer[0]) == Key::ESCAPE) {
-        expectedBytes = 5;
+    // Restore original terminal flags.
+    tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
 
-        fd_set seqSet;
-        FD_ZERO(&seqSet);
-        FD_SET(STDIN_FILENO, &seqSet);
+    return keyCode;
+}
 
-        timeval seqTimeout;
-        seqTimeout.tv_sec = 0;
-        seqTimeout.tv_usec = 1000 * 5;
+inline size_t tuim::ParseKeyCode(std::string_view input, char32_t& keyCode, MouseEvent& mouse, std::string_view* paste) {
+    if (input.empty())
+        return 0;
 
-        // if there are no more bytes to come, then it is a single Escape key.
-        if (select(STDIN_FILENO + 1, &seqSet, NULL, NULL, &seqTimeout) != 1) {
-            tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
-            return Key::ESCAPE;
+    // UTF-8 characters, the length is given by the first byte.
+    unsigned char first = input[0];
+    if (first != Key::ESCAPE) {
+        size_t length = 1;
+        if ((first & 0xE0) == 0xC0) length = 2;
+        else if ((first & 0xF0) == 0xE0) length = 3;
+        else if ((first & 0xF8) == 0xF0) length = 4;
+        else if ((first & 0x80) != 0x00) {
+            // Invalid UTF-8 start byte.
+            keyCode = 0;
+            return 1;
         }
-
-        // Reset the timeout.
-        select(STDIN_FILENO + 1, &set, NULL, NULL, &timeout);
+        if (input.size() < length)
+            return 0;
+        keyCode = tuim::Utf8Decode(input.data(), length);
+        return length;
     }
 
-    // Determine the expected number of bytes left to read (if it isn't an escape sequence).
-    if (expectedBytes == 0) {
-        char8_t first = buffer[0];
-        if ((first & 0x80) == 0x00) expectedBytes = 1;  // ASCII
-        else if ((first & 0xE0) == 0xC0) expectedBytes = 2; // 2-byte UTF-8
-        else if ((first & 0xF0) == 0xE0) expectedBytes = 3; // 3-byte UTF-8
-        else if ((first & 0xF8) == 0xF0) expectedBytes = 4; // 4-byte UTF-8
-        else {  // Invalid UTF-8 start byte
-            tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
+    // Escape sequences: "ESC [ parameters final" (CSI), "ESC O final" (SS3) or ESC followed by a character.
+    if (input.size() < 2)
+        return 0;
+    size_t length = 2;
+    if (input[1] == '[') {
+        while (length < input.size() && (input[length] < 0x40 || input[length] > 0x7E))
+            length++;
+        if (length == input.size())
             return 0;
-        }
+        length++;
+    }
+    else if (input[1] == 'O') {
+        if (input.size() < 3)
+            return 0;
+        length = 3;
     }
 
-    // Read remaining bytes.
-    ssize_t readBytes = read(STDIN_FILENO, &buffer[totalBytes], std::min(expectedBytes, 4L)-totalBytes);
-    totalBytes += readBytes;
+    // Mouse events in SGR format: "ESC [ < button ; x ; y M" (pressed) or "m" (released).
+    if (length > 3 && input[2] == '<') {
+        int values[3] = { 0, 0, 0 };
+        std::string_view parameters = input.substr(3, length - 4);
+        for (int i = 0; i < 3; i++) {
+            std::from_chars(parameters.data(), parameters.data() + parameters.size(), values[i]);
+            size_t separator = parameters.find(';');
+            parameters.remove_prefix(separator == std::string_view::npos ? parameters.size() : separator + 1);
+        }
 
-    if (totalBytes != expectedBytes && expectedBytes != 5) {
-        tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
-        return 0;
+        // The low bits give the button, the next ones the modifiers, the motion and the wheel.
+        int button = values[0];
+        mouse.m_Pos = vec2(values[1] - 1, values[2] - 1);
+        mouse.m_Button = static_cast<MouseButton>(button & 3);
+        if (button & 64) mouse.m_Action = (button & 1) ? MOUSE_ACTION_WHEEL_DOWN : MOUSE_ACTION_WHEEL_UP;
+        else if (button & 32) mouse.m_Action = MOUSE_ACTION_MOVE;
+        else mouse.m_Action = (input[length - 1] == 'm') ? MOUSE_ACTION_RELEASE : MOUSE_ACTION_PRESS;
+        keyCode = Key::MOUSE;
+        return length;
     }
 
-    // Pack bytes into a 32 bits char.
-    char32_t keyCode = tuim::Utf8Decode(buffer, totalBytes);
-
-    // Restore original terminal flags.
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldState);
+    // Bracketed paste: "ESC [ 2 0 0 ~ text ESC [ 2 0 1 ~", the text is given as a view into the input.
+    if (input.substr(0, length) == "\033[200~") {
+        size_t end = input.find("\033[201~", length);
+        if (end == std::string_view::npos)
+            return 0;
+        if (paste != nullptr)
+            *paste = input.substr(length, end - length);
+        keyCode = Key::PASTE;
+        return end + 6;
+    }
 
-    return keyCode;
+    // Other sequences are packed into the key code (only their first 4 bytes for the longest ones).
+    keyCode = tuim::Utf8Decode(input.data(), std::min<size_t>(length, 4));
+    return length;
 }
 
 inline tuim::Key tuim::GetPressedKey() {
@@ -659,6 +1824,16 @@ inline bool tuim::IsKeyPressed(tuim::Key key) {
     return static_cast<tuim::Key>(ctx->m_PressedKeyCode) == key;
 }
 
+inline const tuim::MouseEvent& tuim::GetMouseEvent() {
+    Context* ctx = tuim::GetCtx();
+    return ctx->m_MouseEvent;
+}
+
+inline std::string_view tuim::GetPastedText() {
+    Context* ctx = tuim::GetCtx();
+    return ctx->m_Paste;
+}
+
 /***********************************************************
 *                         COLORS                           *
 ***********************************************************/
@@ -728,6 +1903,7 @@ inline void tuim::CreateContext() {
     tuim::Terminal::SetAlternateBuffer(true);
     tuim::Terminal::SetUserInputsVisibility(false);
     tuim::Terminal::SetCursorVisibility(false);
+    tuim::Terminal::SetBracketedPaste(true);
     tuim::Terminal::Clear();
     setlocale(LC_CTYPE, "");  // Enable Unicode processing
     tuim::ctx = new tuim::Context();
@@ -738,6 +1914,11 @@ inline void tuim::CreateContext(int argc, char* argv[]) {
 }
 
 inline void tuim::DeleteContext() {
+    if (tuim::ctx != nullptr && tuim::ctx->m_MouseEnabled)
+        tuim::Terminal::SetMouseReporting(false);
+    if (tuim::ctx != nullptr && tuim::ctx->m_SignalKeysCaptured)
+        tuim::Terminal::SetSignalKeys(true);
+    tuim::Terminal::SetBracketedPaste(false);
     tuim::Terminal::SetAlternateBuffer(false);
     tuim::Terminal::SetUserInputsVisibility(true);
     tuim::Terminal::SetCursorVisibility(true);
@@ -768,6 +1949,32 @@ inline void tuim::SetFramerate(float framerate) {
     ctx->m_Framerate = framerate;
 }
 
+inline void tuim::SetTextCacheCapacity(size_t capacity) {
+    Context* ctx = tuim::GetCtx();
+    ctx->m_TextCache.SetCapacity(capacity);
+}
+
+inline void tuim::SetStateLifetime(uint32_t frames) {
+    Context* ctx = tuim::GetCtx();
+    ctx->m_StateLifetime = frames;
+}
+
+inline void tuim::SetMouseEnabled(bool enabled) {
+    Context* ctx = tuim::GetCtx();
+    ctx->m_MouseEnabled = enabled;
+    tuim::Terminal::SetMouseReporting(enabled);
+}
+
+inline void tuim::CaptureSignalKeys() {
+    Context* ctx = tuim::GetCtx();
+    ctx->m_CaptureSignalKeys = true;
+}
+
+inline void tuim::SetSpatialNavigation(NavigationFlags flags) {
+    Context* ctx = tuim::GetCtx();
+    ctx->m_SpatialNavigation = flags;
+}
+
 inline void tuim::DefineStyle(char tag, Style style) {
     Context* ctx = tuim::GetCtx();
     ctx->m_UserStyles[tag] = style;
@@ -782,21 +1989,68 @@ inline void tuim::Update(char32_t keyCode) {
     Context* ctx = tuim::GetCtx();
     ctx->m_PressedKeyCode = keyCode;
 
+    // Only the items of the modal layer can be hovered while it has some.
+    bool hasModal = std::any_of(ctx->m_ItemsOrdered.begin(), ctx->m_ItemsOrdered.end(), [](const std::shared_ptr<Item>& item) {
+        return item->m_Layer == LAYER_MODAL && !(item->m_Flags & ITEM_FLAGS_DISABLED);
+    });
+    auto IsHoverable = [hasModal](const std::shared_ptr<Item>& item) {
+        return !(item->m_Flags & ITEM_FLAGS_DISABLED) && (!hasModal || item->m_Layer == LAYER_MODAL);
+    };
+
     uint32_t activeItemIndex = tuim::GetItemIndex(ctx->m_ActiveItemId);
-    if (ctx->m_ActiveItemId == 0
-        || activeItemIndex >= ctx->m_ItemsOrdered.size()
-        || !(ctx->m_ItemsOrdered.at(activeItemIndex)->m_Flags & ITEM_FLAGS_STAY_ACTIVE)) {
-            
+    bool isStayingActive = (ctx->m_ActiveItemId != 0
+        && activeItemIndex < ctx->m_ItemsOrdered.size()
+        && (ctx->m_ItemsOrdered.at(activeItemIndex)->m_Flags & ITEM_FLAGS_STAY_ACTIVE));
+
+    // The item below the mouse is hovered, pressed like with ENTER when clicked, and scrolled with the wheel.
+    if (keyCode == Key::MOUSE) {
+        const MouseEvent& mouse = ctx->m_MouseEvent;
+
+        // The upper layers are searched first, whatever the order in which the layers were drawn.
+        int index = -1;
+        for (int layer = LAYER_COUNT - 1; layer >= LAYER_BASE && index == -1; layer--) {
+            index = ctx->m_ItemIndex.FindAt(mouse.m_Pos, [&](size_t i) {
+                return i < ctx->m_ItemsOrdered.size() && ctx->m_ItemsOrdered.at(i)->m_Layer == layer && IsHoverable(ctx->m_ItemsOrdered.at(i));
+            });
+        }
+        ItemId itemId = (index != -1) ? ctx->m_ItemsOrdered.at(index)->m_Id : 0;
+        keyCode = 0;
+
+        if (mouse.m_Action == MOUSE_ACTION_PRESS && mouse.m_Button == MOUSE_BUTTON_LEFT && itemId != 0 && itemId != ctx->m_ActiveItemId) {
+            // Clicking another item leaves the active one, a click on the row of a list selects it first.
+            isStayingActive = false;
+            ScrollState* scrollState = tuim::FindState<ScrollState>(itemId);
+            if (scrollState != nullptr) {
+                int row = mouse.m_Pos.y - scrollState->m_Top;
+                if (row >= 0 && row < (int) scrollState->m_VisibleRows && scrollState->m_Offset + row < scrollState->m_RowCount)
+                    scrollState->m_Selected = scrollState->m_Offset + row;
+            }
+            ctx->m_HoveredItemId = itemId;
+            ctx->m_PressedKeyCode = keyCode = Key::ENTER;
+        }
+        else if (mouse.m_Action == MOUSE_ACTION_MOVE && itemId != 0 && !isStayingActive) {
+            ctx->m_HoveredItemId = itemId;
+        }
+        else if ((mouse.m_Action == MOUSE_ACTION_WHEEL_UP || mouse.m_Action == MOUSE_ACTION_WHEEL_DOWN) && itemId != 0) {
+            ScrollState* scrollState = tuim::FindState<ScrollState>(itemId);
+            for (int i = 0; scrollState != nullptr && i < 3; i++)
+                tuim::ScrollNavigate(*scrollState, mouse.m_Action == MOUSE_ACTION_WHEEL_UP ? Key::UP : Key::DOWN);
+        }
+    }
+
+    if (!isStayingActive) {
         ctx->m_LastActiveItemId = ctx->m_ActiveItemId;
         ctx->m_ActiveItemId = 0;
 
         int hoveredIndex = tuim::getHoveredItemIndex();
-        bool hasHoverable = tuim::HasHoverable();
+        if (hoveredIndex != -1 && !IsHoverable(ctx->m_ItemsOrdered.at(hoveredIndex)))
+            hoveredIndex = -1;
+        bool hasHoverable = std::any_of(ctx->m_ItemsOrdered.begin(), ctx->m_ItemsOrdered.end(), IsHoverable);
 
         // Set the first hoverable item hovered if no item is
         if (hoveredIndex == -1 && hasHoverable) {
             for(size_t i = 0; i < ctx->m_ItemsOrdered.size(); i++) {
-                if (!(ctx->m_ItemsOrdered.at(i)->m_Flags & ITEM_FLAGS_DISABLED)) {
+                if (IsHoverable(ctx->m_ItemsOrdered.at(i))) {
                     ctx->m_HoveredItemId = ctx->m_ItemsOrdered.at(i)->m_Id;
                     hoveredIndex = i;
                     break;
@@ -804,14 +2058,30 @@ inline void tuim::Update(char32_t keyCode) {
             }
         }
 
+        // Let the hovered list move its selection first, the hovered item only changes
+        // when going past its first or last row.
+        ScrollState* scrollState = tuim::FindState<ScrollState>(ctx->m_HoveredItemId);
+        if (hoveredIndex != -1 && scrollState != nullptr && tuim::ScrollNavigate(*scrollState, keyCode))
+            return;
+
+        // Move cursor to the nearest hoverable item in the direction of the arrow, if enabled.
+        bool isHorizontal = (keyCode == Key::LEFT || keyCode == Key::RIGHT) && (ctx->m_SpatialNavigation & NAVIGATION_FLAGS_HORIZONTAL);
+        bool isVertical = (keyCode == Key::UP || keyCode == Key::DOWN) && (ctx->m_SpatialNavigation & NAVIGATION_FLAGS_VERTICAL);
+        if (hoveredIndex != -1 && ((isHorizontal && !(ctx->m_ItemsOrdered.at(hoveredIndex)->m_Flags & ITEM_FLAGS_USE_LEFT_RIGHT)) || isVertical)) {
+            int index = ctx->m_ItemIndex.FindNearest(hoveredIndex, static_cast<Key>(keyCode), [&](size_t i) { return IsHoverable(ctx->m_ItemsOrdered.at(i)); });
+            if (index != -1)
+                ctx->m_HoveredItemId = ctx->m_ItemsOrdered.at(index)->m_Id;
+            return;
+        }
+
         // Move cursor to previous hoverable item
         if (keyCode == Key::UP) {
             if (hasHoverable) {
                 ItemId id = 0;
                 if (hoveredIndex != -1) {
                     size_t index = std::max(0, hoveredIndex - 1);
-                    while(index > 0 && (ctx->m_ItemsOrdered.at(index)->m_Flags & ITEM_FLAGS_DISABLED)) index--;
-                    if ((ctx->m_ItemsOrdered.at(index)->m_Flags & ITEM_FLAGS_DISABLED)) index = hoveredIndex;
+                    while(index > 0 && !IsHoverable(ctx->m_ItemsOrdered.at(index))) index--;
+                    if (!IsHoverable(ctx->m_ItemsOrdered.at(index))) index = hoveredIndex;
                     id = ctx->m_ItemsOrdered.at(index)->m_Id;
                 }
                 ctx->m_HoveredItemId = id;
@@ -824,8 +2094,8 @@ inline void tuim::Update(char32_t keyCode) {
                 ItemId id = 0;
                 if (hoveredIndex != -1) {
                     size_t index = std::min(hoveredIndex + 1, (int) ctx->m_ItemsOrdered.size() - 1);
-                    while(index < (ctx->m_ItemsOrdered.size() - 1) && (ctx->m_ItemsOrdered.at(index)->m_Flags) & ITEM_FLAGS_DISABLED) index++;
-                    if ((ctx->m_ItemsOrdered.at(index)->m_Flags & ITEM_FLAGS_DISABLED)) index = hoveredIndex;
+                    while(index < (ctx->m_ItemsOrdered.size() - 1) && !IsHoverable(ctx->m_ItemsOrdered.at(index))) index++;
+                    if (!IsHoverable(ctx->m_ItemsOrdered.at(index))) index = hoveredIndex;
                     id = ctx->m_ItemsOrdered.at(index)->m_Id;
                 }
                 ctx->m_HoveredItemId = id;
@@ -839,11 +2109,37 @@ inline void tuim::Update(char32_t keyCode) {
 inline void tuim::Clear() {
     vec2 terminalSize = tuim::Terminal::GetTerminalSize();
     Context* ctx = tuim::GetCtx();
+    ctx->m_TerminalSize = terminalSize;
+    ctx->m_CaptureSignalKeys = false;
 
     ctx->m_PrevFrame = ctx->m_Frame;
     ctx->m_Frame = std::make_shared<Frame>(terminalSize);
     ctx->m_ItemsOrdered.clear();
     ctx->m_Items.clear();
+    ctx->m_ItemIndex.Clear(terminalSize);
+
+    // The base containers hidden by the upper layers of the last frame are not drawn, unless
+    // the last frame was not displayed because the layers have changed (e.g. a popup was closed).
+    ctx->m_CullingAreas.clear();
+    ctx->m_CulledAreas.clear();
+    for (size_t layer = 0; layer < LAYER_COUNT; layer++) {
+        if (layer != LAYER_BASE && !ctx->m_CullingDisabled)
+            ctx->m_CullingAreas.insert(ctx->m_CullingAreas.end(), ctx->m_OpaqueAreas[layer].begin(), ctx->m_OpaqueAreas[layer].end());
+        ctx->m_LayersUsed[layer] = false;
+        ctx->m_OpaqueAreas[layer].clear();
+    }
+    ctx->m_CullingDisabled = false;
+
+    // Keep the clusters of the previous frame alive so that its cells can still be compared.
+    std::swap(ctx->m_PrevClusters, ctx->m_Clusters);
+    ctx->m_Clusters.Clear();
+
+    // Forget the states of the items that have not been drawn for a while.
+    ctx->m_FrameCount++;
+    for (std::unique_ptr<StatePoolBase>& pool : ctx->m_StatePools) {
+        if (pool != nullptr)
+            pool->CollectGarbage(ctx->m_FrameCount, ctx->m_StateLifetime);
+    }
 
     ctx->m_CurrentForeground = std::nullopt;
     ctx->m_CurrentBackground = std::nullopt;
@@ -853,18 +2149,38 @@ inline void tuim::Clear() {
 inline void tuim::Display() {
     if (!ctx->m_ContainersStack.empty())
         throw std::runtime_error("error: container stack is not empty.");
+    if (!ctx->m_LayersStack.empty())
+        throw std::runtime_error("error: layer stack is not empty.");
+
+    // A frame with holes where the layers used to be is not displayed, the next one is fully drawn instead.
+    // The displayed frame and its clusters are kept to be compared with the next one.
+    Context* ctx = tuim::GetCtx();
+    if (!tuim::ComposeLayers()) {
+        ctx->m_Frame = ctx->m_PrevFrame;
+        std::swap(ctx->m_Clusters, ctx->m_PrevClusters);
+        ctx->m_CullingDisabled = true;
+        return;
+    }
+
+    // The signals are only disabled while a widget needs their keys (the text editor uses Ctrl+Z and Ctrl+Y).
+    if (ctx->m_CaptureSignalKeys != ctx->m_SignalKeysCaptured) {
+        tuim::Terminal::SetSignalKeys(!ctx->m_CaptureSignalKeys);
+        ctx->m_SignalKeysCaptured = ctx->m_CaptureSignalKeys;
+    }
 
     // tuim::Terminal::Clear();
     tuim::Terminal::ClearStyles();
     tuim::Terminal::SetCursorPos(vec2(0, 0));
 
-    Context* ctx = tuim::GetCtx();
     vec2 terminalSize = tuim::Terminal::GetTerminalSize();
     vec2 prevPos = vec2(-1, 0);
     
     size_t frameHeight = ctx->m_Frame->m_Cells.size();
     size_t displayHeight = std::min(frameHeight, (size_t) terminalSize.y);
 
+    // Only the cells that changed since the last frame are printed, unless the terminal has been resized.
+    bool redrawAll = (ctx->m_PrevFrame == nullptr || ctx->m_PrevFrame->GetSize() != ctx->m_Frame->GetSize());
+
     // Current ANSI styles actually applied to the terminal to avoid redundant codes.
     std::optional<Color> currentForeground = std::nullopt;
     std::optional<Color> currentBackground = std::nullopt;
@@ -883,10 +2199,8 @@ inline void tuim::Display() {
             std::shared_ptr<Cell> prevCell = (ctx->m_PrevFrame != nullptr && ctx->m_PrevFrame->Has(x, y) ? ctx->m_PrevFrame->Get(x, y) : nullptr);
 
             // Compare cells, including character and all style attributes.
-            // bool cellChanged = (cell == nullptr && prevCell != nullptr) ||
-            //                     (cell != nullptr && prevCell == nullptr) ||
-            //                     (cell != nullptr && prevCell != nullptr && *cell != *prevCell);
-            bool cellChanged = true;
+            // Clusters indices are specific to each frame pool, so their content is compared instead.
+            bool cellChanged = redrawAll || !tuim::IsSameCell(cell.get(), ctx->m_Clusters, prevCell.get(), ctx->m_PrevClusters);
             
             if (cellChanged) {
                 // Set cursor to pixel if consecutive characters have not been changed since the previous frame,
@@ -937,6 +2251,16 @@ inline void tuim::Display() {
                     std::cout << ' ';
                     prevPos = vec2(x, y);
                 }
+                else if (cell->m_Cluster != 0) {
+                    // Print the whole grapheme cluster at once so that the terminal combines it.
+                    std::u32string_view cluster = ctx->m_Clusters.Get(cell->m_Cluster);
+                    uint8_t width = tuim::GraphemeWidth(cluster);
+                    if (width == 2)
+                        x++;
+                    for (char32_t ch : cluster)
+                        std::cout << tuim::Utf8Char32ToString(ch);
+                    prevPos = vec2(x, y);
+                }
                 else {
                     uint8_t width = tuim::Utf8CharWidth(cell->m_Character);
                     // Increment x for wide characters to account for the second column.
@@ -952,6 +2276,8 @@ inline void tuim::Display() {
         // Also reset styles to default so that newlines or next lines start clean.
         // If the line width is less than terminal width, clear the rest of the line.
         if (lineWidth < terminalSize.x-1) {
+            if (prevPos.x != (int) lineWidth-1)
+                tuim::Terminal::SetCursorPos(vec2(lineWidth, y));
             tuim::Terminal::ClearStyles();
             std::cout << ' ';
             tuim::Terminal::ClearLineEnd();
@@ -969,7 +2295,12 @@ inline void tuim::Display() {
     }
 
     tuim::Terminal::ClearStyles();
-    tuim::Terminal::ClearEnd();
+
+    // Only clear the rows below the frame, the cursor is still on the last row which may not have been repainted.
+    if (displayHeight < (size_t) terminalSize.y) {
+        tuim::Terminal::SetCursorPos(vec2(0, displayHeight));
+        tuim::Terminal::ClearEnd();
+    }
     std::cout << std::flush;
 }
 
@@ -984,7 +2315,9 @@ inline bool tuim::Terminal::IsUserInputsVisible() {
 
 inline tuim::vec2 tuim::Terminal::GetTerminalSize() {
     winsize size;
-    ioctl(STDOUT_FILENO, TIOCGWINSZ, &size);
+    // Fallback to a standard size if the output is not a terminal (e.g redirected to a file).
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) != 0)
+        return vec2(80, 24);
     return vec2(size.ws_col, size.ws_row);
 }
 
@@ -1008,6 +2341,42 @@ inline void tuim::Terminal::SetAlternateBuffer(bool enabled) {
     std::cout << "\033[?1049" << (enabled ? 'h' : 'l');
 }
 
+inline void tuim::Terminal::SetMouseReporting(bool enabled) {
+    // Any motion (1003) is reported, with coordinates that are not limited to 223 (1006).
+    std::cout << "\033[?1003" << (enabled ? 'h' : 'l') << "\033[?1006" << (enabled ? 'h' : 'l') << std::flush;
+}
+
+inline void tuim::Terminal::SetBracketedPaste(bool enabled) {
+    std::cout << "\033[?2004" << (enabled ? 'h' : 'l') << std::flush;
+}
+
+inline void tuim::Terminal::SetSignalKeys(bool enabled) {
+    termios term;
+    tcgetattr(STDIN_FILENO, &term);
+    if (enabled) term.c_lflag |= (ISIG | IEXTEN);
+    else term.c_lflag &= ~(ISIG | IEXTEN);
+    tcsetattr(STDIN_FILENO, TCSANOW, &term);
+}
+
+inline bool tuim::Terminal::ReadInput(std::string& buffer, int timeout) {
+    fd_set set;
+    FD_ZERO(&set);
+    FD_SET(STDIN_FILENO, &set);
+    timeval time;
+    time.tv_sec = timeout / 1000000;
+    time.tv_usec = timeout % 1000000;
+    if (select(STDIN_FILENO + 1, &set, NULL, NULL, &time) != 1)
+        return false;
+
+    // Read everything that is available, a single key may be split in several reads.
+    char bytes[4096];
+    ssize_t count = read(STDIN_FILENO, bytes, sizeof(bytes));
+    if (count <= 0)
+        return false;
+    buffer.append(bytes, count);
+    return true;
+}
+
 inline void tuim::Terminal::SetCursorPos(const tuim::vec2& pos) {
     std::cout << "\033[" << pos.y+1 << ";" << pos.x+1 << "H";
 }
@@ -1047,11 +2416,18 @@ inline tuim::Frame::Frame(const vec2& size) {
     m_Cells = std::vector<std::vector<std::shared_ptr<Cell>>>(size.y, std::vector<std::shared_ptr<Cell>>(size.x, nullptr));
 }
 
+inline tuim::Frame::Frame(std::shared_ptr<tuim::Frame> target, const tuim::vec2& offset, const tuim::rect& clip) {
+    m_Cursor = vec2(0, 0);
+    m_Target = target;
+    m_Offset = offset;
+    m_Clip = clip;
+}
+
 inline tuim::vec2 tuim::Frame::GetSize() const {
-    size_t maxWidth = m_Cells.front().size();
+    size_t maxWidth = 0;
     for (size_t i = 0; i < m_Cells.size(); i++)
         maxWidth = std::max(maxWidth, m_Cells[i].size());
-    return vec2(m_Cells.size(), m_Cells.size());
+    return vec2(maxWidth, m_Cells.size());
 }
 
 inline std::shared_ptr<tuim::Cell> tuim::Frame::Get(const tuim::vec2& pos) {
@@ -1067,6 +2443,14 @@ inline bool tuim::Frame::Has(size_t x, size_t y) const {
 }
 
 inline void tuim::Frame::Set(const tuim::vec2& pos, std::shared_ptr<tuim::Cell> cell) {
+    // Viewports write directly into their target, only inside their clip rectangle.
+    if (m_Target != nullptr) {
+        vec2 targetPos = pos + m_Offset;
+        if (m_Clip.Contains(targetPos))
+            m_Target->Set(targetPos, cell);
+        return;
+    }
+
     // Make sure to resize the vectors in case the position is
     // beyond the column or line size.
     if (pos.y >= m_Cells.size())
@@ -1074,12 +2458,67 @@ inline void tuim::Frame::Set(const tuim::vec2& pos, std::shared_ptr<tuim::Cell>
     if (pos.x >= m_Cells[pos.y].size())
         m_Cells[pos.y].resize(pos.x+1, nullptr);
     m_Cells[pos.y][pos.x] = cell;
+    if (!m_Drawn.Contains(pos))
+        m_Drawn = m_Drawn.Union(rect(pos.x, pos.y, 1, 1));
+}
+
+inline void tuim::Frame::DrawCluster(std::u32string_view cluster, const tuim::CellStyle& style, const tuim::vec2& bounds) {
+    if (cluster.empty())
+        return;
+
+    int width = (cluster.size() > 1 ? tuim::GraphemeWidth(cluster) : tuim::Utf8CharWidth(cluster.front()));
+    if (m_Cursor.x >= 0 && m_Cursor.y >= 0 && m_Cursor.x < bounds.x && m_Cursor.y < bounds.y) {
+        std::shared_ptr<Cell> cell = std::make_shared<Cell>(cluster.front(), style.m_Style);
+        cell->m_Foreground = style.m_Foreground;
+        cell->m_Background = style.m_Background;
+        if (cluster.size() > 1)
+            cell->m_Cluster = tuim::GetCtx()->m_Clusters.Intern(cluster);
+        Set(m_Cursor, cell);
+    }
+    m_Cursor.x += std::max(0, width);
 }
 
 inline void tuim::Frame::Clear() {
-    for (auto& line : m_Cells)
-        std::fill(line.begin(), line.end(), nullptr);
-    // TODO: maybe it would be better to reset the size instead?
+    for (int y = m_Drawn.y; y < m_Drawn.y + m_Drawn.h && y < (int) m_Cells.size(); y++) {
+        std::vector<std::shared_ptr<Cell>>& line = m_Cells[y];
+        int end = std::min<int>(line.size(), m_Drawn.x + m_Drawn.w);
+        if (m_Drawn.x < end)
+            std::fill(line.begin() + m_Drawn.x, line.begin() + end, nullptr);
+    }
+    m_Drawn = rect();
+}
+
+inline uint32_t tuim::ClusterPool::Intern(std::u32string_view cluster) {
+    auto it = m_Indices.find(std::u32string(cluster));
+    if (it != m_Indices.end())
+        return it->second;
+
+    // Indices start at 1 because 0 is used by cells made of a single character.
+    m_Clusters.emplace_back(cluster);
+    uint32_t index = m_Clusters.size();
+    m_Indices.emplace(m_Clusters.back(), index);
+    return index;
+}
+
+inline std::u32string_view tuim::ClusterPool::Get(uint32_t index) const {
+    if (index == 0 || index > m_Clusters.size())
+        return std::u32string_view();
+    return m_Clusters[index-1];
+}
+
+inline bool tuim::IsSameCell(const Cell* cell, const ClusterPool& clusters, const Cell* other, const ClusterPool& otherClusters) {
+    if (cell == nullptr || other == nullptr)
+        return cell == other;
+    return cell->m_Character == other->m_Character &&
+           cell->m_Style == other->m_Style &&
+           cell->m_Foreground == other->m_Foreground &&
+           cell->m_Background == other->m_Background &&
+           clusters.Get(cell->m_Cluster) == otherClusters.Get(other->m_Cluster);
+}
+
+inline void tuim::ClusterPool::Clear() {
+    m_Clusters.clear();
+    m_Indices.clear();
 }
 
 /***********************************************************
@@ -1091,6 +2530,15 @@ inline tuim::ItemId tuim::GetCurrentItemId() {
     return ctx->m_ItemsOrdered.back()->m_Id;
 }
 
+inline void tuim::FitItemToCursor() {
+    Context* ctx = tuim::GetCtx();
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    std::shared_ptr<Item> item = ctx->m_ItemsOrdered.back();
+    vec2 cursor = (frame->m_Target != nullptr) ? frame->m_Cursor + frame->m_Offset : frame->m_Cursor;
+    item->m_Size = vec2(std::max(1, cursor.x - item->m_Pos.x), std::max(1, cursor.y - item->m_Pos.y + 1));
+    ctx->m_ItemIndex.Resize(ctx->m_ItemsOrdered.size() - 1, item->m_Size);
+}
+
 inline uint32_t tuim::GetItemIndex(tuim::ItemId id) {
     Context* ctx = tuim::GetCtx();
     for(size_t i = 0; i < ctx->m_ItemsOrdered.size(); i++) {
@@ -1140,13 +2588,130 @@ inline bool tuim::HasHoverable() {
     return false;
 }
 
+inline void tuim::ItemIndex::Clear(vec2 size) {
+    m_Areas.clear();
+    m_GridSize = vec2(std::max(1, (size.x + BUCKET_WIDTH - 1) / BUCKET_WIDTH), std::max(1, (size.y + BUCKET_HEIGHT - 1) / BUCKET_HEIGHT));
+    m_Buckets.resize(m_GridSize.x * m_GridSize.y);
+    for (std::vector<uint32_t>& bucket : m_Buckets)
+        bucket.clear();
+}
+
+inline void tuim::ItemIndex::Add(const Item& item) {
+    rect area = rect(item.m_Pos.x, item.m_Pos.y, std::max(1, item.m_Size.x), std::max(1, item.m_Size.y));
+    uint32_t index = m_Areas.size();
+    m_Areas.push_back(area);
+
+    // The item is added to all the buckets it overlaps.
+    auto Bucket = [](int pos, int size, int count) { return std::clamp(pos / size, 0, count - 1); };
+    int endX = Bucket(area.x + area.w - 1, BUCKET_WIDTH, m_GridSize.x);
+    int endY = Bucket(area.y + area.h - 1, BUCKET_HEIGHT, m_GridSize.y);
+    for (int y = Bucket(area.y, BUCKET_HEIGHT, m_GridSize.y); y <= endY; y++) {
+        for (int x = Bucket(area.x, BUCKET_WIDTH, m_GridSize.x); x <= endX; x++)
+            m_Buckets[y * m_GridSize.x + x].push_back(index);
+    }
+}
+
+inline void tuim::ItemIndex::Resize(size_t index, vec2 size) {
+    rect& area = m_Areas[index];
+    rect previous = area;
+    area = rect(area.x, area.y, std::max(1, size.x), std::max(1, size.y));
+
+    // Only the buckets that the item did not overlap yet have to be completed.
+    auto Bucket = [](int pos, int size, int count) { return std::clamp(pos / size, 0, count - 1); };
+    rect buckets = rect(Bucket(previous.x, BUCKET_WIDTH, m_GridSize.x), Bucket(previous.y, BUCKET_HEIGHT, m_GridSize.y), 0, 0);
+    buckets.w = Bucket(previous.x + previous.w - 1, BUCKET_WIDTH, m_GridSize.x) - buckets.x + 1;
+    buckets.h = Bucket(previous.y + previous.h - 1, BUCKET_HEIGHT, m_GridSize.y) - buckets.y + 1;
+    int endX = Bucket(area.x + area.w - 1, BUCKET_WIDTH, m_GridSize.x);
+    int endY = Bucket(area.y + area.h - 1, BUCKET_HEIGHT, m_GridSize.y);
+    for (int y = buckets.y; y <= endY; y++) {
+        for (int x = buckets.x; x <= endX; x++) {
+            if (!buckets.Contains(vec2(x, y)))
+                m_Buckets[y * m_GridSize.x + x].push_back(index);
+        }
+    }
+}
+
+inline void tuim::ItemIndex::Build(const std::vector<std::shared_ptr<Item>>& items) {
+    vec2 end = vec2(1, 1);
+    for (const std::shared_ptr<Item>& item : items)
+        end = vec2(std::max(end.x, item->m_Pos.x + item->m_Size.x), std::max(end.y, item->m_Pos.y + item->m_Size.y));
+    Clear(end);
+    for (const std::shared_ptr<Item>& item : items)
+        Add(*item);
+}
+
+inline int tuim::ItemIndex::FindNearest(size_t from, Key direction, const std::function<bool(size_t)>& filter) const {
+    if (from >= m_Areas.size())
+        return -1;
+
+    // Work along the direction, the other axis becomes the cross one.
+    bool isHorizontal = (direction == Key::LEFT || direction == Key::RIGHT);
+    bool isForward = (direction == Key::RIGHT || direction == Key::DOWN);
+    auto Along = [&](const rect& area, bool end) { return isHorizontal ? (end ? area.x + area.w : area.x) : (end ? area.y + area.h : area.y); };
+    auto Cross = [&](const rect& area, bool end) { return isHorizontal ? (end ? area.y + area.h : area.y) : (end ? area.x + area.w : area.x); };
+
+    // An item is a candidate if it is entirely past the edge of the current one. Characters are twice as
+    // high as wide, so vertical distances count double, and going off the axis is penalized.
+    const rect& current = m_Areas[from];
+    int alongScale = isHorizontal ? 1 : 2;
+    int crossScale = isHorizontal ? 2 : 1;
+    auto Score = [&](const rect& area) {
+        int along = isForward ? Along(area, false) - Along(current, true) : Along(current, false) - Along(area, true);
+        if (along < 0)
+            return -1;
+        int cross = std::max({ 0, Cross(area, false) - Cross(current, true) + 1, Cross(current, false) - Cross(area, true) + 1 });
+        return along * alongScale + 2 * cross * crossScale;
+    };
+
+    // Go through the lines (or columns) of buckets away from the item, and stop once they cannot hold a closer one.
+    int bucketSize = isHorizontal ? BUCKET_WIDTH : BUCKET_HEIGHT;
+    int lineCount = isHorizontal ? m_GridSize.x : m_GridSize.y;
+    int crossCount = isHorizontal ? m_GridSize.y : m_GridSize.x;
+    int first = std::max(0, isForward ? Along(current, true) : Along(current, false) - 1) / bucketSize;
+    int best = -1, bestScore = std::numeric_limits<int>::max();
+    for (int line = std::clamp(first, 0, lineCount - 1); line >= 0 && line < lineCount; line += (isForward ? 1 : -1)) {
+        int gap = isForward ? line * bucketSize - Along(current, true) : Along(current, false) - (line + 1) * bucketSize;
+        if (gap * alongScale > bestScore)
+            break;
+        for (int other = 0; other < crossCount; other++) {
+            const std::vector<uint32_t>& bucket = m_Buckets[isHorizontal ? other * m_GridSize.x + line : line * m_GridSize.x + other];
+            for (uint32_t index : bucket) {
+                if (index == from)
+                    continue;
+                int score = Score(m_Areas[index]);
+                if (score < 0 || score > bestScore || (score == bestScore && (int) index > best) || !filter(index))
+                    continue;
+                best = index;
+                bestScore = score;
+            }
+        }
+    }
+    return best;
+}
+
+inline int tuim::ItemIndex::FindAt(vec2 pos, const std::function<bool(size_t)>& filter) const {
+    if (m_Areas.empty())
+        return -1;
+
+    // Items drawn later are on top of the previous ones.
+    int x = std::clamp(pos.x / BUCKET_WIDTH, 0, m_GridSize.x - 1);
+    int y = std::clamp(pos.y / BUCKET_HEIGHT, 0, m_GridSize.y - 1);
+    const std::vector<uint32_t>& bucket = m_Buckets[y * m_GridSize.x + x];
+    for (auto it = bucket.rbegin(); it != bucket.rend(); it++) {
+        if (m_Areas[*it].Contains(pos) && filter(*it))
+            return *it;
+    }
+    return -1;
+}
+
 /***********************************************************
 *                       CONTAINERS                         *
 ***********************************************************/
 
-inline void tuim::BeginContainer(std::string_view id, std::string_view label, tuim::vec2 size, ContainerFlags flags, AlignFlags align) {
+inline bool tuim::BeginContainer(std::string_view id, std::string_view label, tuim::vec2 size, ContainerFlags flags, AlignFlags align) {
     Context* ctx = tuim::GetCtx();
-    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    std::shared_ptr<Container> parent = tuim::GetCurrentContainer();
+    std::shared_ptr<Frame> dst = parent->m_Frame;
 
     // Make sure that the size is positive.
     if (size.x < 0) size.x = 0;
@@ -1160,12 +2725,131 @@ inline void tuim::BeginContainer(std::string_view id, std::string_view label, tu
     container->m_ContainerFlags = flags;
     container->m_AlignFlags = align;
     container->m_Size = size;
-    container->m_Pos = frame->m_Cursor;
-    container->m_Frame = std::make_shared<Frame>(size);
+    container->m_Pos = dst->m_Cursor;
+
+    // --------------------------------------------------  dst
+    // |                                                |
+    // | o-------------------------------  container    |
+    // | |x                             |               |
+    // | |                              |               |
+    // | |                              |               |
+    // | --------------------------------               |
+    // |                                                |
+    // --------------------------------------------------
+    // o: origin (position of the container in the dst)
+    // x: origin border excluded (position at which the container content is drawn).
+
+    // The border is included in the container's size, it only shifts the content by one.
+    bool hasBorder = !(flags & CONTAINER_FLAGS_BORDERLESS);
+    int dstWidth = std::max(0, parent->m_Size.x);
+    int dstHeight = std::max(0, parent->m_Size.y);
+
+    // The origin is by default at the dst frame cursor but changes depending on the dst alignment.
+    vec2 origin = dst->m_Cursor;
+    AlignFlags dstAlign = parent->m_AlignFlags;
+    if (dstAlign & ALIGN_LEFT) origin.x = 0;
+    else if (dstAlign & ALIGN_CENTER) origin.x = dstWidth/2 - (size.x + 2*hasBorder)/2;
+    else if (dstAlign & ALIGN_RIGHT) origin.x = dstWidth - (size.x + 2*hasBorder);
+    if (dstAlign & ALIGN_TOP) origin.y = 0;
+    else if (dstAlign & ALIGN_MIDDLE) origin.y = dstHeight/2 - (size.y + 2*hasBorder)/2;
+    else if (dstAlign & ALIGN_BOTTOM) origin.y = dstHeight - (size.y + 2*hasBorder);
+    container->m_Origin = origin;
+
+    // Resolve where the content lands in the screen frame and the area it is clipped to:
+    // the inside of the container (border excluded), within the area of its parent.
+    rect dstClip = (dst->m_Target != nullptr) ? dst->m_Clip : rect(0, 0, dstWidth, dstHeight);
+    vec2 dstOffset = (dst->m_Target != nullptr) ? dst->m_Offset : vec2(0, 0);
+    vec2 offset = dstOffset + origin + vec2(hasBorder, hasBorder);
+    rect clip = dstClip.Intersect(rect(offset.x, offset.y, size.x - 2*hasBorder, size.y - 2*hasBorder));
+    if (size.x <= 0 || size.y <= 0 || dstWidth <= 0 || dstHeight <= 0)
+        clip = rect();
+
+    // Containers drawn over the screen frame hide what is below them, border included.
+    // The base containers hidden by the layers of the last frame are culled, Display checks that they are still hidden.
+    rect area = dstClip.Intersect(rect(dstOffset.x + origin.x, dstOffset.y + origin.y, size.x, size.y));
+    Layer layer = ctx->m_LayersStack.empty() ? LAYER_BASE : ctx->m_LayersStack.top();
+    if (layer != LAYER_BASE && !clip.IsEmpty())
+        ctx->m_OpaqueAreas[layer].push_back(area);
+    else if (layer == LAYER_BASE && !clip.IsEmpty()) {
+        bool hidden = std::any_of(ctx->m_CullingAreas.begin(), ctx->m_CullingAreas.end(), [&](const rect& culling) { return culling.Contains(area); });
+        if (hidden) {
+            ctx->m_CulledAreas.push_back(area);
+            clip = rect();
+        }
+    }
+
+    std::shared_ptr<Frame> screen = (dst->m_Target != nullptr) ? dst->m_Target : dst;
+    container->m_Frame = std::make_shared<Frame>(screen, offset, clip);
+
+    if (!clip.IsEmpty()) {
+        // Draw the border directly onto the dst frame (if not borderless).
+        if (hasBorder) {
+            vec2 end = vec2(origin.x + size.x - 1, origin.y + size.y - 1);
+            dst->Set(origin, std::make_shared<Cell>(U'+'));
+            dst->Set(vec2(end.x, origin.y), std::make_shared<Cell>(U'+'));
+            dst->Set(vec2(origin.x, end.y), std::make_shared<Cell>(U'+'));
+            dst->Set(end, std::make_shared<Cell>(U'+'));
+            for (int x = origin.x + 1; x < end.x; x++) {
+                dst->Set(vec2(x, origin.y), std::make_shared<Cell>(U'-'));
+                dst->Set(vec2(x, end.y), std::make_shared<Cell>(U'-'));
+            }
+            for (int y = origin.y + 1; y < end.y; y++) {
+                dst->Set(vec2(origin.x, y), std::make_shared<Cell>(U'|'));
+                dst->Set(vec2(end.x, y), std::make_shared<Cell>(U'|'));
+            }
+        }
+
+        // Containers are opaque: erase what was previously drawn below the content area.
+        for (int y = clip.y; y < clip.y + clip.h && y < (int) screen->m_Cells.size(); y++) {
+            std::vector<std::shared_ptr<Cell>>& row = screen->m_Cells[y];
+            int rowEnd = std::min((int) row.size(), clip.x + clip.w);
+            if (clip.x < rowEnd)
+                std::fill(row.begin() + clip.x, row.begin() + rowEnd, nullptr);
+        }
+    }
 
     // Save the container to the context.
+    // Even if it is not visible, it keeps its size and position for the navigation.
     tuim::AddItem(container);
     ctx->m_ContainersStack.push(itemId);
+
+    return !clip.IsEmpty();
+}
+
+inline bool tuim::BeginCachedContainer(std::string_view id, std::string_view label, vec2 size, uint64_t version, ContainerFlags flags, AlignFlags align) {
+    Context* ctx = tuim::GetCtx();
+    if (!tuim::BeginContainer(id, label, size, flags, align))
+        return false;
+
+    std::shared_ptr<Container> container = tuim::GetCurrentContainer();
+    std::shared_ptr<Frame> frame = container->m_Frame;
+    ContainerCache& cache = tuim::GetState<ContainerCache>(container->m_Id);
+
+    // The content is built again when it is interacted with, and often enough for the states of its items not to expire.
+    // It is also built once after the interaction ends, so that the hover highlight is not kept in the cells.
+    bool isInteracting = std::any_of(cache.m_Items.begin(), cache.m_Items.end(), [ctx](const std::shared_ptr<Item>& item) {
+        return item->m_Id == ctx->m_HoveredItemId || item->m_Id == ctx->m_ActiveItemId;
+    });
+    bool isExpired = (ctx->m_FrameCount - cache.m_Frame >= std::max<uint32_t>(1, ctx->m_StateLifetime / 2));
+    bool isReusable = (cache.m_Valid && cache.m_Version == version && cache.m_Offset == frame->m_Offset && cache.m_Clip == frame->m_Clip);
+    if (isReusable && !isInteracting && !cache.m_WasInteracting && !isExpired) {
+        // The items already have their screen position and layer.
+        for (const std::shared_ptr<Item>& item : cache.m_Items) {
+            ctx->m_ItemsOrdered.push_back(item);
+            ctx->m_Items.emplace(item->m_Id, item);
+            ctx->m_ItemIndex.Add(*item);
+        }
+        frame->m_Cursor = vec2(0, 0);
+        tuim::DrawImage(cache.m_Image);
+        return false;
+    }
+
+    cache.m_Valid = false;
+    cache.m_Version = version;
+    cache.m_WasInteracting = isInteracting;
+    container->m_Recording = true;
+    container->m_FirstItem = ctx->m_ItemsOrdered.size();
+    return true;
 }
 
 inline void tuim::EndContainer() {
@@ -1184,295 +2868,710 @@ inline void tuim::EndContainer() {
         throw std::out_of_range("error: undefined container from stack.");
     std::shared_ptr<Container> container = std::dynamic_pointer_cast<Container>(it->second);
 
-    // Merge the container with the new active container or global frame.
-    tuim::MergeContainer(container);
-}
-
-inline void tuim::MergeContainer(std::shared_ptr<tuim::Container> srcContainer) {
-    // Get the container that the source will merge into.
-    // If the containers stack is empty, an abstract container representing
-    // the main/global frame will be returned with CONTAINER_FLAGS_BORDERLESS flags and align properties.
-    std::shared_ptr<Container> dstContainer = tuim::GetCurrentContainer();
-
-    std::shared_ptr<Frame> src = srcContainer->m_Frame;
-    std::shared_ptr<Frame> dst = dstContainer->m_Frame;
-
-    // --------------------------------------------------  dst
-    // |                                                |
-    // | o-------------------------------  src          |
-    // | |x                             |               |
-    // | |                              |               |
-    // | |                              |               |
-    // | |                              |               |
-    // | |                              |               |
-    // | |                              |               |
-    // | |                              |               |
-    // | --------------------------------               |
-    // |                                                |
-    // --------------------------------------------------
-    // o: origin (position of the src in the dst)
-    // x: origin border excluded (position at which src cells will be drawn).
+    // Keep the content of a cached container along with its items.
+    if (container->m_Recording) {
+        ContainerCache* cache = tuim::FindState<ContainerCache>(itemId);
+        std::shared_ptr<Frame> frame = container->m_Frame;
+        if (cache != nullptr) {
+            vec2 end = vec2(frame->m_Clip.x + frame->m_Clip.w, frame->m_Clip.y + frame->m_Clip.h);
+            cache->m_Image.SetCells(*frame->m_Target, rect(frame->m_Offset.x, frame->m_Offset.y, end.x - frame->m_Offset.x, end.y - frame->m_Offset.y), frame->m_Clip);
+            // Nested containers are copied without their viewport, which would keep the screen frame alive.
+            cache->m_Items.clear();
+            for (size_t i = container->m_FirstItem; i < ctx->m_ItemsOrdered.size(); i++) {
+                std::shared_ptr<Item> item = ctx->m_ItemsOrdered.at(i);
+                if (std::shared_ptr<Container> nested = std::dynamic_pointer_cast<Container>(item)) {
+                    nested = std::make_shared<Container>(*nested);
+                    nested->m_Frame = nullptr;
+                    item = nested;
+                }
+                cache->m_Items.push_back(item);
+            }
+            cache->m_Offset = frame->m_Offset;
+            cache->m_Clip = frame->m_Clip;
+            cache->m_Frame = ctx->m_FrameCount;
+            cache->m_Valid = true;
+        }
+    }
 
-    // 1. Skip everything if the src or dst container are empty.
-    if (srcContainer->m_Size.x <= 0 || srcContainer->m_Size.y <= 0 || dstContainer->m_Size.x <= 0 || dstContainer->m_Size.y <= 0) {
-        dst->m_Cursor = vec2(dst->m_Cursor.x + srcContainer->m_Size.x, dst->m_Cursor.y + srcContainer->m_Size.y);
+    // The content has already been drawn in place, only move the parent cursor below the container
+    // so that characters printed afterwards do not overwrite it.
+    std::shared_ptr<Frame> dst = tuim::GetCurrentFrame();
+    std::shared_ptr<Container> parent = tuim::GetCurrentContainer();
+    if (container->m_Size.x <= 0 || container->m_Size.y <= 0 || parent->m_Size.x <= 0 || parent->m_Size.y <= 0) {
+        dst->m_Cursor = vec2(dst->m_Cursor.x + container->m_Size.x, dst->m_Cursor.y + container->m_Size.y);
         return;
     }
+    dst->m_Cursor = vec2(container->m_Origin.x, container->m_Origin.y + container->m_Size.y - 1);
+}
 
-    // 2. Determine origin and define constants.
+/***********************************************************
+*                         LAYERS                           *
+***********************************************************/
 
-    // Size of the src container (includes the borders).
-    // Substract 1 because the origin is inside the container (1 width from 0 should stops at 0).
-    int srcWidth = std::max(0, srcContainer->m_Size.x - 1);
-    int srcHeight = std::max(0, srcContainer->m_Size.y - 1);
+inline void tuim::BeginLayer(Layer layer) {
+    Context* ctx = tuim::GetCtx();
+    vec2 terminalSize = ctx->m_TerminalSize;
+
+    // The frames of the layers are only created when they are first used, then cleared once per frame.
+    std::shared_ptr<Frame>& frame = (layer == LAYER_BASE) ? ctx->m_Frame : ctx->m_Layers[layer];
+    if (layer != LAYER_BASE && !ctx->m_LayersUsed[layer]) {
+        if (frame == nullptr || frame->GetSize() != terminalSize)
+            frame = std::make_shared<Frame>(terminalSize);
+        else frame->Clear();
+        ctx->m_LayersUsed[layer] = true;
+    }
+    frame->m_Cursor = vec2(0, 0);
 
-    // Size of the dst container.
-    // Note: the frame might not be that exact size, so we have to make sure 
-    //       that we aren't going out of bounds when writing cells.
-    int dstWidth = std::max(0, dstContainer->m_Size.x);
-    int dstHeight = std::max(0, dstContainer->m_Size.y);
+    // The layer is drawn through a container covering the whole screen.
+    std::shared_ptr<Container> container = std::make_shared<Container>(frame, CONTAINER_FLAGS_BORDERLESS);
+    container->m_Id = tuim::StringToId("#layer") + layer;
+    container->m_Flags = ITEM_FLAGS_DISABLED;
+    container->m_Size = terminalSize;
+    ctx->m_LayersStack.push(layer);
+    tuim::AddItem(container);
+    ctx->m_ContainersStack.push(container->m_Id);
+}
 
-    // The border is included in the container's size, it only shift
-    // where we start copying the frame cells by one.
-    bool hasBorder = !(srcContainer->m_ContainerFlags & CONTAINER_FLAGS_BORDERLESS);
+inline void tuim::EndLayer() {
+    Context* ctx = tuim::GetCtx();
+    if (ctx->m_LayersStack.empty() || ctx->m_ContainersStack.empty())
+        throw std::out_of_range("error: cannot pop empty layers stack.");
+    ctx->m_LayersStack.pop();
+    ctx->m_ContainersStack.pop();
+}
 
-    // Determine the origin: position at which the src frame will be drawn in the dstFrame.
-    vec2 origin = dst->m_Cursor;
+inline bool tuim::ComposeLayers() {
+    Context* ctx = tuim::GetCtx();
+    if (std::none_of(ctx->m_LayersUsed.begin() + 1, ctx->m_LayersUsed.end(), [](bool used) { return used; }))
+        return ctx->m_CulledAreas.empty();
+
+    // Go from the top layer to the bottom one, so that each cell is only written once and the cells of a layer covered by
+    // an upper one are skipped. The base containers hidden by the layers of the last frame have not been drawn at all.
+    vec2 terminalSize = ctx->m_TerminalSize;
+    rect screenArea = rect(0, 0, terminalSize.x, terminalSize.y);
+    std::shared_ptr<Frame> screen = ctx->m_Frame;
+    if (ctx->m_Coverage.size() != (size_t) (terminalSize.x * terminalSize.y))
+        ctx->m_Coverage.assign(terminalSize.x * terminalSize.y, 0);
+    auto Cover = [&](int x, int y, const std::shared_ptr<Cell>& cell) {
+        uint8_t& covered = ctx->m_Coverage[y * terminalSize.x + x];
+        if (covered)
+            return;
+        covered = 1;
+        if (cell != nullptr) screen->Set(vec2(x, y), cell);
+        else if (screen->Has(x, y)) screen->m_Cells[y][x] = nullptr;
+    };
 
-    // The origin is by default at the dst frame cursor but changes depending on the dst alignment.
-    AlignFlags dstAlign = dstContainer->m_AlignFlags;
-    if (dstAlign & ALIGN_LEFT) origin.x = 0;
-    else if (dstAlign & ALIGN_CENTER) origin.x = dstWidth/2 - (srcWidth+1+2*hasBorder)/2;
-    else if (dstAlign & ALIGN_RIGHT) origin.x = dstWidth - (srcWidth+1+2*hasBorder);
-    if (dstAlign & ALIGN_TOP) origin.y = 0;
-    else if (dstAlign & ALIGN_MIDDLE) origin.y = dstHeight/2 - (srcHeight+1+2*hasBorder)/2;
-    else if (dstAlign & ALIGN_BOTTOM) origin.y = dstHeight - (srcHeight+1+2*hasBorder);
-
-    // Final position of the container relative to the origin.
-    vec2 end = vec2(origin.x + srcWidth, origin.y + srcHeight);
-
-    // Origin at which the actual src frame content will be drawn (i.e border excluded).
-    vec2 originBorderless = vec2(origin.x + hasBorder, origin.y + hasBorder);
-
-    #define ROW_SIZE(row) dst->m_Cells[row].size()
-    #define SET_CELL(x, y, ch) dst->m_Cells[y][x] = std::make_shared<Cell>(ch)
-
-    // 3. Draw the border directly onto the dst frame (if not borderless).
-    if (hasBorder) {
-        bool canPrintFirstRow = (origin.y >= 0) && (origin.y < dstHeight);
-        bool canPrintLastRow = (end.y >= 0) && (end.y < dstHeight);
-
-        // Draw the border corners: +      +
-        //                            
-        //                          +      +
-        if (canPrintFirstRow && origin.x < ROW_SIZE(origin.y)) SET_CELL(origin.x, origin.y, U'+'); // top left corner
-        if (canPrintFirstRow && end.x < ROW_SIZE(origin.y)) SET_CELL(end.x, origin.y, U'+'); // top right corner
-        if (canPrintLastRow && origin.x < ROW_SIZE(end.y)) SET_CELL(origin.x, end.y, U'+'); // bottom left corner
-        if (canPrintLastRow && end.x < ROW_SIZE(end.y)) SET_CELL(end.x, end.y, U'+'); // bottom right corner
-
-        // Draw the border horizontal lines: +-------+
-        //                            
-        //                                   +-------+
-        for (size_t x = 1; x < srcWidth; x++) {
-            if (canPrintFirstRow && origin.x + x < ROW_SIZE(origin.y)) SET_CELL(origin.x + x, origin.y, U'-'); // top border
-            if (canPrintLastRow && origin.x + x < ROW_SIZE(end.y)) SET_CELL(origin.x + x, end.y, U'-'); // bottom border
+    // Only the areas in which the layers have drawn are read, and cleared from the coverage afterwards.
+    std::vector<rect> covered;
+    for (int layer = LAYER_COUNT - 1; layer > LAYER_BASE; layer--) {
+        std::shared_ptr<Frame> frame = ctx->m_Layers[layer];
+        if (!ctx->m_LayersUsed[layer])
+            continue;
+
+        // The cells drawn in the layer, then the areas of its containers (even where nothing is drawn).
+        rect drawn = frame->m_Drawn.Intersect(screenArea);
+        for (int y = drawn.y; y < drawn.y + drawn.h && y < (int) frame->m_Cells.size(); y++) {
+            const std::vector<std::shared_ptr<Cell>>& row = frame->m_Cells[y];
+            for (int x = drawn.x; x < std::min<int>(row.size(), drawn.x + drawn.w); x++) {
+                if (row[x] != nullptr)
+                    Cover(x, y, row[x]);
+            }
         }
-        
-        // Draw the border vertical lines: +-------+
-        //                                 |       |
-        //                                 +-------+
-        for (int y = 1; y < srcHeight; y++) {
-            int oy = origin.y + y;
-            if (oy < 0 || oy >= dst->m_Cells.size()) continue;
-            if (origin.x >= 0 && origin.x < ROW_SIZE(oy)) SET_CELL(origin.x, oy, U'|'); // left border
-            if (end.x >= 0 && end.x < ROW_SIZE(oy)) SET_CELL(end.x, oy, U'|'); // right border
+        covered.push_back(drawn);
+        for (const rect& area : ctx->m_OpaqueAreas[layer]) {
+            rect visible = area.Intersect(screenArea);
+            for (int y = visible.y; y < visible.y + visible.h; y++) {
+                for (int x = visible.x; x < visible.x + visible.w; x++)
+                    Cover(x, y, nullptr);
+            }
+            covered.push_back(visible);
         }
     }
 
-    // 4. Copy the content of src frame to dst frame.
-
-    // Determine how many lines we can copy without stepping out of bounds.
-    size_t maxY = std::min({
-        (size_t) std::max(0, (int) srcHeight + 1 - 2*hasBorder), // Height of the src container (borders excluded).
-        (size_t) std::max(0, (int) dst->m_Cells.size() - originBorderless.y), // Relative height of dst frame.
-        src->m_Cells.size() // Height of the src frame.
-    });
-
-    for (size_t y = 0; y < maxY; y++) {
-        if (originBorderless.y + y < 0) continue;
-        if (originBorderless.y + y >= dst->m_Cells.size()) continue;
-
-        // Determine how many cells we can copy without stepping out of bounds.
-        size_t maxX = std::min({
-            (size_t) std::max(0, (int) srcWidth + 1 - 2*hasBorder), // Width of the src container (borders excluded).
-            (size_t) std::max(0, (int) ROW_SIZE(originBorderless.y + y) - originBorderless.x), // Relative width of dst frame.
-            src->m_Cells[y].size() // Width of the src frame.
-        });
-
-        // TODO: avoid size_t because it overflows when originBorderless is negative (e.g centered with large width).
-        for (size_t x = 0; x < maxX; x++) {
-            if (originBorderless.x + x < 0) continue;
-            if (originBorderless.x + x >= ROW_SIZE(originBorderless.y + y)) continue;
-            dst->m_Cells[originBorderless.y + y][originBorderless.x + x] = src->m_Cells[y][x];
+    // The culled containers must still be hidden, otherwise the frame has holes.
+    bool complete = true;
+    for (const rect& area : ctx->m_CulledAreas) {
+        rect visible = area.Intersect(screenArea);
+        for (int y = visible.y; y < visible.y + visible.h && complete; y++) {
+            for (int x = visible.x; x < visible.x + visible.w && complete; x++)
+                complete = ctx->m_Coverage[y * terminalSize.x + x];
         }
     }
 
-    // Move the dest frame cursor to not overwrite when printing characters after merging.
-    dst->m_Cursor = vec2(origin.x, origin.y + srcHeight);
+    for (const rect& area : covered) {
+        for (int y = area.y; y < area.y + area.h; y++)
+            std::fill_n(ctx->m_Coverage.begin() + y * terminalSize.x + area.x, area.w, 0);
+    }
+    return complete;
 }
 
 /***********************************************************
-*                         ITEMS                            *
+*                         LAYOUTS                          *
 ***********************************************************/
-    
-template <typename... Args> inline void tuim::Print(const std::string& fmt, Args&&... args) {
-    std::string str = std::vformat(fmt, std::make_format_args(args...));
 
-    Context* ctx = tuim::GetCtx();
-    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+inline void tuim::SolveLayout(const std::vector<LayoutSize>& sizes, int available, int gap, std::vector<int>& out) {
+    out.assign(sizes.size(), 0);
+    if (sizes.empty())
+        return;
 
-    // Retrieve the current active styles from context.
-    std::optional<Color> currentForeground = ctx->m_CurrentForeground;
-    std::optional<Color> currentBackground = ctx->m_CurrentBackground;
-    Style currentStyle = ctx->m_CurrentStyle;
+    // Fixed and percentage sizes are known first, the flexible ones share what remains.
+    int space = std::max(0, available - gap * static_cast<int>(sizes.size() - 1));
+    int remaining = space;
+    std::vector<bool> isFlexible(sizes.size(), false);
+    for (size_t i = 0; i < sizes.size(); i++) {
+        const LayoutSize& size = sizes[i];
+        if (size.m_Unit == LayoutSize::FLEX) {
+            isFlexible[i] = true;
+            continue;
+        }
+        int value = (size.m_Unit == LayoutSize::FIXED) ? static_cast<int>(size.m_Value) : static_cast<int>(space * size.m_Value / 100.f);
+        out[i] = std::clamp(value, size.m_Min, std::max(size.m_Min, size.m_Max));
+        remaining -= out[i];
+    }
 
-    // Function to apply the current styles and colors to a Cell object.
-    auto CopyStylesToCell = [&](std::shared_ptr<Cell>& cell) {
-        cell->m_Foreground = currentForeground;
-        cell->m_Background = currentBackground;
-        cell->m_Style = currentStyle;
-    };
+    // The cells whose share is out of their bounds are clamped, and the others share the rest again.
+    std::vector<float> shares(sizes.size(), 0.f);
+    bool hasClamped = true;
+    while (hasClamped) {
+        hasClamped = false;
+        float totalWeight = 0.f;
+        for (size_t i = 0; i < sizes.size(); i++) {
+            if (isFlexible[i]) totalWeight += std::max(0.f, sizes[i].m_Value);
+        }
+        for (size_t i = 0; i < sizes.size() && totalWeight > 0.f; i++) {
+            if (!isFlexible[i])
+                continue;
+            shares[i] = std::max(0, remaining) * std::max(0.f, sizes[i].m_Value) / totalWeight;
+            int bounded = std::clamp(static_cast<int>(shares[i]), sizes[i].m_Min, std::max(sizes[i].m_Min, sizes[i].m_Max));
+            if (bounded != static_cast<int>(shares[i])) {
+                out[i] = bounded;
+                remaining -= bounded;
+                isFlexible[i] = false;
+                hasClamped = true;
+                break;
+            }
+        }
+    }
 
-    bool escaped = false;
+    // Round the shares down and give the remaining characters to the first flexible cells.
+    int leftover = std::max(0, remaining);
+    for (size_t i = 0; i < sizes.size(); i++) {
+        if (!isFlexible[i])
+            continue;
+        out[i] = static_cast<int>(shares[i]);
+        leftover -= out[i];
+    }
+    for (size_t i = 0; i < sizes.size() && leftover > 0; i++) {
+        if (isFlexible[i] && sizes[i].m_Value > 0.f && out[i] < sizes[i].m_Max) {
+            out[i]++;
+            leftover--;
+        }
+    }
+}
 
-    size_t i = 0;
-    while (i < str.length()) {
-        char c = str[i];
-        char cc = (i+1 < str.length()) ? str[i+1] : '\0';
+inline void tuim::BeginLayout(std::string_view id, const std::vector<LayoutSize>& sizes, LayoutFlags flags, vec2 size, int gap) {
+    static const std::vector<LayoutSize> s_Whole = { LayoutSize::Percent(100.f) };
+    if (flags & LAYOUT_FLAGS_COLUMN) tuim::BeginGrid(id, s_Whole, sizes, size, gap);
+    else tuim::BeginGrid(id, sizes, s_Whole, size, gap);
+}
 
-        if (!escaped) {
-            if (c == '#') {
-                // Escape the color code by repeating the same character.
-                if (cc == '#') {
-                    escaped = true;
-                    i++;
-                    continue;
-                }
+inline void tuim::BeginGrid(std::string_view id, const std::vector<LayoutSize>& columns, const std::vector<LayoutSize>& rows, vec2 size, int gap) {
+    Context* ctx = tuim::GetCtx();
+    std::shared_ptr<Container> parent = tuim::GetCurrentContainer();
+    vec2 origin = parent->m_Frame->m_Cursor;
+
+    // A missing dimension takes the remaining size of the current container.
+    if (size.x <= 0) size.x = std::max(0, parent->m_Size.x - 2 * !(parent->m_ContainerFlags & CONTAINER_FLAGS_BORDERLESS) - origin.x);
+    if (size.y <= 0) size.y = std::max(0, parent->m_Size.y - 2 * !(parent->m_ContainerFlags & CONTAINER_FLAGS_BORDERLESS) - origin.y);
+
+    // The cells are only solved again when the available size or the sizes change.
+    LayoutScope scope;
+    scope.m_Name = id;
+    scope.m_Id = tuim::StringToId(id);
+    scope.m_Origin = origin;
+    scope.m_Size = size;
+    LayoutState& state = tuim::GetState<LayoutState>(scope.m_Id);
+    if (!state.m_Valid || state.m_Available != size || state.m_Gap != gap || state.m_Columns != columns || state.m_Rows != rows) {
+        std::vector<int> widths, heights;
+        tuim::SolveLayout(columns, size.x, gap, widths);
+        tuim::SolveLayout(rows, size.y, gap, heights);
+
+        state.m_Cells.clear();
+        for (int row = 0, y = 0; row < (int) rows.size(); y += heights[row] + gap, row++) {
+            for (int column = 0, x = 0; column < (int) columns.size(); x += widths[column] + gap, column++)
+                state.m_Cells.emplace_back(x, y, widths[column], heights[row]);
+        }
+        state.m_Valid = true;
+        state.m_Available = size;
+        state.m_Gap = gap;
+        state.m_Columns = columns;
+        state.m_Rows = rows;
+    }
 
-                // Possible hex color: #rrggbb or #_rrggbb.
-                bool isBackground = (cc == '_');
-                size_t codeSize = 1 + isBackground + 6;
+    ctx->m_LayoutsStack.push_back(scope);
+}
 
-                // Check if there are enough characters for a hex code (6 characters).
-                if (i + codeSize <= str.length()) {
-                    std::string_view code(str.data() + i, codeSize);
-                    Color newColor = tuim::StringToColor(code);
-                    if (isBackground) currentBackground = newColor;
-                    else currentForeground = newColor;
+inline bool tuim::NextLayoutCell(ContainerFlags flags) {
+    Context* ctx = tuim::GetCtx();
+    if (ctx->m_LayoutsStack.empty())
+        throw std::out_of_range("error: no layout to open a cell in.");
 
-                    // Move past the style code.
-                    i += codeSize;
-                    continue;
-                }
-            }
-            else if (c == '&') {
-                // Escape the color code by repeating the same character.
-                if (cc == '&') {
-                    escaped = true;
-                    i++;
-                    continue;
-                }
+    LayoutScope& scope = ctx->m_LayoutsStack.back();
+    if (scope.m_IsCellOpen) {
+        tuim::EndContainer();
+        scope.m_IsCellOpen = false;
+    }
+
+    const LayoutState* state = tuim::FindState<LayoutState>(scope.m_Id);
+    if (state == nullptr || scope.m_Next >= state->m_Cells.size())
+        return false;
 
-                // Determine if the color is used as a foreground or background.
-                // In case the tag corresponds to a style, then we just ignore it.
-                bool isBackground = (cc == '_');
-                size_t codeSize = 2 + isBackground;
+    // Each cell is a container placed at its area, the cells left empty are skipped.
+    const rect& cell = state->m_Cells[scope.m_Next];
+    tuim::SetCurrentCursor(scope.m_Origin + vec2(cell.x, cell.y));
+    scope.m_IsCellOpen = true;
+    return tuim::BeginContainer(std::format("{}-cell-{}", scope.m_Name, scope.m_Next++), "", vec2(cell.w, cell.h), flags);
+}
 
-                if (i + isBackground + 1 < str.length()) {
-                    char tag = str[i+isBackground+1];
+inline void tuim::EndLayout() {
+    Context* ctx = tuim::GetCtx();
+    if (ctx->m_LayoutsStack.empty())
+        throw std::out_of_range("error: cannot pop empty layouts stack.");
 
-                    // Check for '&r' first, as it's a special reset tag.
-                    if (tag == 'r') {
-                        currentForeground = std::nullopt;
-                        currentBackground = std::nullopt;
-                        currentStyle = Style::NONE;
-                        
-                        // Consume '&r' and possible the background character.
-                        i += codeSize;
-                        continue;
-                    }
+    LayoutScope scope = ctx->m_LayoutsStack.back();
+    ctx->m_LayoutsStack.pop_back();
+    if (scope.m_IsCellOpen)
+        tuim::EndContainer();
+
+    // Continue below the layout.
+    tuim::SetCurrentCursor(vec2(scope.m_Origin.x, scope.m_Origin.y + scope.m_Size.y));
+}
 
-                    // Check user-defined styles
-                    auto styleIt = ctx->m_UserStyles.find(tag);
-                    if (styleIt != ctx->m_UserStyles.end()) {
-                        currentStyle |= styleIt->second;
+/***********************************************************
+*                     WIDGET STATES                        *
+***********************************************************/
 
-                        // Consume the tag and possible the background character.
-                        i += codeSize;
-                        continue;
-                    }
-                    
-                    // Check user-defined colors
-                    auto fgIt = ctx->m_UserColors.find(tag);
-                    if (fgIt != ctx->m_UserColors.end()) {
-                        if (isBackground) currentBackground = fgIt->second;
-                        else currentForeground = fgIt->second;
-                        
-                        // Consume the tag and possible the background character.
-                        i += codeSize;
-                        continue;
-                    }
-                }
+template <typename T> inline T& tuim::StatePool<T>::Get(ItemId id, uint64_t frame) {
+    auto it = m_Slots.find(id);
+    if (it != m_Slots.end()) {
+        m_LastFrames[it->second] = frame;
+        return m_States[it->second];
+    }
+
+    m_Slots[id] = m_States.size();
+    m_States.emplace_back();
+    m_Ids.push_back(id);
+    m_LastFrames.push_back(frame);
+    return m_States.back();
+}
+
+template <typename T> inline T* tuim::StatePool<T>::Find(ItemId id) {
+    auto it = m_Slots.find(id);
+    return (it != m_Slots.end()) ? &m_States[it->second] : nullptr;
+}
+
+template <typename T> inline void tuim::StatePool<T>::CollectGarbage(uint64_t frame, uint64_t lifetime) {
+    // Replace the expired states by the last ones to keep the storage contiguous.
+    for (size_t slot = 0; slot < m_States.size();) {
+        if (frame - m_LastFrames[slot] <= lifetime) {
+            slot++;
+            continue;
+        }
+        m_Slots.erase(m_Ids[slot]);
+        if (slot + 1 < m_States.size()) {
+            m_States[slot] = std::move(m_States.back());
+            m_Ids[slot] = m_Ids.back();
+            m_LastFrames[slot] = m_LastFrames.back();
+            m_Slots[m_Ids[slot]] = slot;
+        }
+        m_States.pop_back();
+        m_Ids.pop_back();
+        m_LastFrames.pop_back();
+    }
+}
+
+inline size_t tuim::NextStateType() {
+    static size_t s_Count = 0;
+    return s_Count++;
+}
+
+template <typename T> inline size_t tuim::GetStateType() {
+    static const size_t s_Type = tuim::NextStateType();
+    return s_Type;
+}
+
+template <typename T> inline T& tuim::GetState(ItemId id) {
+    Context* ctx = tuim::GetCtx();
+    size_t type = tuim::GetStateType<T>();
+    if (type >= ctx->m_StatePools.size())
+        ctx->m_StatePools.resize(type + 1);
+    if (ctx->m_StatePools[type] == nullptr)
+        ctx->m_StatePools[type] = std::make_unique<StatePool<T>>();
+    return static_cast<StatePool<T>*>(ctx->m_StatePools[type].get())->Get(id, ctx->m_FrameCount);
+}
+
+template <typename T> inline T* tuim::FindState(ItemId id) {
+    Context* ctx = tuim::GetCtx();
+    size_t type = tuim::GetStateType<T>();
+    if (type >= ctx->m_StatePools.size() || ctx->m_StatePools[type] == nullptr)
+        return nullptr;
+    return static_cast<StatePool<T>*>(ctx->m_StatePools[type].get())->Find(id);
+}
+
+/***********************************************************
+*                       SCROLLING                          *
+***********************************************************/
+
+template <typename Func> inline bool tuim::ScrollList(const std::string& id, vec2 size, size_t* selected, size_t rowCount, Func&& row, ContainerFlags flags) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+
+    // Create a new item and push it to the stack.
+    ItemId itemId = tuim::StringToId(id);
+    std::shared_ptr<Item> item = std::make_shared<Item>();
+    item->m_Id = itemId;
+    item->m_Pos = frame->m_Cursor;
+    item->m_Size = size;
+    item->m_Flags = ITEM_FLAGS_NONE;
+    tuim::AddItem(item);
+
+    bool hovered = tuim::IsItemHovered();
+    bool hasChanged = false;
+
+    // The selection is moved by Update during navigation, otherwise the value may have been changed by the user.
+    ScrollState& state = tuim::GetState<ScrollState>(itemId);
+    if (state.m_Selected != state.m_LastSelected) {
+        *selected = state.m_Selected;
+        hasChanged = true;
+    }
+    if (rowCount == 0) *selected = 0;
+    else if (*selected >= rowCount) *selected = rowCount - 1;
+    state.m_Selected = *selected;
+    state.m_LastSelected = *selected;
+
+    // Scroll just enough to keep the selected row visible.
+    int border = (flags & CONTAINER_FLAGS_BORDERLESS) ? 0 : 1;
+    size_t visibleRows = std::max(0, size.y - 2 * border);
+    state.m_RowCount = rowCount;
+    state.m_VisibleRows = visibleRows;
+    state.m_Top = item->m_Pos.y + border;
+    if (*selected < state.m_Offset)
+        state.m_Offset = *selected;
+    else if (visibleRows > 0 && *selected >= state.m_Offset + visibleRows)
+        state.m_Offset = *selected - visibleRows + 1;
+    state.m_Offset = std::min(state.m_Offset, rowCount > visibleRows ? rowCount - visibleRows : 0);
+
+    // The rows may create other states, which would invalidate the reference.
+    size_t offset = state.m_Offset;
+
+    if (tuim::BeginContainer(id + "-container", "", size, flags)) {
+        // Only the visible window of rows is built, whatever the number of rows.
+        size_t last = std::min(rowCount, offset + visibleRows);
+        for (size_t index = offset; index < last; index++) {
+            tuim::SetCurrentCellStyle(CellStyle());
+            tuim::SetCurrentCursor(vec2(0, index - offset));
+            row(index, hovered && index == *selected);
+        }
+        tuim::SetCurrentCellStyle(CellStyle());
+
+        // Draw the scrollbar over the last column, the thumb is proportional to the visible part of the list.
+        int width = size.x - 2 * border;
+        if (rowCount > visibleRows && width > 1) {
+            size_t thumbSize = std::max<size_t>(1, visibleRows * visibleRows / rowCount);
+            size_t thumbPos = offset * (visibleRows - thumbSize) / (rowCount - visibleRows);
+            for (size_t y = 0; y < visibleRows; y++) {
+                bool thumb = (y >= thumbPos && y < thumbPos + thumbSize);
+                tuim::SetCurrentCursor(vec2(width - 1, y));
+                tuim::DrawGlyph(thumb ? U'█' : U'│', CellStyle());
             }
         }
+    }
+    tuim::EndContainer();
 
-        escaped = false;
+    return hasChanged;
+}
+
+inline bool tuim::ScrollNavigate(ScrollState& state, char32_t keyCode) {
+    if (state.m_RowCount == 0)
+        return false;
+
+    size_t page = std::max<size_t>(1, state.m_VisibleRows);
+    size_t last = state.m_RowCount - 1;
+
+    if (keyCode == Key::UP) {
+        if (state.m_Selected == 0) return false;
+        state.m_Selected--;
+    }
+    else if (keyCode == Key::DOWN) {
+        if (state.m_Selected >= last) return false;
+        state.m_Selected++;
+    }
+    else if (keyCode == Key::PAGE_UP) state.m_Selected = (state.m_Selected > page) ? state.m_Selected - page : 0;
+    else if (keyCode == Key::PAGE_DOWN) state.m_Selected = std::min(last, state.m_Selected + page);
+    else if (keyCode == Key::HOME) state.m_Selected = 0;
+    else if (keyCode == Key::END) state.m_Selected = last;
+    else return false;
+
+    return true;
+}
+
+/***********************************************************
+*                        DRAWING                           *
+***********************************************************/
+
+inline tuim::CellStyle tuim::GetCurrentCellStyle() {
+    Context* ctx = tuim::GetCtx();
+    return CellStyle{ ctx->m_CurrentForeground, ctx->m_CurrentBackground, ctx->m_CurrentStyle };
+}
+
+inline void tuim::SetCurrentCellStyle(const CellStyle& style) {
+    Context* ctx = tuim::GetCtx();
+    ctx->m_CurrentForeground = style.m_Foreground;
+    ctx->m_CurrentBackground = style.m_Background;
+    ctx->m_CurrentStyle = style.m_Style;
+}
+
+inline void tuim::DrawGlyph(char32_t ch, const CellStyle& style) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    frame->DrawCluster(std::u32string_view(&ch, 1), style, tuim::GetCtx()->m_TerminalSize);
+}
+
+inline void tuim::DrawText(std::string_view text, const CellStyle& style, int maxWidth) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    vec2 terminalSize = tuim::GetCtx()->m_TerminalSize;
+
+    static thread_local std::u32string s_Chars;
+    s_Chars.clear();
+    tuim::Utf8DecodeString(text, s_Chars, nullptr);
+    std::u32string_view chars = s_Chars;
+
+    int width = 0;
+    for (size_t i = 0; i < chars.size();) {
+        size_t clusterLength = tuim::GraphemeLength(chars, i);
+        std::u32string_view cluster = chars.substr(i, clusterLength);
+        if (chars[i] == '\n') {
+            frame->m_Cursor.x = 0;
+            frame->m_Cursor.y++;
+            width = 0;
+        }
+        else if (maxWidth >= 0) {
+            width += std::max(0, tuim::GraphemeWidth(cluster));
+            if (width > maxWidth)
+                break;
+            frame->DrawCluster(cluster, style, terminalSize);
+        }
+        else frame->DrawCluster(cluster, style, terminalSize);
+        i += clusterLength;
+    }
+}
+
+inline void tuim::FillRect(const vec2& pos, const vec2& size, char32_t ch, const CellStyle& style) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    vec2 terminalSize = tuim::GetCtx()->m_TerminalSize;
+    vec2 cursor = frame->m_Cursor;
+
+    int width = std::max(1, tuim::Utf8CharWidth(ch));
+    for (int y = 0; y < size.y; y++) {
+        frame->m_Cursor = vec2(pos.x, pos.y + y);
+        for (int x = 0; x + width <= size.x; x += width)
+            frame->DrawCluster(std::u32string_view(&ch, 1), style, terminalSize);
+    }
+
+    // Filling a rectangle doesn't move the cursor.
+    frame->m_Cursor = cursor;
+}
+
+inline void tuim::DrawBar(int width, float fraction, char32_t ch, const CellStyle& filled, const CellStyle& empty) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    vec2 terminalSize = tuim::GetCtx()->m_TerminalSize;
+
+    float filledWidth = fraction * width;
+    for (int t = 0; t < width; t++)
+        frame->DrawCluster(std::u32string_view(&ch, 1), (t < filledWidth ? filled : empty), terminalSize);
+}
 
-        // Handle regular characters (not style tags)
-        uint8_t charLength = tuim::Utf8CharLength(c);
-        if (charLength == 0 || i + charLength > str.length()) {
-            // Invalid UTF-8 sequence, treat as single byte and advance.
-            charLength = 1;
+template <typename Func> inline void tuim::PrintFields(std::string_view fmt, Func&& field) {
+    std::string literal;
+    size_t autoIndex = 0;
+
+    size_t i = 0;
+    while (i < fmt.length()) {
+        char c = fmt[i];
+
+        // Escaped braces.
+        if ((c == '{' || c == '}') && i + 1 < fmt.length() && fmt[i+1] == c) {
+            literal += c;
+            i += 2;
+            continue;
+        }
+
+        // Replacement field: {}, {index} or {index:spec}.
+        if (c == '{') {
+            size_t end = fmt.find('}', i);
+            if (end == std::string_view::npos)
+                break;
+
+            std::string_view content = fmt.substr(i + 1, end - i - 1);
+            size_t colon = content.find(':');
+            std::string_view indexStr = content.substr(0, colon);
+            std::string_view spec = (colon == std::string_view::npos) ? std::string_view() : content.substr(colon);
+
+            size_t index = autoIndex++;
+            if (!indexStr.empty())
+                std::from_chars(indexStr.data(), indexStr.data() + indexStr.size(), index);
+
+            // Print the pending literal so that the field is drawn at the right position.
+            tuim::PrintUnformatted(literal);
+            literal.clear();
+            field(index, spec);
+
+            i = end + 1;
+            continue;
+        }
+
+        literal += c;
+        i++;
+    }
+
+    tuim::PrintUnformatted(literal);
+}
+
+/***********************************************************
+*                         ITEMS                            *
+***********************************************************/
+    
+template <typename... Args> inline void tuim::Print(const std::string& fmt, Args&&... args) {
+    tuim::PrintUnformatted(std::vformat(fmt, std::make_format_args(args...)));
+}
+
+inline void tuim::PrintUnformatted(std::string_view str) {
+    Context* ctx = tuim::GetCtx();
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+
+    // Decode the whole string at once, formatting tags are ASCII so they can be parsed from the characters.
+    static thread_local std::u32string s_Chars;
+    s_Chars.clear();
+    tuim::Utf8DecodeString(str, s_Chars, nullptr);
+    const std::u32string& chars = s_Chars;
+    const size_t length = chars.size();
+
+    // Retrieve the current active styles from context.
+    CellStyle currentStyle{ ctx->m_CurrentForeground, ctx->m_CurrentBackground, ctx->m_CurrentStyle };
+
+    vec2 terminalSize = ctx->m_TerminalSize;
+    bool escaped = false;
+
+    size_t i = 0;
+    while (i < length) {
+        char32_t c = chars[i];
+        char32_t cc = (i+1 < length) ? chars[i+1] : U'\0';
+
+        if (!escaped && (c == '#' || c == '&')) {
+            // Escape the formatting tag by repeating the same character.
+            if (cc == c) {
+                escaped = true;
+                i++;
+                continue;
+            }
+
+            size_t tagLength = tuim::ParseFormattingTag(chars, i, currentStyle);
+            if (tagLength > 0) {
+                i += tagLength;
+                continue;
+            }
         }
-        char32_t ch = tuim::Utf8Decode(str.data() + i, charLength);
+
+        escaped = false;
 
         // tab: advance cursor by 4, filling with space cells that have current styles.
-        if (ch == '\t') {
+        if (c == '\t') {
             for (int k = 0; k < 4; k++) {
                 // Ensure we don't write beyond the terminal width.
-                if (frame->m_Cursor.x >= tuim::Terminal::GetTerminalSize().x)
+                if (frame->m_Cursor.x >= terminalSize.x)
                     break;
-                std::shared_ptr<Cell> cell = std::make_shared<Cell>(U' ');
-                CopyStylesToCell(cell);
-                frame->Set(frame->m_Cursor, cell);
-                frame->m_Cursor.x++;
+                frame->DrawCluster(U" ", currentStyle, terminalSize);
             }
+            i++;
         }
         // new line: move cursor to beginning of next line.
-        else if (ch == '\n') {
+        else if (c == '\n') {
             frame->m_Cursor.x = 0;
             frame->m_Cursor.y++;
+            i++;
         }
         else {
+            // Extend the character to its whole grapheme cluster (combining marks, emoji sequences...)
+            // so that it is drawn in a single cell.
+            size_t clusterLength = tuim::GraphemeLength(chars, i);
+            std::u32string_view cluster = std::u32string_view(chars).substr(i, clusterLength);
+
             // Regular printable character
             // Ensure we don't write beyond the terminal boundaries
-            if (frame->m_Cursor.x < tuim::Terminal::GetTerminalSize().x && frame->m_Cursor.y < tuim::Terminal::GetTerminalSize().y) {
-                std::shared_ptr<Cell> cell = std::make_shared<Cell>(ch);
-                CopyStylesToCell(cell);
-                frame->Set(frame->m_Cursor, cell);
-
-                uint8_t width = tuim::Utf8CharWidth(ch);
-                frame->m_Cursor.x += width;
-            }
+            if (frame->m_Cursor.x < terminalSize.x && frame->m_Cursor.y < terminalSize.y)
+                frame->DrawCluster(cluster, currentStyle, terminalSize);
+            i += clusterLength; // Move to the next grapheme cluster
         }
-        i += charLength; // Move to the next UTF-8 character
     }
 
     // After processing the entire string, update the context's current styles.
     // This ensures that subsequent Print calls inherit the styles active at the end of this Print.
-    ctx->m_CurrentForeground = currentForeground;
-    ctx->m_CurrentBackground = currentBackground;
-    ctx->m_CurrentStyle = currentStyle;
+    tuim::SetCurrentCellStyle(currentStyle);
+}
+
+inline size_t tuim::ParseFormattingTag(std::u32string_view chars, size_t index, CellStyle& style) {
+    Context* ctx = tuim::GetCtx();
+    const size_t length = chars.size();
+    char32_t c = chars[index];
+    char32_t cc = (index+1 < length) ? chars[index+1] : U'\0';
+
+    if (c == '#') {
+        // Possible hex color: #rrggbb or #_rrggbb.
+        bool isBackground = (cc == '_');
+        size_t codeSize = 1 + isBackground + 6;
+
+        // Check if there are enough characters for a hex code (6 characters).
+        if (index + codeSize > length)
+            return 0;
+        char code[8];
+        for (size_t k = 0; k < codeSize; k++)
+            code[k] = static_cast<char>(chars[index + k]);
+        Color newColor = tuim::StringToColor(std::string_view(code, codeSize));
+        if (isBackground) style.m_Background = newColor;
+        else style.m_Foreground = newColor;
+        return codeSize;
+    }
+
+    if (c == '&') {
+        // Determine if the color is used as a foreground or background.
+        // In case the tag corresponds to a style, then we just ignore it.
+        bool isBackground = (cc == '_');
+        size_t codeSize = 2 + isBackground;
+        if (index + isBackground + 1 >= length || chars[index+isBackground+1] >= 0x80)
+            return 0;
+        char tag = static_cast<char>(chars[index+isBackground+1]);
+
+        // Check for '&r' first, as it's a special reset tag.
+        if (tag == 'r') {
+            style = CellStyle();
+            return codeSize;
+        }
+
+        // Check user-defined styles
+        auto styleIt = ctx->m_UserStyles.find(tag);
+        if (styleIt != ctx->m_UserStyles.end()) {
+            style.m_Style |= styleIt->second;
+            return codeSize;
+        }
+
+        // Check user-defined colors
+        auto fgIt = ctx->m_UserColors.find(tag);
+        if (fgIt != ctx->m_UserColors.end()) {
+            if (isBackground) style.m_Background = fgIt->second;
+            else style.m_Foreground = fgIt->second;
+            return codeSize;
+        }
+    }
+
+    return 0;
 }
 
 inline bool tuim::Button(const std::string& id, const std::string& text, tuim::ItemFlags flags) {
@@ -1500,54 +3599,97 @@ inline bool tuim::Button(const std::string& id, const std::string& text, tuim::I
     return tuim::IsItemActive();
 }
 
-inline bool tuim::TextInput(const std::string& id, std::string_view fmt, std::string* value, InputTextFlags flags) {
-    static size_t s_Cursor = value->length();
-    
+inline bool tuim::TextInput(const std::string& id, std::string_view fmt, std::string* value, InputTextFlags flags, int width) {
     std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
 
     // Create a new item and push it to the stack.
     ItemId itemId = tuim::StringToId(id);
     std::shared_ptr<Item> item = std::make_shared<Item>();
     item->m_Id = itemId;
-    // item->m_Size = vec2(text.size(), 1); // TODO: replace with CalcTextWidth().
     item->m_Pos = frame->m_Cursor;
     item->m_Flags = ITEM_FLAGS_STAY_ACTIVE;
     tuim::AddItem(item);
 
     bool hasChanged = false;
+    bool hasEdited = false;
+    TextInputState& state = tuim::GetState<TextInputState>(itemId);
+    GapBuffer& buffer = state.m_Buffer;
+
+    // Without confirmation, the edits are applied to the value as well so that it never has to be copied back as a whole.
+    // Otherwise the value is only written when the input is confirmed or left.
+    bool live = !(flags & INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER);
+    auto Insert = [&](std::string_view text) {
+        buffer.Insert(state.m_Cursor, text);
+        if (live) value->insert(state.m_Cursor, text);
+        state.m_Cursor += text.size();
+        hasEdited = true;
+    };
+    auto Erase = [&](size_t index, size_t length) {
+        buffer.Erase(index, length);
+        if (live) value->erase(index, length);
+        hasEdited = true;
+    };
 
     // Handle keyboard inputs to change text, move cursor...
     if (tuim::IsItemActive()) {
-        // Make sure that the cursor doesn't go out of range, especially
-        // when switching between different text inputs.
-        if (s_Cursor > value->length())
-            s_Cursor = value->length();
+        // The value has been changed by the caller while it was edited, the edits must apply to its new content.
+        // A new value is moved or resized, which is checked in constant time before comparing the whole text.
+        // Changes made in place are only looked for next to the cursor, where they would change the length of the next edit.
+        if (live) {
+            bool changed = (value->data() != state.m_ValueData || value->size() != state.m_ValueSize) && !buffer.Equals(*value);
+            size_t cursor = std::min(state.m_Cursor, buffer.GetSize());
+            size_t end = std::min({ cursor + 4, value->size(), buffer.GetSize() });
+            for (size_t i = (cursor > 4 ? cursor - 4 : 0); !changed && i < end; i++)
+                changed = (buffer.At(i) != (*value)[i]);
+            if (changed)
+                buffer.SetText(*value);
+        }
+        if (state.m_Cursor > buffer.GetSize())
+            state.m_Cursor = buffer.GetSize();
 
         if (tuim::IsKeyPressed(Key::ESCAPE)) {
             tuim::SetActiveItemId(0);
         }
         else if (tuim::IsKeyPressed(Key::LEFT)) {
-            s_Cursor = tuim::Utf8CharLastIndex(*value, s_Cursor);
+            state.m_Cursor = buffer.PrevIndex(state.m_Cursor);
         }
         else if (tuim::IsKeyPressed(Key::RIGHT)) {
-            s_Cursor = tuim::Utf8CharNextIndex(*value, s_Cursor);
+            state.m_Cursor = buffer.NextIndex(state.m_Cursor);
+        }
+        else if (tuim::IsKeyPressed(Key::HOME)) {
+            state.m_Cursor = 0;
+        }
+        else if (tuim::IsKeyPressed(Key::END)) {
+            state.m_Cursor = buffer.GetSize();
         }
         else if (tuim::IsKeyPressed(Key::DELETE)) {
-            if (s_Cursor < value->length()) {
-                size_t nextIndex = tuim::Utf8CharNextIndex(*value, s_Cursor);
-                *value = value->erase(s_Cursor, nextIndex - s_Cursor);
-                if (!(flags & INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER))
-                    hasChanged = true;
-            }
+            if (state.m_Cursor < buffer.GetSize())
+                Erase(state.m_Cursor, buffer.NextIndex(state.m_Cursor) - state.m_Cursor);
         }
         else if (tuim::IsKeyPressed(Key::BACKSPACE)) {
-            if (s_Cursor > 0) {
-                size_t lastIndex = tuim::Utf8CharLastIndex(*value, s_Cursor);
-                *value = value->erase(lastIndex, s_Cursor - lastIndex);
-                s_Cursor = lastIndex;
-                if (!(flags & INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER))
-                    hasChanged = true;
+            if (state.m_Cursor > 0) {
+                size_t lastIndex = buffer.PrevIndex(state.m_Cursor);
+                Erase(lastIndex, state.m_Cursor - lastIndex);
+                state.m_Cursor = lastIndex;
+            }
+        }
+        else if (tuim::IsKeyPressed(Key::PASTE)) {
+            // The pasted text is inserted at once, without the characters that cannot be typed in the input.
+            std::string text;
+            std::string_view paste = tuim::GetPastedText();
+            text.reserve(paste.size());
+            for (char c : paste) {
+                unsigned char byte = c;
+                if (byte < 0x20 || byte == 0x7F)
+                    continue;
+                if (flags & INPUT_TEXT_FLAGS_NUMERIC_ONLY && !std::isdigit(byte))
+                    continue;
+                if (flags & INPUT_TEXT_FLAGS_ALPHANUMERIC_ONLY && (byte >= 0x80 || !std::isalnum(byte)))
+                    continue;
+                text.push_back(c);
             }
+            if (!text.empty())
+                Insert(text);
         }
         else {
             char32_t keyCode = ctx->m_PressedKeyCode;
@@ -1557,10 +3699,7 @@ inline bool tuim::TextInput(const std::string& id, std::string_view fmt, std::st
                 if ((flags & INPUT_TEXT_FLAGS_NUMERIC_ONLY && tuim::IsDigit(ch))
                 || (flags & INPUT_TEXT_FLAGS_ALPHANUMERIC_ONLY && tuim::IsAlphaNumeric(ch))
                 || !(flags & (INPUT_TEXT_FLAGS_NUMERIC_ONLY | INPUT_TEXT_FLAGS_ALPHANUMERIC_ONLY))) {
-                    value->insert(s_Cursor, ch);
-                    s_Cursor += ch.length();
-                    if (!(flags & INPUT_TEXT_FLAGS_CONFIRM_ON_ENTER))
-                        hasChanged = true;
+                    Insert(ch);
                 }
             }
         }
@@ -1573,7 +3712,9 @@ inline bool tuim::TextInput(const std::string& id, std::string_view fmt, std::st
                 hasChanged = true;
             }
             else {
-                s_Cursor = value->length();
+                buffer.SetText(*value);
+                state.m_Cursor = buffer.GetSize();
+                state.m_Scroll = 0;
                 tuim::SetActiveItemId(item->m_Id);
             }
         }
@@ -1582,49 +3723,93 @@ inline bool tuim::TextInput(const std::string& id, std::string_view fmt, std::st
     }
     else tuim::Print("[ ] ");
 
-    
-    // Calculate how the text should be displayed with highlighting and escaped formatting.
-    std::string displayedValue = "#_555555";
-    for (size_t i = 0; i < value->length();) {
-        size_t charLength = tuim::Utf8CharLength((*value)[i]);
-        std::string ch = std::string(value->data()+i, charLength);
-
-        // Escape tuim formatting.
-        if (tuim::IsItemActive() && ch == "#")
-            ch += '#';
-        if (tuim::IsItemActive() && ch == "&")
-            ch += '&';
-        if (ch == "{")
-            ch += '{';
-        if (ch == "}")
-            ch += '}';
-
-        // Add cursor to be displayed.
-        if (tuim::IsItemActive() && !tuim::IsKeyPressed() && s_Cursor == i) {
-            displayedValue += "#_ffffff#555555";
-            displayedValue += ch;
-            displayedValue += "&r#_555555";
-        }
-        else {
-            displayedValue += ch;
-        }
-
-        i += charLength;
+    // The edits are written to the value once the input is confirmed or left, or reported at once without confirmation.
+    bool active = tuim::IsItemActive();
+    if (hasEdited) {
+        if (live) hasChanged = true;
+        else state.m_Editing = true;
+    }
+    if (state.m_Editing && !active) {
+        *value = buffer.GetText();
+        state.m_Editing = false;
     }
+    state.m_ValueData = value->data();
+    state.m_ValueSize = value->size();
 
-    // Add cursor if it is at the end the text.
-    if (tuim::IsItemActive() && !tuim::IsKeyPressed() && s_Cursor >= value->length())
-        displayedValue += "#_ffffff ";
+    // Draw the value directly (formatting tags are not parsed) with the cursor highlighted.
+    const CellStyle fieldStyle = { std::nullopt, Color(0x55, 0x55, 0x55, true), Style::NONE };
+    const CellStyle cursorStyle = { Color(0x55, 0x55, 0x55), Color(0xff, 0xff, 0xff, true), Style::NONE };
+    bool showCursor = (active && !tuim::IsKeyPressed());
 
-    // Reset any styles after the input text.
-    displayedValue += "&r";
+    vec2 start = frame->m_Cursor;
+    tuim::PrintFields(fmt, [&](size_t index, [[maybe_unused]] std::string_view spec) {
+        if (index != 0)
+            return;
 
-    std::string text = std::vformat(fmt, std::make_format_args(displayedValue));
-    item->m_Size = vec2(tuim::CalcTextWidth(text), 1);
+        // By default, the field takes the remaining width of the container.
+        int fieldWidth = width;
+        if (fieldWidth <= 0) {
+            std::shared_ptr<Container> container = tuim::GetCurrentContainer();
+            int border = (container->m_ContainerFlags & CONTAINER_FLAGS_BORDERLESS) ? 0 : 1;
+            fieldWidth = container->m_Size.x - 2 * border - frame->m_Cursor.x;
+        }
+        fieldWidth = std::max(1, fieldWidth);
+        int fieldStart = frame->m_Cursor.x;
+
+        // Only a slice of the value is copied and drawn, its size is bounded by the width of the field.
+        size_t size = active ? buffer.GetSize() : value->size();
+        size_t scroll = 0;
+        if (active) {
+            // Scroll just enough to keep the cursor visible, measuring backwards from it.
+            scroll = std::min(state.m_Scroll, state.m_Cursor);
+            static thread_local std::string s_Before;
+            buffer.GetRange(scroll, state.m_Cursor - scroll, s_Before);
+            if (s_Before.size() > (size_t) fieldWidth * 4 || (int) tuim::CalcPlainTextWidth(s_Before) >= fieldWidth) {
+                scroll = state.m_Cursor;
+                int columns = 1;
+                while (scroll > 0) {
+                    size_t previous = buffer.PrevIndex(scroll);
+                    char bytes[4];
+                    size_t count = std::min<size_t>(scroll - previous, sizeof(bytes));
+                    for (size_t k = 0; k < count; k++)
+                        bytes[k] = buffer.At(previous + k);
+                    char32_t ch;
+                    tuim::Utf8DecodeNext(std::string_view(bytes, count), 0, ch);
+                    columns += std::max(0, tuim::Utf8CharWidth(ch));
+                    if (columns > fieldWidth)
+                        break;
+                    scroll = previous;
+                }
+            }
+            state.m_Scroll = scroll;
+        }
 
-    // Display the actual input text.
-    tuim::Print(text);
+        static thread_local std::string s_Slice;
+        size_t length = std::min(size - scroll, (size_t) fieldWidth * 8);
+        if (active) buffer.GetRange(scroll, length, s_Slice);
+        else s_Slice.assign(*value, 0, length);
+        std::string_view slice = s_Slice;
+
+        if (!showCursor) {
+            tuim::DrawText(slice, fieldStyle, fieldWidth);
+        }
+        else {
+            size_t cursor = std::min(state.m_Cursor - scroll, slice.size());
+            size_t next = std::min(slice.size(), cursor + tuim::Utf8GraphemeLength(slice, cursor));
+            tuim::DrawText(slice.substr(0, cursor), fieldStyle, fieldWidth);
+            if (cursor < slice.size()) tuim::DrawText(slice.substr(cursor, next - cursor), cursorStyle);
+            else tuim::DrawGlyph(U' ', cursorStyle); // Add cursor if it is at the end the text.
+            int remaining = fieldWidth - (frame->m_Cursor.x - fieldStart);
+            if (remaining > 0)
+                tuim::DrawText(slice.substr(next), fieldStyle, remaining);
+        }
+
+        // Reset any styles after the input text.
+        tuim::SetCurrentCellStyle(CellStyle());
+    });
+    item->m_Size = vec2(frame->m_Cursor.x - start.x, 1);
 
+    tuim::FitItemToCursor();
     return hasChanged;
 }
 
@@ -1652,12 +3837,15 @@ inline bool tuim::Checkbox(const std::string& id, std::string_view fmt, bool* va
     }
     else tuim::Print("[ ] ");
 
-    std::string text = std::vformat(fmt, std::make_format_args((*value ? "✔" : "✗")));
-    item->m_Size = vec2(tuim::CalcTextWidth(text), 1);
-
-    // Display the actual input text.
-    tuim::Print(text);
+    // Display the check mark with the styles of the surrounding text.
+    vec2 start = frame->m_Cursor;
+    tuim::PrintFields(fmt, [&](size_t index, [[maybe_unused]] std::string_view spec) {
+        if (index == 0)
+            tuim::DrawGlyph((*value ? U'✔' : U'✗'), tuim::GetCurrentCellStyle());
+    });
+    item->m_Size = vec2(frame->m_Cursor.x - start.x, 1);
 
+    tuim::FitItemToCursor();
     return hasChanged;
 }
 
@@ -1669,7 +3857,7 @@ inline bool tuim::IntSlider(const std::string& id, std::string_view fmt, int* va
     std::shared_ptr<Item> item = std::make_shared<Item>();
     item->m_Id = itemId;
     item->m_Pos = frame->m_Cursor;
-    item->m_Flags = ITEM_FLAGS_NONE;
+    item->m_Flags = ITEM_FLAGS_USE_LEFT_RIGHT;
     tuim::AddItem(item);
 
     bool hasChanged = false;
@@ -1697,23 +3885,24 @@ inline bool tuim::IntSlider(const std::string& id, std::string_view fmt, int* va
     }
     else tuim::Print("[ ] ");
 
-    std::string text = "";
-    text += "#555555";
-    float prct = ((float) (*value - min) / (float) (max-min))*width;
-    for(int t = 0; t < width; t++) {
-        if (t >= prct) text += "&r";
-        text += "█";
-    }
-    text += "&r";
-
     // TODO: use a static variable to change the value manually.
     // if (tuim::IsItemHovered() && tuim::IsKeyPressed(Key::ENTER)) {}
 
-    text = std::vformat(fmt, std::make_format_args(text, *value));
-    item->m_Size = vec2(tuim::CalcTextWidth(text), 1);
-    
-    tuim::Print(text);
+    // The first field is the slider bar and the second one is the value.
+    vec2 start = frame->m_Cursor;
+    tuim::PrintFields(fmt, [&](size_t index, std::string_view spec) {
+        if (index == 0) {
+            float fraction = (float) (*value - min) / (float) (max-min);
+            tuim::DrawBar(width, fraction, U'█', CellStyle{ Color(0x55, 0x55, 0x55), std::nullopt, Style::NONE }, CellStyle());
+            tuim::SetCurrentCellStyle(CellStyle());
+        }
+        else if (index == 1) {
+            tuim::PrintUnformatted(std::vformat(std::format("{{{}}}", spec), std::make_format_args(*value)));
+        }
+    });
+    item->m_Size = vec2(frame->m_Cursor.x - start.x, 1);
 
+    tuim::FitItemToCursor();
     return hasChanged;
 }
 
@@ -1725,7 +3914,7 @@ inline bool tuim::FloatSlider(const std::string& id, std::string_view fmt, float
     std::shared_ptr<Item> item = std::make_shared<Item>();
     item->m_Id = itemId;
     item->m_Pos = frame->m_Cursor;
-    item->m_Flags = ITEM_FLAGS_NONE;
+    item->m_Flags = ITEM_FLAGS_USE_LEFT_RIGHT;
     tuim::AddItem(item);
 
     bool hasChanged = false;
@@ -1753,23 +3942,24 @@ inline bool tuim::FloatSlider(const std::string& id, std::string_view fmt, float
     }
     else tuim::Print("[ ] ");
 
-    std::string text = "";
-    text += "#555555";
-    float prct = ((float) (*value - min) / (float) (max-min))*width;
-    for(int t = 0; t < width; t++) {
-        if (t >= prct) text += "&r";
-        text += "█";
-    }
-    text += "&r";
-
     // TODO: use a static variable to change the value manually.
     // if (tuim::IsItemHovered() && tuim::IsKeyPressed(Key::ENTER)) {}
 
-    text = std::vformat(fmt, std::make_format_args(text, *value));
-    item->m_Size = vec2(tuim::CalcTextWidth(text), 1);
-    
-    tuim::Print(text);
+    // The first field is the slider bar and the second one is the value.
+    vec2 start = frame->m_Cursor;
+    tuim::PrintFields(fmt, [&](size_t index, std::string_view spec) {
+        if (index == 0) {
+            float fraction = (float) (*value - min) / (float) (max-min);
+            tuim::DrawBar(width, fraction, U'█', CellStyle{ Color(0x55, 0x55, 0x55), std::nullopt, Style::NONE }, CellStyle());
+            tuim::SetCurrentCellStyle(CellStyle());
+        }
+        else if (index == 1) {
+            tuim::PrintUnformatted(std::vformat(std::format("{{{}}}", spec), std::make_format_args(*value)));
+        }
+    });
+    item->m_Size = vec2(frame->m_Cursor.x - start.x, 1);
 
+    tuim::FitItemToCursor();
     return hasChanged;
 }
 
@@ -1781,7 +3971,7 @@ inline bool tuim::EnumInput(const std::string& id, std::string_view fmt, size_t*
     std::shared_ptr<Item> item = std::make_shared<Item>();
     item->m_Id = itemId;
     item->m_Pos = frame->m_Cursor;
-    item->m_Flags = ITEM_FLAGS_NONE;
+    item->m_Flags = ITEM_FLAGS_USE_LEFT_RIGHT;
     tuim::AddItem(item);
 
     bool hasChanged = false;
@@ -1816,10 +4006,21 @@ inline bool tuim::EnumInput(const std::string& id, std::string_view fmt, size_t*
     
     tuim::Print(text);
 
+    tuim::FitItemToCursor();
     return hasChanged;
 }
 
 inline bool tuim::Image(const std::string& id, const std::vector<std::string>& lines, ImageFlags flags) {
+    // The lines are only measured and parsed again when they change.
+    ImageState& state = tuim::GetState<ImageState>(tuim::StringToId(id));
+    if (state.m_Lines != lines || (state.m_Image.m_Cells.empty() && !lines.empty())) {
+        state.m_Lines = lines;
+        state.m_Image.SetLines(lines);
+    }
+    return tuim::Image(id, state.m_Image, flags);
+}
+
+inline bool tuim::Image(const std::string& id, const ImageData& image, ImageFlags flags) {
     std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
 
     // Create a new item and push it to the stack.
@@ -1827,7 +4028,7 @@ inline bool tuim::Image(const std::string& id, const std::vector<std::string>& l
     std::shared_ptr<Item> item = std::make_shared<Item>();
     item->m_Id = itemId;
     item->m_Pos = frame->m_Cursor;
-    item->m_Size = vec2(0, lines.size());
+    item->m_Size = image.m_Size;
     item->m_Flags = (flags & IMAGE_FLAGS_CLICKABLE) ? ITEM_FLAGS_NONE : ITEM_FLAGS_DISABLED;
     tuim::AddItem(item);
 
@@ -1839,14 +4040,6 @@ inline bool tuim::Image(const std::string& id, const std::vector<std::string>& l
         hasChanged = true;
     }
 
-    // Loop over the lines to determine the maximum width of the image.
-    // TODO: avoid looping twice over the lines.
-    for (const std::string& line : lines) {
-        size_t lineWidth = tuim::CalcTextWidth(line);
-        if (item->m_Size.x < lineWidth)
-            item->m_Size.x = lineWidth;
-    }
-
     if (hasContainer) {
         tuim::BeginContainer(
             id + "-container",
@@ -1856,12 +4049,11 @@ inline bool tuim::Image(const std::string& id, const std::vector<std::string>& l
         );
     }
 
-    if (displayEmptyBorder) tuim::Print("\n");
-    for (const std::string& line : lines) {
-        if (displayEmptyBorder) tuim::Print(" ");
-        tuim::Print(line + "\n");
-    }
-    if (displayEmptyBorder) tuim::Print("\n");
+    // The cells are copied as they are, the lines are left like Print would.
+    vec2 start = tuim::GetCurrentCursor();
+    if (displayEmptyBorder) tuim::SetCurrentCursor(start + vec2(1, 1));
+    tuim::DrawImage(image);
+    tuim::SetCurrentCursor(vec2(0, start.y + image.m_Size.y + (displayEmptyBorder ? 2 : 0)));
 
     if (hasContainer) {
         tuim::EndContainer();
@@ -1870,7 +4062,8 @@ inline bool tuim::Image(const std::string& id, const std::vector<std::string>& l
     return hasChanged;
 }
 
-inline void tuim::Paragraph(const std::string& id, const std::string& text, uint width) {
+inline void tuim::Paragraph(const std::string& id, const std::string& text, uint width, ParagraphFlags flags) {
+    Context* ctx = tuim::GetCtx();
     std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
 
     // Create a new item and push it to the stack.
@@ -1882,93 +4075,2857 @@ inline void tuim::Paragraph(const std::string& id, const std::string& text, uint
     item->m_Flags = ITEM_FLAGS_DISABLED;
     tuim::AddItem(item);
 
-    size_t i = 0;
-    std::string line = "";
-    size_t lineCharLength = 0;
-    size_t lineBlankCount = 0;
-
-    bool lineBreak = false;
-
-    while(i < text.length()) {
-        size_t wordBytesLen = 0;
-        size_t wordChLen = 0;
-        size_t wordPos = i;
-
-        // Count byte and char length of next word (until end of text or space).
-        while(wordPos < text.length() && text[wordPos] != ' ' && text[wordPos] != '\n') {
-            wordBytesLen += tuim::Utf8CharLength(text[wordPos]);
-            wordChLen++;
-            wordPos = i + wordBytesLen;
-        }
-
-        bool skipNextLine = (wordPos < text.length() && text[wordPos] == '\n');
-        bool isEOL = lineCharLength > 0 && (lineCharLength + wordChLen) >= width;
-
-        std::string word = text.substr(i, wordBytesLen);
-        wordChLen = tuim::CalcTextWidth(word);
-
-        // Handle the end of line (need at least one word).
-        if (isEOL || lineBreak) {
-
-            // Count the number of spaces/words for each line and find the number of blank missing to reach EOL.
-            // Distribute additional spaces between each words to fill the blank at EOL.
-            if (lineCharLength > 0) {
-                int diff = width - lineCharLength;
-                if (diff > 0 && !lineBreak && lineBlankCount > 0) {
-                    float step = (float) diff / (float) (lineBlankCount);
-                    int blank_count = 0;
-                    float acc = 0.f;
-                    while(blank_count < diff) {
-                        for(size_t k = 0; k < line.length(); k += tuim::Utf8CharLength(line[k])) {
-                            if (blank_count == diff)
-                                break;
-                            if (line[k] != ' ')
-                                continue;
-                            if (acc >= 1.f) {
-                                line.insert(k, 1, ' ');
-                                k++;
-                                blank_count++;
-                                acc -= 1.f;
-                            }
-                            acc += step;
-                        }
-                    }
-                }
-                tuim::Print(line);
-                // printf("\tdiff: %d ; step: %f ; acc: %f ; t: %d ; c: %d", diff, step, acc, lineBlankCount, blank_count);
-            }
-            
-            tuim::Print("\n");
+    // Retrieve the layout of the text for this width and these flags, the words are only split, measured,
+    // parsed and broken into lines once. The key is the text followed by the width and the flags.
+    static thread_local std::string s_Key;
+    s_Key.assign(text);
+    s_Key.push_back('\0');
+    s_Key.append(reinterpret_cast<const char*>(&width), sizeof(width));
+    s_Key.append(reinterpret_cast<const char*>(&flags), sizeof(flags));
+
+    CellStyle baseStyle{ ctx->m_CurrentForeground, ctx->m_CurrentBackground, ctx->m_CurrentStyle };
+    ParagraphLayout* layout = ctx->m_ParagraphCache.Find(s_Key);
+    if (layout == nullptr) {
+        ParagraphLayout newLayout;
+        newLayout.m_Words = tuim::TokenizeParagraph(text);
+        newLayout.m_Width = width;
+        newLayout.m_Flags = flags;
+        tuim::BreakParagraph(newLayout);
+        tuim::ShapeParagraph(newLayout, text, baseStyle);
+        layout = &ctx->m_ParagraphCache.Insert(s_Key, std::move(newLayout));
+    }
+    else if (layout->m_BaseStyle != baseStyle) {
+        // The formatting tags only have to be parsed again if the paragraph does not start with the same style.
+        tuim::ShapeParagraph(*layout, text, baseStyle);
+    }
 
-            line = "";
-            lineCharLength = 0;
-            lineBlankCount = 0;
-            lineBreak = false;
+    // Draw the glyphs of each line and distribute the remaining blank between the words if the line is justified.
+    vec2 terminalSize = ctx->m_TerminalSize;
+    std::u32string_view chars = layout->m_Chars;
+    for (size_t l = 0; l < layout->m_Lines.size(); l++) {
+        const ParagraphLayout::Line& line = layout->m_Lines[l];
+        if (l > 0) {
+            frame->m_Cursor.x = 0;
+            frame->m_Cursor.y++;
         }
 
-        //Add a space between words.
-        if (lineCharLength > 0) {
-            line += " ";
-            lineCharLength++;
-            lineBlankCount++;
+        size_t gaps = (line.m_Last - line.m_First) - 1;
+        size_t extra = (line.m_Justified && gaps > 0 && line.m_Width < width) ? width - line.m_Width : 0;
+
+        for (size_t w = line.m_First; w < line.m_Last; w++) {
+            const ParagraphLayout::Word& word = layout->m_Words[w];
+            for (size_t g = word.m_FirstGlyph; g < word.m_LastGlyph; g++) {
+                const ParagraphLayout::Glyph& glyph = layout->m_Glyphs[g];
+                frame->DrawCluster(chars.substr(glyph.m_Offset, glyph.m_Length), glyph.m_Style, terminalSize);
+            }
+
+            if (w + 1 == line.m_Last)
+                break;
+
+            // Spread the extra spaces evenly between the gaps.
+            size_t gap = w - line.m_First;
+            size_t spaces = 1;
+            if (extra > 0)
+                spaces += (gap + 1) * extra / gaps - gap * extra / gaps;
+            for (size_t k = 0; k < std::min<size_t>(spaces, width); k++)
+                frame->DrawCluster(U" ", word.m_EndStyle, terminalSize);
+        }
+        item->m_Size.x = std::max(item->m_Size.x, (int) (line.m_Justified ? std::max<size_t>(line.m_Width, width) : line.m_Width));
+    }
+    item->m_Size.y = layout->m_Lines.size();
+
+    // Add an empty line if the text ends with a line break.
+    bool lineBreak = !layout->m_Words.empty() && layout->m_Words.back().m_LineBreak;
+
+    tuim::SetCurrentCellStyle(CellStyle());
+    for(int i = 0; i < 1 + lineBreak; i++) {
+        frame->m_Cursor.x = 0;
+        frame->m_Cursor.y++;
+    }
+}
+
+inline std::vector<tuim::ParagraphLayout::Word> tuim::TokenizeParagraph(std::string_view text) {
+    std::vector<ParagraphLayout::Word> words;
+
+    size_t i = 0;
+    while (i < text.length()) {
+        // Find the end of the next word (until end of text, space or line break).
+        size_t end = i;
+        while (end < text.length() && text[end] != ' ' && text[end] != '\n')
+            end++;
+
+        bool lineBreak = (end < text.length() && text[end] == '\n');
+
+        // Consecutive spaces do not make empty words, but line breaks are kept on the previous word.
+        if (end > i) {
+            size_t width = tuim::CalcTextMetrics(text.substr(i, end - i)).m_Width;
+            words.push_back(ParagraphLayout::Word{ i, end - i, width, lineBreak, 0, 0, CellStyle() });
+        }
+        else if (lineBreak && !words.empty()) {
+            words.back().m_LineBreak = true;
+        }
+
+        i = end + 1;
+    }
+
+    return words;
+}
+
+inline void tuim::ShapeParagraph(ParagraphLayout& layout, std::string_view text, const CellStyle& style) {
+    layout.m_BaseStyle = style;
+    layout.m_Chars.clear();
+    layout.m_Glyphs.clear();
+
+    // The formatting tags between two words apply to the next one, as they would be printed.
+    static thread_local std::u32string s_Chars;
+    CellStyle currentStyle = style;
+    size_t previousEnd = 0;
+    for (ParagraphLayout::Word& word : layout.m_Words) {
+        s_Chars.clear();
+        tuim::Utf8DecodeString(text.substr(previousEnd, word.m_Offset + word.m_Length - previousEnd), s_Chars, nullptr);
+        previousEnd = word.m_Offset + word.m_Length;
+
+        word.m_FirstGlyph = layout.m_Glyphs.size();
+        bool escaped = false;
+        for (size_t i = 0; i < s_Chars.size();) {
+            char32_t c = s_Chars[i];
+            char32_t cc = (i+1 < s_Chars.size()) ? s_Chars[i+1] : U'\0';
+            if (!escaped && (c == '#' || c == '&')) {
+                if (cc == c) {
+                    escaped = true;
+                    i++;
+                    continue;
+                }
+                size_t tagLength = tuim::ParseFormattingTag(s_Chars, i, currentStyle);
+                if (tagLength > 0) {
+                    i += tagLength;
+                    continue;
+                }
+            }
+            escaped = false;
+
+            // The spaces and line breaks before the word are only separators.
+            if (c == ' ' || c == '\n') {
+                i++;
+                continue;
+            }
+
+            // A tab is drawn as 4 spaces, like Print does.
+            uint32_t offset = layout.m_Chars.size();
+            size_t clusterLength = (c == '\t') ? 1 : tuim::GraphemeLength(s_Chars, i);
+            if (c == '\t') {
+                layout.m_Chars.append(U" ");
+                for (int k = 0; k < 4; k++)
+                    layout.m_Glyphs.push_back(ParagraphLayout::Glyph{ offset, 1, currentStyle });
+            }
+            else {
+                layout.m_Chars.append(std::u32string_view(s_Chars).substr(i, clusterLength));
+                layout.m_Glyphs.push_back(ParagraphLayout::Glyph{ offset, (uint32_t) clusterLength, currentStyle });
+            }
+            i += clusterLength;
+        }
+        word.m_LastGlyph = layout.m_Glyphs.size();
+        word.m_EndStyle = currentStyle;
+    }
+}
+
+inline void tuim::BreakParagraph(ParagraphLayout& layout) {
+    const std::vector<ParagraphLayout::Word>& words = layout.m_Words;
+    const size_t width = layout.m_Width;
+    layout.m_Lines.clear();
+
+    auto AddLine = [&](size_t first, size_t last, size_t lineWidth) {
+        // Lines ending with an explicit line break and the last line are not justified.
+        bool justified = (last < words.size() && !words[last-1].m_LineBreak);
+        layout.m_Lines.push_back(ParagraphLayout::Line{ first, last, lineWidth, justified });
+    };
+
+    // Greedy fit: fill each line with as many words as possible.
+    if (!(layout.m_Flags & PARAGRAPH_FLAGS_OPTIMAL_FIT)) {
+        size_t first = 0;
+        size_t lineWidth = 0;
+        for (size_t w = 0; w < words.size(); w++) {
+            if (w > first && lineWidth + 1 + words[w].m_Width > width) {
+                AddLine(first, w, lineWidth);
+                first = w;
+                lineWidth = 0;
+            }
+            lineWidth += (w > first ? 1 : 0) + words[w].m_Width;
+            if (words[w].m_LineBreak) {
+                AddLine(first, w + 1, lineWidth);
+                first = w + 1;
+                lineWidth = 0;
+            }
+        }
+        if (first < words.size())
+            AddLine(first, words.size(), lineWidth);
+        return;
+    }
+
+    // Optimal fit (Knuth-Plass): minimize the sum of the squared blank left at the end of each line,
+    // the last line of each block (before a line break or at the end) being free.
+    // cost[i] is the minimum cost of laying out the words from i to the end of their block.
+    const size_t n = words.size();
+    std::vector<uint64_t> cost(n + 1, 0);
+    std::vector<size_t> next(n + 1, n);
+
+    for (size_t i = n; i-- > 0;) {
+        cost[i] = UINT64_MAX;
+        size_t lineWidth = 0;
+        for (size_t j = i; j < n; j++) {
+            lineWidth += (j > i ? 1 : 0) + words[j].m_Width;
+
+            // A line can overflow only if it is made of a single word.
+            if (lineWidth > width && j > i)
+                break;
+
+            bool endOfBlock = (j + 1 == n || words[j].m_LineBreak);
+            uint64_t blank = (lineWidth < width) ? width - lineWidth : 0;
+            uint64_t lineCost = endOfBlock ? 0 : blank * blank;
+            uint64_t total = lineCost + (endOfBlock ? 0 : cost[j + 1]);
+
+            if (total < cost[i]) {
+                cost[i] = total;
+                next[i] = j + 1;
+            }
+            if (endOfBlock)
+                break;
+        }
+    }
+
+    for (size_t first = 0; first < n;) {
+        size_t last = next[first];
+        size_t lineWidth = 0;
+        for (size_t w = first; w < last; w++)
+            lineWidth += (w > first ? 1 : 0) + words[w].m_Width;
+        AddLine(first, last, lineWidth);
+        first = last;
+    }
+}
+
+/***********************************************************
+*                         TABLE                            *
+***********************************************************/
+
+template <typename Func> inline void tuim::ParallelFor(size_t count, Func&& func) {
+    // The first index runs on the calling thread.
+    std::vector<std::thread> threads;
+    threads.reserve(count > 0 ? count - 1 : 0);
+    for (size_t i = 1; i < count; i++)
+        threads.emplace_back([&func, i]() { func(i); });
+    if (count > 0)
+        func(0);
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+inline tuim::TableData::~TableData() {
+    Cancel();
+}
+
+inline size_t tuim::TableData::AddColumn(std::string_view header, int width, TableColumnFlags flags) {
+    Cancel();
+    TableColumn column;
+    column.m_Header = header;
+    column.m_Width = width;
+    column.m_Flags = flags;
+    column.m_Cells.resize(m_RowCount);
+    column.m_CellWidths.resize(m_RowCount, 0);
+    column.m_MaxWidth = tuim::CalcPlainTextWidth(header);
+    m_Columns.push_back(std::move(column));
+    return m_Columns.size() - 1;
+}
+
+inline void tuim::TableData::AddRow(const std::vector<std::string>& cells) {
+    // The background job reads the columns, so the row is only stored once its result is swapped in.
+    // Cancelling the job instead would discard every sort when rows are added each frame.
+    if (m_Worker.joinable()) {
+        m_Appended.push_back(cells);
+        return;
+    }
+    StoreRow(cells);
+}
+
+inline void tuim::TableData::StoreRow(const std::vector<std::string>& cells) {
+    uint32_t row = m_RowCount++;
+    for (size_t i = 0; i < m_Columns.size(); i++) {
+        TableColumn& column = m_Columns[i];
+        column.m_Cells.push_back(i < cells.size() ? cells[i] : std::string());
+        uint32_t width = tuim::CalcPlainTextWidth(column.m_Cells.back());
+        column.m_CellWidths.push_back(width);
+        column.m_MaxWidth = std::max<size_t>(column.m_MaxWidth, width);
+    }
+
+    if (!MatchesFilter(row, m_Filter))
+        return;
+    if (m_SortColumn < 0 || m_SortColumn >= (int) m_Columns.size()) {
+        m_Rows.push_back(row);
+        return;
+    }
+
+    // Insert the row at its sorted position, after the equal cells to keep the insertion order.
+    const TableColumn& column = m_Columns[m_SortColumn];
+    bool numeric = (column.m_Flags & TABLE_COLUMN_FLAGS_NUMERIC);
+    double key = numeric ? ParseNumericCell(column.m_Cells[row]) : 0;
+    auto it = std::upper_bound(m_Rows.begin(), m_Rows.end(), row, [&](uint32_t a, uint32_t b) {
+        if (!m_SortAscending) std::swap(a, b);
+        if (numeric)
+            return (a == row ? key : ParseNumericCell(column.m_Cells[a])) < (b == row ? key : ParseNumericCell(column.m_Cells[b]));
+        return column.m_Cells[a] < column.m_Cells[b];
+    });
+    m_Rows.insert(it, row);
+}
+
+inline void tuim::TableData::StoreAppendedRows() {
+    for (const std::vector<std::string>& cells : m_Appended)
+        StoreRow(cells);
+    m_Appended.clear();
+}
+
+inline void tuim::TableData::Clear() {
+    Cancel();
+    for (TableColumn& column : m_Columns) {
+        column.m_Cells.clear();
+        column.m_CellWidths.clear();
+        column.m_MaxWidth = tuim::CalcPlainTextWidth(column.m_Header);
+    }
+    m_RowCount = 0;
+    m_Rows.clear();
+    m_Appended.clear();
+    m_Stale = false;
+}
+
+inline void tuim::TableData::Sort(int column, bool ascending) {
+    m_SortColumn = column;
+    m_SortAscending = ascending;
+    Start();
+}
+
+inline void tuim::TableData::Filter(std::string_view query) {
+    m_Filter = query;
+    Start();
+}
+
+inline bool tuim::TableData::Poll() {
+    std::optional<std::vector<uint32_t>> rows;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        rows.swap(m_Pending);
+    }
+    if (rows.has_value()) {
+        if (m_Worker.joinable())
+            m_Worker.join();
+        m_Rows = std::move(*rows);
+        StoreAppendedRows();
+        return true;
+    }
+
+    // Rows have been added since the last job, sort them again.
+    if (m_Stale && !m_Worker.joinable())
+        Start();
+    return false;
+}
+
+inline void tuim::TableData::Wait() {
+    if (m_Worker.joinable())
+        m_Worker.join();
+}
+
+inline bool tuim::TableData::IsBusy() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Worker.joinable() || m_Pending.has_value();
+}
+
+inline void tuim::TableData::Start() {
+    Cancel();
+    m_Stale = false;
+
+    uint64_t generation = ++m_Generation;
+    m_Worker = std::thread([this, generation, sortColumn = m_SortColumn, ascending = m_SortAscending, query = m_Filter]() {
+        std::vector<uint32_t> rows = ComputeRows(generation, sortColumn, ascending, query);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Generation == generation)
+            m_Pending = std::move(rows);
+    });
+}
+
+inline void tuim::TableData::Cancel() {
+    // The job checks the generation regularly and stops as soon as it changes.
+    bool discarded = m_Worker.joinable();
+    if (discarded) {
+        m_Generation++;
+        m_Worker.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_Pending.has_value()) {
+        m_Pending.reset();
+        discarded = true;
+    }
+    if (discarded)
+        m_Stale = true;
+    StoreAppendedRows();
+}
+
+inline bool tuim::TableData::MatchesFilter(uint32_t row, std::string_view query) const {
+    if (query.empty())
+        return true;
+    for (const TableColumn& column : m_Columns) {
+        if (column.m_Cells[row].find(query) != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+inline double tuim::TableData::ParseNumericCell(const std::string& cell) {
+    // Cells that are not numbers are sorted before all the others.
+    double key = std::numeric_limits<double>::lowest();
+    std::from_chars(cell.data(), cell.data() + cell.size(), key);
+    return key;
+}
+
+inline std::vector<uint32_t> tuim::TableData::ComputeRows(uint64_t generation, int sortColumn, bool ascending, std::string query) const {
+    const size_t rowCount = m_RowCount;
+    auto IsCancelled = [&]() { return m_Generation.load(std::memory_order_relaxed) != generation; };
+
+    // Split the rows in chunks that are large enough to be worth a thread.
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(rowCount / 16384, std::thread::hardware_concurrency()));
+    auto ChunkBegin = [&](size_t size, size_t chunk) { return size * chunk / threadCount; };
+
+    // Filter each chunk separately and concatenate the results to keep the insertion order.
+    std::vector<std::vector<uint32_t>> chunks(threadCount);
+    tuim::ParallelFor(threadCount, [&](size_t chunk) {
+        for (size_t row = ChunkBegin(rowCount, chunk); row < ChunkBegin(rowCount, chunk + 1); row++) {
+            if (row % 4096 == 0 && IsCancelled())
+                return;
+            if (MatchesFilter(row, query))
+                chunks[chunk].push_back(row);
+        }
+    });
+
+    std::vector<uint32_t> rows;
+    if (IsCancelled())
+        return rows;
+    for (const std::vector<uint32_t>& chunk : chunks)
+        rows.insert(rows.end(), chunk.begin(), chunk.end());
+
+    if (sortColumn < 0 || sortColumn >= (int) m_Columns.size())
+        return rows;
+    const TableColumn& column = m_Columns[sortColumn];
+
+    // Numeric cells are parsed once instead of during each comparison.
+    std::vector<double> keys;
+    bool numeric = (column.m_Flags & TABLE_COLUMN_FLAGS_NUMERIC);
+    if (numeric) {
+        keys.resize(rowCount, std::numeric_limits<double>::lowest());
+        tuim::ParallelFor(threadCount, [&](size_t chunk) {
+            for (size_t i = ChunkBegin(rows.size(), chunk); i < ChunkBegin(rows.size(), chunk + 1); i++)
+                keys[rows[i]] = ParseNumericCell(column.m_Cells[rows[i]]);
+        });
+    }
+
+    // Rows with equal cells keep their insertion order in both directions.
+    auto Compare = [&](uint32_t a, uint32_t b) {
+        if (!ascending) std::swap(a, b);
+        return numeric ? keys[a] < keys[b] : column.m_Cells[a] < column.m_Cells[b];
+    };
+
+    // Sort each chunk and merge them two by two.
+    tuim::ParallelFor(threadCount, [&](size_t chunk) {
+        std::stable_sort(rows.begin() + ChunkBegin(rows.size(), chunk), rows.begin() + ChunkBegin(rows.size(), chunk + 1), Compare);
+    });
+    for (size_t step = 1; step < threadCount && !IsCancelled(); step *= 2) {
+        size_t pairCount = (threadCount - step + 2 * step - 1) / (2 * step);
+        tuim::ParallelFor(pairCount, [&](size_t pair) {
+            size_t first = pair * 2 * step;
+            size_t last = std::min(first + 2 * step, threadCount);
+            std::inplace_merge(
+                rows.begin() + ChunkBegin(rows.size(), first),
+                rows.begin() + ChunkBegin(rows.size(), first + step),
+                rows.begin() + ChunkBegin(rows.size(), last),
+                Compare
+            );
+        });
+    }
+    return rows;
+}
+
+inline bool tuim::Table(const std::string& id, TableData& data, vec2 size, size_t* selected, ContainerFlags flags) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+
+    // Keep the same row selected when the rows computed in the background are swapped in.
+    bool hasSelection = (*selected < data.m_Rows.size());
+    uint32_t selectedRow = hasSelection ? data.m_Rows[*selected] : 0;
+    if (data.Poll() && hasSelection) {
+        auto it = std::find(data.m_Rows.begin(), data.m_Rows.end(), selectedRow);
+        *selected = (it != data.m_Rows.end()) ? it - data.m_Rows.begin() : 0;
+    }
+
+    // Columns without a fixed width fit their largest cell, which is known since the rows were added.
+    std::vector<int> widths(data.m_Columns.size());
+    for (size_t i = 0; i < data.m_Columns.size(); i++) {
+        const TableColumn& column = data.m_Columns[i];
+        widths[i] = (column.m_Width > 0) ? column.m_Width : column.m_MaxWidth;
+    }
+
+    // Draw the headers above the list, aligned with its content.
+    int border = (flags & CONTAINER_FLAGS_BORDERLESS) ? 0 : 1;
+    vec2 start = frame->m_Cursor;
+    CellStyle headerStyle;
+    headerStyle.m_Style = Style::BOLD;
+    int x = start.x + border;
+    for (size_t i = 0; i < data.m_Columns.size(); i++) {
+        frame->m_Cursor = vec2(x, start.y);
+        tuim::DrawText(data.m_Columns[i].m_Header, headerStyle, widths[i]);
+        x += widths[i] + 1;
+    }
+    frame->m_Cursor = vec2(start.x, start.y + 1);
+
+    int rowWidth = size.x - 2 * border;
+    return tuim::ScrollList(id, vec2(size.x, size.y - 1), selected, data.m_Rows.size(), [&](size_t index, bool highlighted) {
+        uint32_t row = data.m_Rows[index];
+        int y = tuim::GetCurrentCursor().y;
+
+        CellStyle style;
+        if (highlighted) {
+            style.m_Style = Style::REVERSE;
+            tuim::FillRect(vec2(0, y), vec2(rowWidth, 1), U' ', style);
+        }
+
+        // The cached widths are used to align numbers to the right without measuring them again.
+        int x = 0;
+        for (size_t i = 0; i < data.m_Columns.size(); i++) {
+            const TableColumn& column = data.m_Columns[i];
+            int cellWidth = column.m_CellWidths[row];
+            int padding = ((column.m_Flags & TABLE_COLUMN_FLAGS_NUMERIC) && cellWidth < widths[i]) ? widths[i] - cellWidth : 0;
+            tuim::SetCurrentCursor(vec2(x + padding, y));
+            tuim::DrawText(column.m_Cells[row], style, widths[i] - padding);
+            x += widths[i] + 1;
+        }
+    }, flags);
+}
+
+/***********************************************************
+*                        LOG VIEW                          *
+***********************************************************/
+
+inline tuim::LogFile::~LogFile() {
+    Close();
+}
+
+inline bool tuim::LogFile::Open(const std::string& path) {
+    Close();
+
+    m_Fd = ::open(path.c_str(), O_RDONLY);
+    if (m_Fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(m_Fd, &st) != 0 || !Map(st.st_size)) {
+        Close();
+        return false;
+    }
+
+    // Mapping the file is instant, its lines become available while they are indexed.
+    m_LineStarts.assign(1, 0);
+    m_Indexed = 0;
+    m_LineCount = 0;
+    m_Resets++;
+    StartIndexing(0);
+    return true;
+}
+
+inline void tuim::LogFile::Close() {
+    StopIndexing();
+    Map(0);
+    if (m_Fd >= 0)
+        ::close(m_Fd);
+    m_Fd = -1;
+    m_LineStarts.clear();
+    m_Indexed = 0;
+    m_LineCount = 0;
+    m_Resets++;
+}
+
+inline bool tuim::LogFile::Poll() {
+    if (m_Fd < 0)
+        return false;
+
+    // Check for appended data once the current data is indexed and searched, the mapping cannot change before.
+    if (!m_Indexing && m_Readers == 0) {
+        StopIndexing();
+
+        struct stat st;
+        if (fstat(m_Fd, &st) == 0 && (size_t) st.st_size != m_Size) {
+            // The file has been truncated (e.g. rotated), index it again from the start.
+            size_t begin = m_Indexed;
+            if ((size_t) st.st_size < m_Size) {
+                m_LineStarts.assign(1, 0);
+                m_Indexed = 0;
+                m_Resets++;
+                begin = 0;
+            }
+            if (Map(st.st_size))
+                StartIndexing(begin);
+            else {
+                m_LineStarts.assign(1, 0);
+                m_Indexed = 0;
+                m_Resets++;
+            }
+        }
+    }
+
+    size_t lineCount = m_LineCount;
+    m_LineCount = GetLineCount();
+    return lineCount != m_LineCount;
+}
+
+inline size_t tuim::LogFile::GetLineCount() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (m_LineStarts.empty())
+        return 0;
+
+    // The last line is only complete once all the data has been indexed.
+    size_t count = m_LineStarts.size() - 1;
+    if (!m_Indexing && m_Indexed > m_LineStarts.back())
+        count++;
+    return count;
+}
+
+inline size_t tuim::LogFile::GetCompleteLineCount() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_LineStarts.empty() ? 0 : m_LineStarts.size() - 1;
+}
+
+inline size_t tuim::LogFile::GetIndexedSize() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Indexed;
+}
+
+inline std::string_view tuim::LogFile::GetLine(size_t index) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (index >= m_LineStarts.size())
+        return std::string_view();
+
+    size_t start = m_LineStarts[index];
+    size_t end = (index + 1 < m_LineStarts.size()) ? m_LineStarts[index + 1] - 1 : m_Indexed;
+    if (end > start && m_Data[end - 1] == '\r')
+        end--;
+    return std::string_view(m_Data + start, end - start);
+}
+
+inline void tuim::LogFile::GetLineBounds(size_t first, size_t last, std::vector<uint64_t>& bounds) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    bounds.clear();
+    last = std::min(last, m_LineStarts.size());
+    if (first >= last)
+        return;
+    bounds.insert(bounds.end(), m_LineStarts.begin() + first, m_LineStarts.begin() + last);
+    bounds.push_back(last < m_LineStarts.size() ? m_LineStarts[last] - 1 : m_Indexed);
+}
+
+inline bool tuim::LogFile::Map(size_t size) {
+    if (m_Data != nullptr)
+        munmap(const_cast<char*>(m_Data), m_Size);
+    m_Data = nullptr;
+    m_Size = 0;
+
+    // Empty files cannot be mapped, but there is nothing to read anyway.
+    if (size == 0 || m_Fd < 0)
+        return true;
+
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, m_Fd, 0);
+    if (data == MAP_FAILED)
+        return false;
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    m_Data = static_cast<const char*>(data);
+    m_Size = size;
+    return true;
+}
+
+inline void tuim::LogFile::StartIndexing(size_t begin) {
+    m_Stop = false;
+    m_Indexing = true;
+    m_Worker = std::thread([this, begin, end = m_Size]() {
+        // Publish the offsets by chunks so that the first lines can be displayed right away.
+        constexpr size_t CHUNK_SIZE = 1 << 22;
+        std::vector<uint64_t> starts;
+        for (size_t chunk = begin; chunk < end && !m_Stop; chunk += CHUNK_SIZE) {
+            size_t chunkEnd = std::min(end, chunk + CHUNK_SIZE);
+            starts.clear();
+            tuim::IndexNewlines(m_Data, chunk, chunkEnd, starts);
+
+            // The last line is counted as soon as the end of the data is published.
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_LineStarts.insert(m_LineStarts.end(), starts.begin(), starts.end());
+            m_Indexed = chunkEnd;
+            if (chunkEnd == end)
+                m_Indexing = false;
+        }
+        m_Indexing = false;
+    });
+}
+
+inline void tuim::LogFile::StopIndexing() {
+    m_Stop = true;
+    if (m_Worker.joinable())
+        m_Worker.join();
+    m_Indexing = false;
+}
+
+inline void tuim::IndexNewlines(const char* data, size_t begin, size_t end, std::vector<uint64_t>& starts) {
+    size_t i = begin;
+
+    // Compare 16 bytes at once and only visit the line breaks found.
+    #ifdef __SSE2__
+    const __m128i newline = _mm_set1_epi8('\n');
+    for (; i + 16 <= end; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newline));
+        while (mask != 0) {
+            starts.push_back(i + __builtin_ctz(mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+    #endif
+
+    // memchr is vectorized by the C library for the remaining bytes.
+    while (i < end) {
+        const char* found = static_cast<const char*>(std::memchr(data + i, '\n', end - i));
+        if (found == nullptr)
+            break;
+        i = found - data + 1;
+        starts.push_back(i);
+    }
+}
+
+inline bool tuim::LogView(const std::string& id, LogFile& log, vec2 size, size_t* selected, LogViewFlags flags, TextSearch* search) {
+    // Follow the end of the file if the last line was selected before the new lines were indexed.
+    bool atEnd = (log.m_LineCount == 0 || *selected + 1 >= log.m_LineCount);
+    if (log.Poll() && (flags & LOG_VIEW_FLAGS_FOLLOW) && atEnd)
+        *selected = std::max<size_t>(1, log.m_LineCount) - 1;
+
+    ContainerFlags containerFlags = (flags & LOG_VIEW_FLAGS_BORDERLESS) ? CONTAINER_FLAGS_BORDERLESS : CONTAINER_FLAGS_NONE;
+    int width = std::max(0, size.x - ((flags & LOG_VIEW_FLAGS_BORDERLESS) ? 0 : 2));
+    return tuim::ScrollList(id, size, selected, log.m_LineCount, [&](size_t index, bool highlighted) {
+        std::string_view line = log.GetLine(index);
+        CellStyle style;
+        if (highlighted)
+            style.m_Style = Style::REVERSE;
+
+        // Formatting tags take no column, so markup lines are only cut to a generous number of bytes
+        // (at a character boundary), which is enough to keep very long lines from being decoded.
+        if (flags & LOG_VIEW_FLAGS_MARKUP) {
+            size_t cut = std::min(line.size(), (size_t) width * 16);
+            while (cut > 0 && cut < line.size() && (line[cut] & UTF8_CONT_MASK) == UTF8_CONT_TAG)
+                cut--;
+            tuim::SetCurrentCellStyle(style);
+            tuim::PrintUnformatted(line.substr(0, cut));
+            return;
+        }
+
+        // Only the start of the line that fits in the list is decoded and drawn.
+        line = line.substr(0, tuim::Utf8FitWidth(line, width));
+
+        // Draw the text between the matches normally, and the matches highlighted.
+        // Matches are not highlighted with markup since their offsets refer to the raw text.
+        static thread_local std::vector<TextMatch> s_Matches;
+        s_Matches.clear();
+        if (search != nullptr)
+            search->GetLineMatches(index, s_Matches);
+
+        CellStyle matchStyle = style;
+        matchStyle.m_Foreground = Color(0, 0, 0);
+        matchStyle.m_Background = Color(0xFF, 0xD7, 0x00, true);
+
+        size_t offset = 0;
+        for (const TextMatch& match : s_Matches) {
+            size_t begin = std::min(match.m_Offset, line.size());
+            size_t end = std::min(match.m_Offset + match.m_Length, line.size());
+            tuim::DrawText(line.substr(offset, begin - offset), style, width - tuim::GetCurrentCursor().x);
+            tuim::DrawText(line.substr(begin, end - begin), matchStyle, width - tuim::GetCurrentCursor().x);
+            offset = end;
+        }
+        tuim::DrawText(line.substr(offset), style, width - tuim::GetCurrentCursor().x);
+    }, containerFlags);
+}
+
+/***********************************************************
+*                      TEXT SEARCH                         *
+***********************************************************/
+
+inline tuim::TextSearch::~TextSearch() {
+    Stop();
+}
+
+inline bool tuim::TextSearch::Search(LogFile& log, std::string_view query, TextSearchFlags flags) {
+    if (&log != m_Log || query != m_Query || flags != m_Flags) {
+        Cancel();
+        m_Log = &log;
+        m_LogResets = log.m_Resets;
+        m_Query = query;
+        m_Flags = flags;
+        m_Valid = true;
+        m_Regex.reset();
+        if (m_Query.empty())
+            return true;
+
+        if (flags & TEXT_SEARCH_FLAGS_REGEX) {
+            try {
+                auto syntax = std::regex::ECMAScript | std::regex::optimize;
+                if (flags & TEXT_SEARCH_FLAGS_IGNORE_CASE)
+                    syntax |= std::regex::icase;
+                m_Regex.emplace(m_Query, syntax);
+            }
+            catch (const std::regex_error&) {
+                m_Valid = false;
+                return false;
+            }
+        }
+
+        Start(0);
+        return true;
+    }
+
+    // The lines of a truncated file are indexed again, so the matches refer to lines that no longer exist.
+    if (log.m_Resets != m_LogResets) {
+        Cancel();
+        m_LogResets = log.m_Resets;
+        if (m_Valid && !m_Query.empty())
+            Start(0);
+        return m_Valid;
+    }
+
+    // Search the data that has been indexed since the last search, from the first line that was not complete.
+    if (m_Valid && !m_Query.empty() && !m_Searching && m_SearchedSize != log.GetIndexedSize()) {
+        Stop();
+        Start(m_SearchedLines);
+    }
+    return m_Valid;
+}
+
+inline void tuim::TextSearch::Cancel() {
+    Stop();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Matches.clear();
+    m_SearchedLines = 0;
+    m_SearchedSize = 0;
+}
+
+inline size_t tuim::TextSearch::GetMatchCount() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Matches.size();
+}
+
+inline tuim::TextMatch tuim::TextSearch::GetMatch(size_t index) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Matches.at(index);
+}
+
+inline size_t tuim::TextSearch::FindMatch(size_t line) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = std::lower_bound(m_Matches.begin(), m_Matches.end(), line, [](const TextMatch& match, size_t line) {
+        return match.m_Line < line;
+    });
+    return it - m_Matches.begin();
+}
+
+inline void tuim::TextSearch::GetLineMatches(size_t line, std::vector<TextMatch>& matches) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = std::lower_bound(m_Matches.begin(), m_Matches.end(), line, [](const TextMatch& match, size_t line) {
+        return match.m_Line < line;
+    });
+    for (; it != m_Matches.end() && it->m_Line == line; it++)
+        matches.push_back(*it);
+}
+
+inline void tuim::TextSearch::Start(size_t firstLine) {
+    // The file cannot be remapped while it is read by the search.
+    m_Log->m_Readers++;
+    m_Searching = true;
+
+    uint64_t generation = ++m_Generation;
+    m_Worker = std::thread([this, generation, firstLine]() {
+        // Small chunks let the first matches be displayed during the next frame.
+        constexpr size_t CHUNK_LINES = 4096;
+        // The size is read first, so the data indexed meanwhile is searched by the next call.
+        size_t indexedSize = m_Log->GetIndexedSize();
+        size_t lineCount = m_Log->GetLineCount();
+        size_t completeLines = m_Log->GetCompleteLineCount();
+        std::vector<uint64_t> bounds;
+        std::vector<TextMatch> matches;
+
+        for (size_t line = firstLine; line < lineCount && m_Generation == generation; line += CHUNK_LINES) {
+            size_t last = std::min(lineCount, line + CHUNK_LINES);
+            m_Log->GetLineBounds(line, last, bounds);
+            matches.clear();
+            SearchLines(bounds, line, matches);
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Generation != generation)
+                break;
+
+            // The first line may have been searched before it was complete, its previous matches are replaced.
+            if (line == firstLine) {
+                auto it = std::lower_bound(m_Matches.begin(), m_Matches.end(), firstLine, [](const TextMatch& match, size_t line) {
+                    return match.m_Line < line;
+                });
+                m_Matches.erase(it, m_Matches.end());
+            }
+            m_Matches.insert(m_Matches.end(), matches.begin(), matches.end());
+
+            // A line without its line break is searched again once more data is indexed.
+            m_SearchedLines = std::min(last, completeLines);
+        }
+        if (m_Generation == generation)
+            m_SearchedSize = indexedSize;
+
+        m_Log->m_Readers--;
+        m_Searching = false;
+    });
+}
+
+inline void tuim::TextSearch::Stop() {
+    m_Generation++;
+    if (m_Worker.joinable())
+        m_Worker.join();
+}
+
+inline void tuim::TextSearch::SearchLines(const std::vector<uint64_t>& bounds, size_t firstLine, std::vector<TextMatch>& matches) const {
+    if (bounds.size() < 2)
+        return;
+    const char* data = m_Log->m_Data;
+
+    // Regular expressions are matched line by line.
+    if (m_Regex.has_value()) {
+        for (size_t i = 0; i + 1 < bounds.size(); i++) {
+            size_t end = bounds[i + 1] - (i + 2 < bounds.size() ? 1 : 0);
+            const char* begin = data + bounds[i];
+            for (std::cregex_iterator it(begin, data + end, *m_Regex), last; it != last; it++) {
+                if (it->length() > 0)
+                    matches.push_back(TextMatch{ firstLine + i, (size_t) it->position(), (size_t) it->length() });
+            }
+        }
+        return;
+    }
+
+    // Substrings are searched in the whole chunk at once, then the lines of the matches are found by walking the offsets.
+    bool ignoreCase = (m_Flags & TEXT_SEARCH_FLAGS_IGNORE_CASE);
+    std::string_view text(data + bounds.front(), bounds.back() - bounds.front());
+    size_t line = 0;
+    for (size_t pos = tuim::FindSubstring(text, m_Query, 0, ignoreCase); pos != std::string_view::npos; pos = tuim::FindSubstring(text, m_Query, pos + m_Query.size(), ignoreCase)) {
+        size_t offset = bounds.front() + pos;
+        while (line + 2 < bounds.size() && bounds[line + 1] <= offset)
+            line++;
+        matches.push_back(TextMatch{ firstLine + line, offset - bounds[line], m_Query.size() });
+    }
+}
+
+inline size_t tuim::FindSubstring(std::string_view text, std::string_view query, size_t from, bool ignoreCase) {
+    if (query.empty() || text.size() < query.size())
+        return std::string_view::npos;
+
+    auto Fold = [ignoreCase](unsigned char c) -> unsigned char {
+        return (ignoreCase && c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+    };
+    auto MatchesAt = [&](size_t index) {
+        for (size_t j = 0; j < query.size(); j++) {
+            if (Fold(text[index + j]) != Fold(query[j]))
+                return false;
+        }
+        return true;
+    };
+
+    unsigned char first = Fold(query.front());
+    unsigned char last = Fold(query.back());
+    size_t lastIndex = text.size() - query.size();
+    size_t i = from;
+
+    // Only verify the positions where both the first and the last bytes of the query match, 16 at once.
+    // When the case is ignored, letters are compared with their lowercase bit set (false positives are verified).
+    #ifdef __SSE2__
+    const __m128i firstBytes = _mm_set1_epi8(first);
+    const __m128i lastBytes = _mm_set1_epi8(last);
+    const __m128i firstCase = _mm_set1_epi8((ignoreCase && first >= 'a' && first <= 'z') ? 0x20 : 0);
+    const __m128i lastCase = _mm_set1_epi8((ignoreCase && last >= 'a' && last <= 'z') ? 0x20 : 0);
+    for (; i + 16 <= lastIndex + 1; i += 16) {
+        __m128i firstBlock = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i)), firstCase);
+        __m128i lastBlock = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + query.size() - 1)), lastCase);
+        uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, firstBytes), _mm_cmpeq_epi8(lastBlock, lastBytes)));
+        while (mask != 0) {
+            size_t index = i + __builtin_ctz(mask);
+            if (MatchesAt(index))
+                return index;
+            mask &= mask - 1;
+        }
+    }
+    #endif
+
+    for (; i <= lastIndex; i++) {
+        if (Fold(text[i]) == first && MatchesAt(i))
+            return i;
+    }
+    return std::string_view::npos;
+}
+
+/***********************************************************
+*                       GAP BUFFER                         *
+***********************************************************/
+
+inline tuim::GapBuffer::GapBuffer(std::string_view text) : m_GapStart(0), m_GapEnd(0) {
+    SetText(text);
+}
+
+inline void tuim::GapBuffer::SetText(std::string_view text) {
+    m_Data.assign(text.begin(), text.end());
+    m_GapStart = m_Data.size();
+    m_GapEnd = m_Data.size();
+}
+
+inline std::string tuim::GapBuffer::GetText() const {
+    std::string text;
+    GetRange(0, GetSize(), text);
+    return text;
+}
+
+inline bool tuim::GapBuffer::Equals(std::string_view text) const {
+    if (text.size() != GetSize())
+        return false;
+
+    // Compare the parts before and after the gap.
+    size_t after = m_Data.size() - m_GapEnd;
+    return std::memcmp(m_Data.data(), text.data(), m_GapStart) == 0
+        && std::memcmp(m_Data.data() + m_GapEnd, text.data() + m_GapStart, after) == 0;
+}
+
+inline void tuim::GapBuffer::GetRange(size_t offset, size_t length, std::string& out) const {
+    out.clear();
+    offset = std::min(offset, GetSize());
+    length = std::min(length, GetSize() - offset);
+
+    // Copy the parts before and after the gap.
+    size_t end = offset + length;
+    if (offset < m_GapStart)
+        out.append(m_Data.data() + offset, std::min(end, m_GapStart) - offset);
+    if (end > m_GapStart) {
+        size_t from = std::max(offset, m_GapStart);
+        out.append(m_Data.data() + from + (m_GapEnd - m_GapStart), end - from);
+    }
+}
+
+inline size_t tuim::GapBuffer::PrevIndex(size_t index) const {
+    if (index == 0)
+        return 0;
+    do {
+        index--;
+    } while (index > 0 && (static_cast<unsigned char>(At(index)) & UTF8_CONT_MASK) == UTF8_CONT_TAG);
+    return index;
+}
+
+inline size_t tuim::GapBuffer::NextIndex(size_t index) const {
+    const size_t n = GetSize();
+    if (index >= n)
+        return n;
+    do {
+        index++;
+    } while (index < n && (static_cast<unsigned char>(At(index)) & UTF8_CONT_MASK) == UTF8_CONT_TAG);
+    return index;
+}
+
+inline void tuim::GapBuffer::Insert(size_t index, std::string_view text) {
+    MoveGap(std::min(index, GetSize()));
+    Reserve(text.size());
+    std::memcpy(m_Data.data() + m_GapStart, text.data(), text.size());
+    m_GapStart += text.size();
+}
+
+inline void tuim::GapBuffer::Erase(size_t index, size_t length) {
+    index = std::min(index, GetSize());
+    MoveGap(index);
+    m_GapEnd += std::min(length, m_Data.size() - m_GapEnd);
+}
+
+inline void tuim::GapBuffer::MoveGap(size_t index) {
+    if (index < m_GapStart) {
+        size_t count = m_GapStart - index;
+        std::memmove(m_Data.data() + m_GapEnd - count, m_Data.data() + index, count);
+        m_GapStart -= count;
+        m_GapEnd -= count;
+    }
+    else if (index > m_GapStart) {
+        size_t count = index - m_GapStart;
+        std::memmove(m_Data.data() + m_GapStart, m_Data.data() + m_GapEnd, count);
+        m_GapStart += count;
+        m_GapEnd += count;
+    }
+}
+
+inline void tuim::GapBuffer::Reserve(size_t length) {
+    size_t gap = m_GapEnd - m_GapStart;
+    if (gap >= length)
+        return;
+
+    // Grow geometrically so that inserting characters one by one stays amortized O(1).
+    size_t after = m_Data.size() - m_GapEnd;
+    size_t newGap = std::max(length, std::max<size_t>(64, m_Data.size()));
+    m_Data.resize(m_GapStart + newGap + after);
+    std::memmove(m_Data.data() + m_GapStart + newGap, m_Data.data() + m_GapEnd, after);
+    m_GapEnd = m_GapStart + newGap;
+}
+
+/***********************************************************
+*                      TEXT EDITOR                         *
+***********************************************************/
+
+inline tuim::TextBuffer::TextBuffer(std::string_view text) : m_Seed(0x9E3779B9) {
+    SetText(text);
+}
+
+inline void tuim::TextBuffer::SetText(std::string_view text) {
+    m_Original = text;
+    m_OriginalLines.clear();
+    tuim::IndexNewlines(m_Original.data(), 0, m_Original.size(), m_OriginalLines);
+    m_Added.clear();
+    m_AddedLines.clear();
+
+    // The whole text starts as a single piece.
+    m_Root = nullptr;
+    if (!m_Original.empty())
+        m_Root = MakeNode(MakePiece(false, 0, m_Original.size()), NextPriority(), nullptr, nullptr);
+
+    m_UndoStack.clear();
+    m_RedoStack.clear();
+    m_LastEdit = EditKind::NONE;
+    m_LastEditOffset = 0;
+    m_Cursor = 0;
+    m_Anchor = 0;
+    m_PreferredColumn = -1;
+    m_ScrollLine = 0;
+    m_ScrollColumn = 0;
+}
+
+inline bool tuim::TextBuffer::LoadFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    SetText(text);
+    return true;
+}
+
+inline std::string tuim::TextBuffer::GetText() const {
+    std::string text;
+    GetRange(0, GetSize(), text);
+    return text;
+}
+
+inline size_t tuim::TextBuffer::GetSize() const {
+    return m_Root ? m_Root->m_Length : 0;
+}
+
+inline size_t tuim::TextBuffer::GetLineCount() const {
+    return (m_Root ? m_Root->m_Newlines : 0) + 1;
+}
+
+inline size_t tuim::TextBuffer::GetLineStart(size_t line) const {
+    if (line == 0)
+        return 0;
+    if (line >= GetLineCount())
+        return GetSize();
+    return FindNewline(line) + 1;
+}
+
+inline size_t tuim::TextBuffer::GetLineEnd(size_t line) const {
+    if (line + 1 >= GetLineCount())
+        return GetSize();
+    return FindNewline(line + 1);
+}
+
+inline size_t tuim::TextBuffer::GetLineOfOffset(size_t offset) const {
+    // Count the line breaks before the offset.
+    size_t line = 0;
+    const Node* node = m_Root.get();
+    while (node != nullptr) {
+        size_t leftLength = node->m_Left ? node->m_Left->m_Length : 0;
+        if (offset < leftLength) {
+            node = node->m_Left.get();
+            continue;
+        }
+        line += node->m_Left ? node->m_Left->m_Newlines : 0;
+        offset -= leftLength;
+
+        const Piece& piece = node->m_Piece;
+        if (offset < piece.m_Length)
+            return line + MakePiece(piece.m_Added, piece.m_Start, offset).m_Newlines;
+        line += piece.m_Newlines;
+        offset -= piece.m_Length;
+        node = node->m_Right.get();
+    }
+    return line;
+}
+
+inline void tuim::TextBuffer::GetRange(size_t offset, size_t length, std::string& out) const {
+    out.clear();
+    Collect(m_Root, offset, offset + length, 0, out);
+}
+
+inline void tuim::TextBuffer::Insert(size_t offset, std::string_view text) {
+    if (text.empty())
+        return;
+    offset = std::min(offset, GetSize());
+
+    // Consecutive characters typed on the same line are undone at once.
+    bool grouped = (m_LastEdit == EditKind::INSERT && offset == m_LastEditOffset && text.find('\n') == std::string_view::npos);
+    if (!grouped)
+        PushUndo();
+
+    size_t start = m_Added.size();
+    m_Added.append(text);
+    tuim::IndexNewlines(m_Added.data(), start, m_Added.size(), m_AddedLines);
+
+    auto [left, right] = Split(m_Root, offset);
+    NodePtr node = MakeNode(MakePiece(true, start, text.size()), NextPriority(), nullptr, nullptr);
+    m_Root = Merge(Merge(left, node), right);
+
+    m_LastEdit = EditKind::INSERT;
+    m_LastEditOffset = offset + text.size();
+}
+
+inline void tuim::TextBuffer::Erase(size_t offset, size_t length) {
+    offset = std::min(offset, GetSize());
+    length = std::min(length, GetSize() - offset);
+    if (length == 0)
+        return;
+
+    // Consecutive deletions with backspace or delete are undone at once.
+    bool grouped = (m_LastEdit == EditKind::ERASE && (offset + length == m_LastEditOffset || offset == m_LastEditOffset));
+    if (!grouped)
+        PushUndo();
+
+    auto [left, rest] = Split(m_Root, offset);
+    auto [erased, right] = Split(rest, length);
+    m_Root = Merge(left, right);
+
+    m_LastEdit = EditKind::ERASE;
+    m_LastEditOffset = offset;
+}
+
+inline void tuim::TextBuffer::EraseSelection() {
+    if (!HasSelection())
+        return;
+    size_t begin = std::min(m_Cursor, m_Anchor);
+    size_t end = std::max(m_Cursor, m_Anchor);
+    BreakUndoGroup();
+    Erase(begin, end - begin);
+    m_Cursor = begin;
+    m_Anchor = begin;
+}
+
+inline bool tuim::TextBuffer::Undo() {
+    if (m_UndoStack.empty())
+        return false;
+    m_RedoStack.push_back(Snapshot{ m_Root, m_Cursor, m_Anchor });
+    Snapshot snapshot = m_UndoStack.back();
+    m_UndoStack.pop_back();
+
+    m_Root = snapshot.m_Root;
+    m_Cursor = snapshot.m_Cursor;
+    m_Anchor = snapshot.m_Anchor;
+    m_LastEdit = EditKind::NONE;
+    return true;
+}
+
+inline bool tuim::TextBuffer::Redo() {
+    if (m_RedoStack.empty())
+        return false;
+    m_UndoStack.push_back(Snapshot{ m_Root, m_Cursor, m_Anchor });
+    Snapshot snapshot = m_RedoStack.back();
+    m_RedoStack.pop_back();
+
+    m_Root = snapshot.m_Root;
+    m_Cursor = snapshot.m_Cursor;
+    m_Anchor = snapshot.m_Anchor;
+    m_LastEdit = EditKind::NONE;
+    return true;
+}
+
+inline void tuim::TextBuffer::BreakUndoGroup() {
+    m_LastEdit = EditKind::NONE;
+}
+
+inline tuim::TextBuffer::NodePtr tuim::TextBuffer::MakeNode(const Piece& piece, uint32_t priority, NodePtr left, NodePtr right) const {
+    auto node = std::make_shared<Node>();
+    node->m_Piece = piece;
+    node->m_Priority = priority;
+    node->m_Length = piece.m_Length + (left ? left->m_Length : 0) + (right ? right->m_Length : 0);
+    node->m_Newlines = piece.m_Newlines + (left ? left->m_Newlines : 0) + (right ? right->m_Newlines : 0);
+    node->m_Left = std::move(left);
+    node->m_Right = std::move(right);
+    return node;
+}
+
+inline std::pair<tuim::TextBuffer::NodePtr, tuim::TextBuffer::NodePtr> tuim::TextBuffer::Split(const NodePtr& node, size_t offset) {
+    if (!node)
+        return { nullptr, nullptr };
+
+    size_t leftLength = node->m_Left ? node->m_Left->m_Length : 0;
+    const Piece& piece = node->m_Piece;
+    if (offset <= leftLength) {
+        auto [left, right] = Split(node->m_Left, offset);
+        return { left, MakeNode(piece, node->m_Priority, right, node->m_Right) };
+    }
+
+    offset -= leftLength;
+    if (offset >= piece.m_Length) {
+        auto [left, right] = Split(node->m_Right, offset - piece.m_Length);
+        return { MakeNode(piece, node->m_Priority, node->m_Left, left), right };
+    }
+
+    // The offset is inside the piece, which is cut in two.
+    Piece first = MakePiece(piece.m_Added, piece.m_Start, offset);
+    Piece second = MakePiece(piece.m_Added, piece.m_Start + offset, piece.m_Length - offset);
+    NodePtr left = MakeNode(first, node->m_Priority, node->m_Left, nullptr);
+    NodePtr right = Merge(MakeNode(second, NextPriority(), nullptr, nullptr), node->m_Right);
+    return { left, right };
+}
+
+inline tuim::TextBuffer::NodePtr tuim::TextBuffer::Merge(const NodePtr& left, const NodePtr& right) const {
+    if (!left) return right;
+    if (!right) return left;
+    if (left->m_Priority > right->m_Priority)
+        return MakeNode(left->m_Piece, left->m_Priority, left->m_Left, Merge(left->m_Right, right));
+    return MakeNode(right->m_Piece, right->m_Priority, Merge(left, right->m_Left), right->m_Right);
+}
+
+inline tuim::TextBuffer::Piece tuim::TextBuffer::MakePiece(bool added, size_t start, size_t length) const {
+    // The line breaks of the buffers are indexed, so they are counted with binary searches.
+    const std::vector<uint64_t>& lines = (added ? m_AddedLines : m_OriginalLines);
+    auto first = std::lower_bound(lines.begin(), lines.end(), start + 1);
+    auto last = std::lower_bound(first, lines.end(), start + length + 1);
+    return Piece{ added, start, length, (size_t) (last - first) };
+}
+
+inline size_t tuim::TextBuffer::FindNewline(size_t index) const {
+    size_t offset = 0;
+    const Node* node = m_Root.get();
+    while (node != nullptr) {
+        size_t leftNewlines = node->m_Left ? node->m_Left->m_Newlines : 0;
+        if (index <= leftNewlines) {
+            node = node->m_Left.get();
+            continue;
+        }
+        index -= leftNewlines;
+        offset += node->m_Left ? node->m_Left->m_Length : 0;
+
+        const Piece& piece = node->m_Piece;
+        if (index <= piece.m_Newlines) {
+            const std::vector<uint64_t>& lines = (piece.m_Added ? m_AddedLines : m_OriginalLines);
+            auto first = std::lower_bound(lines.begin(), lines.end(), piece.m_Start + 1);
+            return offset + *(first + index - 1) - 1 - piece.m_Start;
+        }
+        index -= piece.m_Newlines;
+        offset += piece.m_Length;
+        node = node->m_Right.get();
+    }
+    return offset;
+}
+
+inline void tuim::TextBuffer::Collect(const NodePtr& node, size_t begin, size_t end, size_t base, std::string& out) const {
+    // Only visit the subtrees that overlap the range.
+    if (!node || begin >= base + node->m_Length || end <= base)
+        return;
+
+    size_t leftLength = node->m_Left ? node->m_Left->m_Length : 0;
+    Collect(node->m_Left, begin, end, base, out);
+
+    const Piece& piece = node->m_Piece;
+    size_t pieceBase = base + leftLength;
+    size_t from = std::max(begin, pieceBase);
+    size_t to = std::min(end, pieceBase + piece.m_Length);
+    if (from < to) {
+        const std::string& buffer = (piece.m_Added ? m_Added : m_Original);
+        out.append(buffer, piece.m_Start + from - pieceBase, to - from);
+    }
+
+    Collect(node->m_Right, begin, end, pieceBase + piece.m_Length, out);
+}
+
+inline void tuim::TextBuffer::PushUndo() {
+    m_UndoStack.push_back(Snapshot{ m_Root, m_Cursor, m_Anchor });
+    m_RedoStack.clear();
+}
+
+inline uint32_t tuim::TextBuffer::NextPriority() {
+    // xorshift32
+    m_Seed ^= m_Seed << 13;
+    m_Seed ^= m_Seed >> 17;
+    m_Seed ^= m_Seed << 5;
+    return m_Seed;
+}
+
+inline bool tuim::EditText(TextBuffer& buffer, char32_t keyCode, size_t pageLines) {
+    static thread_local std::string s_Line;
+
+    size_t line = buffer.GetLineOfOffset(buffer.m_Cursor);
+    size_t lineStart = buffer.GetLineStart(line);
+    size_t lineEnd = buffer.GetLineEnd(line);
+    buffer.GetRange(lineStart, lineEnd - lineStart, s_Line);
+    size_t column = buffer.m_Cursor - lineStart;
+
+    // Moving the cursor removes the selection and starts a new undo step.
+    auto MoveTo = [&](size_t offset) {
+        buffer.m_Cursor = offset;
+        buffer.m_Anchor = offset;
+        buffer.m_PreferredColumn = -1;
+        buffer.BreakUndoGroup();
+    };
+
+    // Keep the same column on lines of different widths.
+    auto MoveToLine = [&](size_t target) {
+        int preferredColumn = buffer.m_PreferredColumn;
+        if (preferredColumn < 0)
+            preferredColumn = tuim::CalcPlainTextWidth(std::string_view(s_Line).substr(0, column));
+
+        size_t start = buffer.GetLineStart(target);
+        buffer.GetRange(start, buffer.GetLineEnd(target) - start, s_Line);
+        size_t index = 0;
+        int width = 0;
+        while (index < s_Line.size()) {
+            size_t length = tuim::Utf8GraphemeLength(s_Line, index);
+            width += tuim::CalcPlainTextWidth(std::string_view(s_Line).substr(index, length));
+            if (width > preferredColumn)
+                break;
+            index += length;
+        }
+        MoveTo(start + index);
+        buffer.m_PreferredColumn = preferredColumn;
+    };
+
+    // Returns the start of the grapheme cluster before an index of the line.
+    auto PreviousCluster = [&](size_t index) {
+        size_t previous = 0;
+        for (size_t i = 0; i < index; i += tuim::Utf8GraphemeLength(s_Line, i))
+            previous = i;
+        return previous;
+    };
+
+    auto InsertText = [&](std::string_view text) {
+        buffer.EraseSelection();
+        buffer.Insert(buffer.m_Cursor, text);
+        buffer.m_Cursor += text.size();
+        buffer.m_Anchor = buffer.m_Cursor;
+        buffer.m_PreferredColumn = -1;
+    };
+
+    if (keyCode == Key::LEFT) {
+        if (buffer.HasSelection()) MoveTo(std::min(buffer.m_Cursor, buffer.m_Anchor));
+        else if (column > 0) MoveTo(lineStart + PreviousCluster(column));
+        else if (buffer.m_Cursor > 0) MoveTo(buffer.m_Cursor - 1);
+    }
+    else if (keyCode == Key::RIGHT) {
+        if (buffer.HasSelection()) MoveTo(std::max(buffer.m_Cursor, buffer.m_Anchor));
+        else if (column < s_Line.size()) MoveTo(buffer.m_Cursor + tuim::Utf8GraphemeLength(s_Line, column));
+        else if (buffer.m_Cursor < buffer.GetSize()) MoveTo(buffer.m_Cursor + 1);
+    }
+    else if (keyCode == Key::UP) {
+        if (line > 0) MoveToLine(line - 1);
+    }
+    else if (keyCode == Key::DOWN) {
+        if (line + 1 < buffer.GetLineCount()) MoveToLine(line + 1);
+    }
+    else if (keyCode == Key::PAGE_UP) {
+        MoveToLine(line > pageLines ? line - pageLines : 0);
+    }
+    else if (keyCode == Key::PAGE_DOWN) {
+        MoveToLine(std::min(buffer.GetLineCount() - 1, line + pageLines));
+    }
+    else if (keyCode == Key::HOME) {
+        MoveTo(lineStart);
+    }
+    else if (keyCode == Key::END) {
+        MoveTo(lineEnd);
+    }
+    else if (keyCode == Key::CTRL_A) {
+        buffer.m_Anchor = 0;
+        buffer.m_Cursor = buffer.GetSize();
+    }
+    else if (keyCode == Key::CTRL_Z) {
+        return buffer.Undo();
+    }
+    else if (keyCode == Key::CTRL_Y) {
+        return buffer.Redo();
+    }
+    else if (keyCode == Key::BACKSPACE) {
+        if (buffer.HasSelection()) {
+            buffer.EraseSelection();
+            return true;
+        }
+        if (buffer.m_Cursor == 0)
+            return false;
+        size_t previous = (column > 0) ? lineStart + PreviousCluster(column) : buffer.m_Cursor - 1;
+        buffer.Erase(previous, buffer.m_Cursor - previous);
+        buffer.m_Cursor = previous;
+        buffer.m_Anchor = previous;
+        buffer.m_PreferredColumn = -1;
+        return true;
+    }
+    else if (keyCode == Key::DELETE) {
+        if (buffer.HasSelection()) {
+            buffer.EraseSelection();
+            return true;
+        }
+        if (buffer.m_Cursor >= buffer.GetSize())
+            return false;
+        size_t length = (column < s_Line.size()) ? tuim::Utf8GraphemeLength(s_Line, column) : 1;
+        buffer.Erase(buffer.m_Cursor, length);
+        return true;
+    }
+    else if (keyCode == Key::ENTER) {
+        InsertText("\n");
+        return true;
+    }
+    else if (keyCode == Key::PASTE) {
+        // Terminals send the line breaks of a paste as carriage returns, the text is a single undo step.
+        std::string_view paste = tuim::GetPastedText();
+        std::string text;
+        text.reserve(paste.size());
+        for (size_t i = 0; i < paste.size(); i++) {
+            if (paste[i] != '\r') text.push_back(paste[i]);
+            else if (i + 1 >= paste.size() || paste[i + 1] != '\n') text.push_back('\n');
+        }
+        if (text.empty())
+            return false;
+        buffer.BreakUndoGroup();
+        InsertText(text);
+        return true;
+    }
+    else if (keyCode != 0 && tuim::IsPrintable(keyCode)) {
+        InsertText(tuim::Utf8Char32ToString(keyCode));
+        return true;
+    }
+    return false;
+}
+
+inline bool tuim::TextEditor(const std::string& id, TextBuffer& buffer, vec2 size, ContainerFlags flags) {
+    Context* ctx = tuim::GetCtx();
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+
+    // Create a new item and push it to the stack.
+    ItemId itemId = tuim::StringToId(id);
+    std::shared_ptr<Item> item = std::make_shared<Item>();
+    item->m_Id = itemId;
+    item->m_Pos = frame->m_Cursor;
+    item->m_Size = size;
+    item->m_Flags = ITEM_FLAGS_STAY_ACTIVE;
+    tuim::AddItem(item);
+
+    int border = (flags & CONTAINER_FLAGS_BORDERLESS) ? 0 : 1;
+    int width = std::max(1, size.x - 2 * border);
+    int height = std::max(1, size.y - 2 * border);
+    bool hasChanged = false;
+
+    // Handle keyboard inputs to change text, move cursor...
+    if (tuim::IsItemActive()) {
+        if (tuim::IsKeyPressed(Key::ESCAPE))
+            tuim::SetActiveItemId(0);
+        else
+            hasChanged = tuim::EditText(buffer, ctx->m_PressedKeyCode, height);
+    }
+    else if (tuim::IsItemHovered() && tuim::IsKeyPressed(Key::ENTER)) {
+        tuim::SetActiveItemId(item->m_Id);
+    }
+    bool active = tuim::IsItemActive();
+
+    // Ctrl+Z and Ctrl+Y undo and redo instead of suspending the program while the editor has the focus.
+    if (active)
+        tuim::CaptureSignalKeys();
+
+    // Scroll just enough to keep the cursor visible.
+    static thread_local std::string s_Line;
+    buffer.m_Cursor = std::min(buffer.m_Cursor, buffer.GetSize());
+    buffer.m_Anchor = std::min(buffer.m_Anchor, buffer.GetSize());
+    size_t cursorLine = buffer.GetLineOfOffset(buffer.m_Cursor);
+    size_t cursorLineStart = buffer.GetLineStart(cursorLine);
+    buffer.GetRange(cursorLineStart, buffer.m_Cursor - cursorLineStart, s_Line);
+    int cursorColumn = tuim::CalcPlainTextWidth(s_Line);
+
+    if (cursorLine < buffer.m_ScrollLine)
+        buffer.m_ScrollLine = cursorLine;
+    else if (cursorLine >= buffer.m_ScrollLine + height)
+        buffer.m_ScrollLine = cursorLine - height + 1;
+    if (cursorColumn < buffer.m_ScrollColumn)
+        buffer.m_ScrollColumn = cursorColumn;
+    else if (cursorColumn >= buffer.m_ScrollColumn + width)
+        buffer.m_ScrollColumn = cursorColumn - width + 1;
+
+    if (tuim::BeginContainer(id + "-container", "", size, flags)) {
+        const CellStyle textStyle;
+        const CellStyle selectionStyle = { std::nullopt, std::nullopt, Style::REVERSE };
+        const CellStyle cursorStyle = { Color(0x55, 0x55, 0x55), Color(0xff, 0xff, 0xff, true), Style::NONE };
+        size_t selectionBegin = std::min(buffer.m_Cursor, buffer.m_Anchor);
+        size_t selectionEnd = std::max(buffer.m_Cursor, buffer.m_Anchor);
+
+        // Only the visible lines are extracted from the buffer, the columns before the scroll position are clipped.
+        size_t lineCount = buffer.GetLineCount();
+        for (int y = 0; y < height && buffer.m_ScrollLine + y < lineCount; y++) {
+            size_t line = buffer.m_ScrollLine + y;
+            size_t lineStart = buffer.GetLineStart(line);
+            size_t lineEnd = buffer.GetLineEnd(line);
+            buffer.GetRange(lineStart, lineEnd - lineStart, s_Line);
+            std::string_view text = s_Line;
+
+            size_t begin = std::clamp(selectionBegin, lineStart, lineEnd) - lineStart;
+            size_t end = std::clamp(selectionEnd, lineStart, lineEnd) - lineStart;
+            tuim::SetCurrentCursor(vec2(-buffer.m_ScrollColumn, y));
+            tuim::DrawText(text.substr(0, begin), textStyle);
+            tuim::DrawText(text.substr(begin, end - begin), selectionStyle);
+            tuim::DrawText(text.substr(end), textStyle);
+
+            // Show the selected line breaks as a space.
+            if (selectionBegin <= lineEnd && lineEnd < selectionEnd)
+                tuim::DrawGlyph(U' ', selectionStyle);
+
+            if (active && line == cursorLine) {
+                size_t cursor = buffer.m_Cursor - lineStart;
+                tuim::SetCurrentCursor(vec2(cursorColumn - buffer.m_ScrollColumn, y));
+                if (cursor < text.size()) tuim::DrawText(text.substr(cursor, tuim::Utf8GraphemeLength(text, cursor)), cursorStyle);
+                else tuim::DrawGlyph(U' ', cursorStyle); // Add cursor if it is at the end the line.
+            }
+        }
+    }
+    tuim::EndContainer();
+
+    return hasChanged;
+}
+
+/***********************************************************
+*                        TREE VIEW                         *
+***********************************************************/
+
+inline tuim::TreeData::TreeData(Provider provider) : m_Provider(std::move(provider)), m_Working(false), m_Stop(false) {
+    Node root = {};
+    root.m_Item.m_Id = 0;
+    root.m_Item.m_HasChildren = true;
+    root.m_Expanded = true;
+    m_Nodes.push_back(root);
+    Load(0);
+}
+
+inline tuim::TreeData::~TreeData() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    if (m_Worker.joinable())
+        m_Worker.join();
+}
+
+inline void tuim::TreeData::Expand(size_t row) {
+    if (row >= m_Rows.size())
+        return;
+    uint32_t index = m_Rows[row];
+    Node& node = m_Nodes[index];
+    if (!node.m_Item.m_HasChildren || node.m_Expanded)
+        return;
+
+    node.m_Expanded = true;
+    if (node.m_Loaded) InsertRows(row + 1, index);
+    else if (!node.m_Loading) Load(index);
+}
+
+inline void tuim::TreeData::Collapse(size_t row) {
+    if (row >= m_Rows.size())
+        return;
+    Node& node = m_Nodes[m_Rows[row]];
+    if (!node.m_Expanded)
+        return;
+    node.m_Expanded = false;
+
+    // The descendants are the rows that follow with a greater depth.
+    size_t end = row + 1;
+    while (end < m_Rows.size() && m_Nodes[m_Rows[end]].m_Depth > node.m_Depth)
+        end++;
+    m_Rows.erase(m_Rows.begin() + row + 1, m_Rows.begin() + end);
+}
+
+inline void tuim::TreeData::Toggle(size_t row) {
+    if (row >= m_Rows.size())
+        return;
+    if (m_Nodes[m_Rows[row]].m_Expanded) Collapse(row);
+    else Expand(row);
+}
+
+inline bool tuim::TreeData::Poll() {
+    std::vector<std::pair<uint32_t, std::vector<Node>>> results;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        results.swap(m_Results);
+    }
+
+    bool hasChanged = false;
+    for (auto& [index, children] : results) {
+        // The children are appended to the nodes, so that the indices of the other nodes stay valid.
+        uint32_t first = m_Nodes.size();
+        std::move(children.begin(), children.end(), std::back_inserter(m_Nodes));
+
+        Node& node = m_Nodes[index];
+        node.m_FirstChild = first;
+        node.m_ChildCount = children.size();
+        node.m_Loaded = true;
+        node.m_Loading = false;
+
+        // The node may have been collapsed, or one of its parents, while its children were loaded.
+        if (!node.m_Expanded)
+            continue;
+        size_t row = (index == 0) ? 0 : GetRow(index);
+        if (index != 0 && row == m_Rows.size())
+            continue;
+        InsertRows(index == 0 ? 0 : row + 1, index);
+        hasChanged = true;
+    }
+    return hasChanged;
+}
+
+inline void tuim::TreeData::Wait() {
+    if (m_Worker.joinable())
+        m_Worker.join();
+}
+
+inline bool tuim::TreeData::IsLoading() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Working || !m_Results.empty();
+}
+
+inline size_t tuim::TreeData::GetRow(uint32_t node) const {
+    auto it = std::find(m_Rows.begin(), m_Rows.end(), node);
+    return it - m_Rows.begin();
+}
+
+inline void tuim::TreeData::Load(uint32_t node) {
+    m_Nodes[node].m_Loading = true;
+
+    // A single worker loads the requests one after the other, it stops when there are none left.
+    bool start = false;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Requests.push_back({ node, m_Nodes[node].m_Item.m_Id, m_Nodes[node].m_Depth });
+        start = !m_Working;
+        m_Working = true;
+    }
+    if (start) {
+        if (m_Worker.joinable())
+            m_Worker.join();
+        m_Worker = std::thread([this]() { Work(); });
+    }
+}
+
+inline void tuim::TreeData::Work() {
+    size_t next = 0;
+    while (true) {
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (m_Stop || next == m_Requests.size()) {
+                m_Requests.clear();
+                m_Working = false;
+                return;
+            }
+            request = m_Requests[next++];
+        }
+
+        std::vector<TreeItem> items;
+        m_Provider(request.m_Id, items);
+
+        // The nodes are built here, so that Poll only has to move them.
+        std::vector<Node> children(items.size());
+        for (size_t i = 0; i < items.size(); i++) {
+            children[i].m_Item = std::move(items[i]);
+            children[i].m_Parent = request.m_Node;
+            children[i].m_Depth = request.m_Depth + 1;
+        }
+
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Results.emplace_back(request.m_Node, std::move(children));
+    }
+}
+
+inline void tuim::TreeData::InsertRows(size_t position, uint32_t node) {
+    // Collect the visible descendants in display order, then insert them with a single move of the following rows.
+    std::vector<uint32_t> rows;
+    std::vector<uint32_t> stack;
+    auto PushChildren = [&](uint32_t index) {
+        const Node& parent = m_Nodes[index];
+        for (uint32_t i = parent.m_ChildCount; i > 0; i--)
+            stack.push_back(parent.m_FirstChild + i - 1);
+    };
+
+    PushChildren(node);
+    while (!stack.empty()) {
+        uint32_t index = stack.back();
+        stack.pop_back();
+        rows.push_back(index);
+        if (m_Nodes[index].m_Expanded && m_Nodes[index].m_Loaded)
+            PushChildren(index);
+    }
+    m_Rows.insert(m_Rows.begin() + position, rows.begin(), rows.end());
+}
+
+inline bool tuim::Tree(const std::string& id, TreeData& data, vec2 size, size_t* selected, ContainerFlags flags) {
+    Context* ctx = tuim::GetCtx();
+
+    // Keep the same node selected when rows are inserted above it.
+    bool hasSelection = (*selected < data.m_Rows.size());
+    uint32_t selectedNode = hasSelection ? data.m_Rows[*selected] : 0;
+    if (data.Poll() && hasSelection) {
+        size_t row = data.GetRow(selectedNode);
+        *selected = (row < data.m_Rows.size()) ? row : 0;
+    }
+
+    // Expand and collapse the selected node while the tree is hovered.
+    bool hasChanged = false;
+    if (ctx->m_HoveredItemId == tuim::StringToId(id) && *selected < data.m_Rows.size()) {
+        const TreeData::Node& node = data.GetNode(*selected);
+        if (tuim::IsKeyPressed(Key::RIGHT)) {
+            // Move to the first child if the node is already expanded.
+            if (node.m_Expanded && *selected + 1 < data.m_Rows.size() && data.GetNode(*selected + 1).m_Depth > node.m_Depth) {
+                (*selected)++;
+                hasChanged = true;
+            }
+            else data.Expand(*selected);
+        }
+        else if (tuim::IsKeyPressed(Key::LEFT)) {
+            // Move to the parent if the node is already collapsed.
+            if (node.m_Expanded) data.Collapse(*selected);
+            else if (node.m_Parent != 0) {
+                *selected = data.GetRow(node.m_Parent);
+                hasChanged = true;
+            }
+        }
+        else if (tuim::IsKeyPressed(Key::ENTER)) {
+            data.Toggle(*selected);
+        }
+    }
+
+    int border = (flags & CONTAINER_FLAGS_BORDERLESS) ? 0 : 1;
+    int rowWidth = size.x - 2 * border;
+    hasChanged |= tuim::ScrollList(id, size, selected, data.m_Rows.size(), [&](size_t index, bool highlighted) {
+        const TreeData::Node& node = data.GetNode(index);
+        int y = tuim::GetCurrentCursor().y;
+
+        CellStyle style;
+        if (highlighted) {
+            style.m_Style = Style::REVERSE;
+            tuim::FillRect(vec2(0, y), vec2(rowWidth, 1), U' ', style);
+        }
+
+        int indent = 2 * (node.m_Depth - 1);
+        tuim::SetCurrentCursor(vec2(indent, y));
+        if (node.m_Loading) tuim::DrawGlyph(U'…', style);
+        else if (!node.m_Item.m_HasChildren) tuim::DrawGlyph(U' ', style);
+        else tuim::DrawGlyph(node.m_Expanded ? U'▾' : U'▸', style);
+        tuim::DrawGlyph(U' ', style);
+        tuim::DrawText(node.m_Item.m_Label, style, std::max(0, rowWidth - indent - 2));
+    }, flags);
+
+    // LEFT/RIGHT collapse and expand the nodes, they must not move the focus.
+    auto it = ctx->m_Items.find(tuim::StringToId(id));
+    if (it != ctx->m_Items.end())
+        it->second->m_Flags |= ITEM_FLAGS_USE_LEFT_RIGHT;
+    return hasChanged;
+}
+
+/***********************************************************
+*                      FUZZY FILTER                        *
+***********************************************************/
+
+inline tuim::FuzzyFilter::~FuzzyFilter() {
+    Cancel();
+}
+
+inline void tuim::FuzzyFilter::SetEntries(const std::vector<std::string>& entries) {
+    Cancel();
+    m_Text.clear();
+    m_Offsets.assign(1, 0);
+    m_Masks.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); i++) {
+        m_Text += entries[i];
+        m_Offsets.push_back(m_Text.size());
+        m_Masks[i] = tuim::FuzzyMask(entries[i]);
+    }
+
+    // Score all the entries again.
+    m_MatchedQuery.clear();
+    m_Matches.clear();
+    Filter(m_Query);
+}
+
+inline void tuim::FuzzyFilter::Filter(std::string_view query) {
+    Cancel();
+    m_Query = query;
+    std::string lowered(query);
+    for (char& c : lowered)
+        c = std::tolower(static_cast<unsigned char>(c));
+
+    // The matches of a shorter query contain all the matches of this one.
+    std::optional<std::vector<uint32_t>> candidates;
+    bool refine = (!m_MatchedQuery.empty() && lowered.size() > m_MatchedQuery.size() && lowered.starts_with(m_MatchedQuery));
+    if (refine) {
+        candidates.emplace(m_Matches.size());
+        for (size_t i = 0; i < m_Matches.size(); i++)
+            (*candidates)[i] = m_Matches[i].m_Index;
+    }
+
+    uint64_t generation = ++m_Generation;
+    m_Worker = std::thread([this, generation, lowered, candidates = std::move(candidates)]() {
+        std::vector<FuzzyMatch> matches = ComputeMatches(generation, lowered, candidates ? &*candidates : nullptr);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Generation == generation)
+            m_Pending.emplace(lowered, std::move(matches));
+    });
+}
+
+inline bool tuim::FuzzyFilter::Poll() {
+    std::optional<std::pair<std::string, std::vector<FuzzyMatch>>> result;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        result.swap(m_Pending);
+    }
+    if (!result.has_value())
+        return false;
+
+    if (m_Worker.joinable())
+        m_Worker.join();
+    m_MatchedQuery = std::move(result->first);
+    m_Matches = std::move(result->second);
+    return true;
+}
+
+inline void tuim::FuzzyFilter::Wait() {
+    if (m_Worker.joinable())
+        m_Worker.join();
+}
+
+inline bool tuim::FuzzyFilter::IsBusy() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Worker.joinable() || m_Pending.has_value();
+}
+
+inline void tuim::FuzzyFilter::Cancel() {
+    // The job checks the generation regularly and stops as soon as it changes.
+    if (m_Worker.joinable()) {
+        m_Generation++;
+        m_Worker.join();
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Pending.reset();
+}
+
+inline std::vector<tuim::FuzzyMatch> tuim::FuzzyFilter::ComputeMatches(uint64_t generation, const std::string& query, const std::vector<uint32_t>* candidates) const {
+    const uint64_t queryMask = tuim::FuzzyMask(query);
+    auto IsCancelled = [&]() { return m_Generation.load(std::memory_order_relaxed) != generation; };
+
+    // The previous matches are sorted by score, they are put back in the order of the entries.
+    std::vector<uint32_t> indices;
+    if (candidates != nullptr) {
+        std::vector<bool> isCandidate(GetEntryCount());
+        for (uint32_t index : *candidates)
+            isCandidate[index] = true;
+        indices.reserve(candidates->size());
+        for (uint32_t index = 0; index < GetEntryCount(); index++) {
+            if (isCandidate[index])
+                indices.push_back(index);
+        }
+    }
+    const size_t count = candidates ? indices.size() : GetEntryCount();
+
+    // Split the entries in chunks that are large enough to be worth a thread.
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(count / 16384, std::thread::hardware_concurrency()));
+    auto ChunkBegin = [&](size_t size, size_t chunk) { return size * chunk / threadCount; };
+
+    auto Compare = [](const FuzzyMatch& a, const FuzzyMatch& b) {
+        return a.m_Score != b.m_Score ? a.m_Score > b.m_Score : a.m_Index < b.m_Index;
+    };
+
+    // Score and sort each chunk separately, most entries are rejected by their mask without being scanned.
+    std::vector<std::vector<FuzzyMatch>> chunks(threadCount);
+    tuim::ParallelFor(threadCount, [&](size_t chunk) {
+        std::vector<FuzzyMatch>& matches = chunks[chunk];
+        for (size_t i = ChunkBegin(count, chunk); i < ChunkBegin(count, chunk + 1); i++) {
+            if (i % 4096 == 0 && IsCancelled())
+                return;
+            uint32_t index = candidates ? indices[i] : i;
+            if ((m_Masks[index] & queryMask) != queryMask)
+                continue;
+            int score = tuim::FuzzyScore(GetEntry(index), query);
+            if (score >= 0)
+                matches.push_back({ index, score });
+        }
+        tuim::SortFuzzyMatches(matches);
+    });
+
+    std::vector<FuzzyMatch> matches;
+    if (IsCancelled())
+        return matches;
+
+    // Merge the sorted chunks two by two.
+    std::vector<size_t> bounds = { 0 };
+    for (const std::vector<FuzzyMatch>& chunk : chunks) {
+        matches.insert(matches.end(), chunk.begin(), chunk.end());
+        bounds.push_back(matches.size());
+    }
+    for (size_t step = 1; step < threadCount && !IsCancelled(); step *= 2) {
+        size_t pairCount = (threadCount - step + 2 * step - 1) / (2 * step);
+        tuim::ParallelFor(pairCount, [&](size_t pair) {
+            size_t first = pair * 2 * step;
+            size_t last = std::min(first + 2 * step, threadCount);
+            std::inplace_merge(matches.begin() + bounds[first], matches.begin() + bounds[first + step], matches.begin() + bounds[last], Compare);
+        });
+    }
+    return matches;
+}
+
+inline void tuim::SortFuzzyMatches(std::vector<FuzzyMatch>& matches) {
+    if (matches.empty())
+        return;
+
+    // Scores only spread over a small range, so the matches are counted by score instead of being compared.
+    auto [minIt, maxIt] = std::minmax_element(matches.begin(), matches.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) { return a.m_Score < b.m_Score; });
+    int minScore = minIt->m_Score;
+    size_t range = maxIt->m_Score - minScore + 1;
+    if (range > matches.size() + 1024) {
+        std::stable_sort(matches.begin(), matches.end(), [](const FuzzyMatch& a, const FuzzyMatch& b) { return a.m_Score > b.m_Score; });
+        return;
+    }
+
+    std::vector<size_t> offsets(range + 1, 0);
+    for (const FuzzyMatch& match : matches)
+        offsets[range - (match.m_Score - minScore)]++;
+    for (size_t i = 1; i <= range; i++)
+        offsets[i] += offsets[i-1];
+
+    std::vector<FuzzyMatch> sorted(matches.size());
+    for (const FuzzyMatch& match : matches)
+        sorted[offsets[range - 1 - (match.m_Score - minScore)]++] = match;
+    matches = std::move(sorted);
+}
+
+inline uint64_t tuim::FuzzyMask(std::string_view text) {
+    uint64_t mask = 0;
+    for (unsigned char c : text) {
+        c = (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+        if (c >= 'a' && c <= 'z') mask |= 1ull << (c - 'a');
+        else if (c >= '0' && c <= '9') mask |= 1ull << (26 + c - '0');
+        else mask |= 1ull << (36 + c % 28);
+    }
+    return mask;
+}
+
+inline int tuim::FuzzyScore(std::string_view text, std::string_view query, std::vector<size_t>* positions) {
+    if (positions != nullptr)
+        positions->clear();
+    if (query.empty())
+        return 0;
+
+    auto IsUpper = [](unsigned char c) { return c >= 'A' && c <= 'Z'; };
+    auto IsLower = [](unsigned char c) { return c >= 'a' && c <= 'z'; };
+    auto IsAlphaNumeric = [&](unsigned char c) { return IsUpper(c) || IsLower(c) || (c >= '0' && c <= '9'); };
+
+    // Match each character of the query with its first occurrence after the previous one.
+    int score = 0;
+    int streak = 0;
+    size_t last = std::string_view::npos;
+    size_t q = 0;
+    for (size_t i = 0; i < text.size() && q < query.size(); i++) {
+        unsigned char c = text[i];
+        if ((IsUpper(c) ? c + ('a' - 'A') : c) != static_cast<unsigned char>(query[q]))
+            continue;
+
+        // Consecutive characters and characters starting a word are worth more.
+        score += 16;
+        streak = (last != std::string_view::npos && last + 1 == i) ? streak + 1 : 0;
+        score += 8 * streak;
+        unsigned char previous = (i > 0) ? text[i-1] : ' ';
+        if (!IsAlphaNumeric(previous) || (IsUpper(c) && IsLower(previous)))
+            score += 12;
+        if (last != std::string_view::npos)
+            score -= std::min<int>(i - last - 1, 8);
+
+        if (positions != nullptr)
+            positions->push_back(i);
+        last = i;
+        q++;
+    }
+    if (q < query.size())
+        return -1;
+
+    // Shorter entries are preferred between otherwise equal matches.
+    return std::max(0, score * 4 - std::min<int>(text.size() - query.size(), 64) / 8);
+}
+
+inline bool tuim::FuzzyPicker(const std::string& id, FuzzyFilter& filter, vec2 size, size_t* selected, ContainerFlags flags) {
+    Context* ctx = tuim::GetCtx();
+    std::string queryId = id + "-query";
+    bool inputActive = (ctx->m_ActiveItemId == tuim::StringToId(queryId));
+
+    // The query input keeps the keyboard while it is active, so the list is navigated from there.
+    ScrollState* state = tuim::FindState<ScrollState>(tuim::StringToId(id));
+    if (inputActive && state != nullptr)
+        tuim::ScrollNavigate(*state, ctx->m_PressedKeyCode);
+
+    std::string query = filter.m_Query;
+    tuim::TextInput(queryId, "> {}", &query, INPUT_TEXT_FLAGS_NONE, size.x - 4);
+    tuim::Print("\n");
+    if (query != filter.m_Query)
+        filter.Filter(query);
+
+    // Leaving the input with enter, or pressing enter on the list, picks the selected entry.
+    bool hasPicked = tuim::IsKeyPressed(Key::ENTER) && filter.GetMatchCount() > 0
+        && ((inputActive && ctx->m_ActiveItemId == 0) || ctx->m_HoveredItemId == tuim::StringToId(id));
+
+    // The best match is selected when new matches are swapped in.
+    if (filter.Poll())
+        *selected = 0;
+
+    int border = (flags & CONTAINER_FLAGS_BORDERLESS) ? 0 : 1;
+    int rowWidth = size.x - 2 * border;
+    tuim::ScrollList(id, vec2(size.x, size.y - 1), selected, filter.GetMatchCount(), [&](size_t index, bool highlighted) {
+        std::string_view entry = filter.GetMatch(index);
+        int y = tuim::GetCurrentCursor().y;
+
+        CellStyle style;
+        if (highlighted) {
+            style.m_Style = Style::REVERSE;
+            tuim::FillRect(vec2(0, y), vec2(rowWidth, 1), U' ', style);
+        }
+
+        // The matched characters are only located for the visible rows.
+        static thread_local std::vector<size_t> s_Positions;
+        tuim::FuzzyScore(entry, filter.m_MatchedQuery, &s_Positions);
+        CellStyle matchStyle = style;
+        matchStyle.m_Style = highlighted ? Style::REVERSE : Style::BOLD;
+        matchStyle.m_Foreground = Color(0xFF, 0xD7, 0x00);
+
+        size_t start = 0;
+        for (size_t position : s_Positions) {
+            if (static_cast<unsigned char>(entry[position]) >= 0x80)
+                continue;
+            tuim::DrawText(entry.substr(start, position - start), style, std::max(0, rowWidth - tuim::GetCurrentCursor().x));
+            tuim::DrawText(entry.substr(position, 1), matchStyle, std::max(0, rowWidth - tuim::GetCurrentCursor().x));
+            start = position + 1;
+        }
+        tuim::DrawText(entry.substr(start), style, std::max(0, rowWidth - tuim::GetCurrentCursor().x));
+    }, flags);
+
+    return hasPicked;
+}
+
+/***********************************************************
+*                         CANVAS                           *
+***********************************************************/
+
+inline tuim::CanvasData::CanvasData(vec2 size, CanvasFlags flags) : m_Flags(flags), m_Dirty(true) {
+    Resize(size);
+}
+
+inline void tuim::CanvasData::Resize(vec2 size) {
+    m_Size = vec2(std::max(0, size.x), std::max(0, size.y));
+    m_PixelSize = (m_Flags & CANVAS_FLAGS_HALF_BLOCK) ? vec2(m_Size.x, m_Size.y * 2) : vec2(m_Size.x * 2, m_Size.y * 4);
+    m_Cells.assign(m_Size.x * m_Size.y, 0);
+    m_Colors.assign(m_Size.x * m_Size.y, std::nullopt);
+    m_Dirty = true;
+}
+
+inline void tuim::CanvasData::Clear() {
+    std::fill(m_Cells.begin(), m_Cells.end(), 0);
+    std::fill(m_Colors.begin(), m_Colors.end(), std::nullopt);
+    m_Dirty = true;
+}
+
+inline bool tuim::CanvasData::GetPixel(int x, int y) const {
+    if (x < 0 || y < 0 || x >= m_PixelSize.x || y >= m_PixelSize.y)
+        return false;
+    if (m_Flags & CANVAS_FLAGS_HALF_BLOCK)
+        return m_Cells[(y / 2) * m_Size.x + x] & (1 << (y % 2));
+    return m_Cells[(y / 4) * m_Size.x + x / 2] & BRAILLE_DOTS[y % 4][x % 2];
+}
+
+inline void tuim::CanvasData::SetPixel(int x, int y, bool on) {
+    if (x < 0 || y < 0 || x >= m_PixelSize.x || y >= m_PixelSize.y)
+        return;
+
+    bool halfBlock = (m_Flags & CANVAS_FLAGS_HALF_BLOCK);
+    size_t cell = halfBlock ? (y / 2) * m_Size.x + x : (y / 4) * m_Size.x + x / 2;
+    uint8_t bit = halfBlock ? (1 << (y % 2)) : BRAILLE_DOTS[y % 4][x % 2];
+    if (on) {
+        m_Cells[cell] |= bit;
+        m_Colors[cell] = m_Color;
+    }
+    else m_Cells[cell] &= ~bit;
+    m_Dirty = true;
+}
+
+inline void tuim::CanvasData::DrawLine(vec2 from, vec2 to) {
+    // Bresenham's algorithm, using only integers.
+    int dx = std::abs(to.x - from.x), sx = (from.x < to.x) ? 1 : -1;
+    int dy = -std::abs(to.y - from.y), sy = (from.y < to.y) ? 1 : -1;
+    int error = dx + dy;
+    while (true) {
+        SetPixel(from.x, from.y);
+        if (from.x == to.x && from.y == to.y)
+            break;
+        int error2 = 2 * error;
+        if (error2 >= dy) { error += dy; from.x += sx; }
+        if (error2 <= dx) { error += dx; from.y += sy; }
+    }
+}
+
+inline void tuim::CanvasData::DrawRect(vec2 pos, vec2 size) {
+    if (size.x <= 0 || size.y <= 0)
+        return;
+    vec2 last = vec2(pos.x + size.x - 1, pos.y + size.y - 1);
+    FillSpan(pos.x, last.x, pos.y);
+    FillSpan(pos.x, last.x, last.y);
+    for (int y = pos.y + 1; y < last.y; y++) {
+        SetPixel(pos.x, y);
+        SetPixel(last.x, y);
+    }
+}
+
+inline void tuim::CanvasData::FillRect(vec2 pos, vec2 size) {
+    for (int y = pos.y; y < pos.y + size.y; y++)
+        FillSpan(pos.x, pos.x + size.x - 1, y);
+}
+
+inline void tuim::CanvasData::DrawCircle(vec2 center, int radius) {
+    // Midpoint circle algorithm, each computed point is mirrored in the eight octants.
+    int x = radius, y = 0, error = 1 - radius;
+    while (x >= y) {
+        const vec2 points[] = { vec2(x, y), vec2(y, x), vec2(-y, x), vec2(-x, y), vec2(-x, -y), vec2(-y, -x), vec2(y, -x), vec2(x, -y) };
+        for (const vec2& point : points)
+            SetPixel(center.x + point.x, center.y + point.y);
+        y++;
+        if (error < 0) error += 2 * y + 1;
+        else {
+            x--;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+inline void tuim::CanvasData::FillCircle(vec2 center, int radius) {
+    for (int y = -radius; y <= radius; y++) {
+        int width = static_cast<int>(std::sqrt(static_cast<double>(radius * radius - y * y)));
+        FillSpan(center.x - width, center.x + width, center.y + y);
+    }
+}
+
+inline void tuim::CanvasData::Fill(vec2 pos) {
+    if (pos.x < 0 || pos.y < 0 || pos.x >= m_PixelSize.x || pos.y >= m_PixelSize.y || GetPixel(pos.x, pos.y))
+        return;
+
+    // Fill whole spans of unset pixels, and look for the spans above and below them.
+    std::vector<vec2> stack = { pos };
+    while (!stack.empty()) {
+        vec2 seed = stack.back();
+        stack.pop_back();
+        if (GetPixel(seed.x, seed.y))
+            continue;
+
+        int x0 = seed.x, x1 = seed.x;
+        while (x0 > 0 && !GetPixel(x0 - 1, seed.y)) x0--;
+        while (x1 + 1 < m_PixelSize.x && !GetPixel(x1 + 1, seed.y)) x1++;
+        FillSpan(x0, x1, seed.y);
+
+        for (int y : { seed.y - 1, seed.y + 1 }) {
+            if (y < 0 || y >= m_PixelSize.y)
+                continue;
+            for (int x = x0; x <= x1; x++) {
+                if (!GetPixel(x, y) && (x == x0 || GetPixel(x - 1, y)))
+                    stack.push_back(vec2(x, y));
+            }
+        }
+    }
+}
+
+inline void tuim::CanvasData::FillSpan(int x0, int x1, int y) {
+    x0 = std::max(0, x0);
+    x1 = std::min(m_PixelSize.x - 1, x1);
+    for (int x = x0; x <= x1; x++)
+        SetPixel(x, y);
+}
+
+inline const std::vector<char32_t>& tuim::CanvasData::GetGlyphs() {
+    if (!m_Dirty)
+        return m_Glyphs;
+
+    m_Glyphs.resize(m_Cells.size());
+    if (m_Flags & CANVAS_FLAGS_HALF_BLOCK) {
+        static constexpr char32_t s_HalfBlocks[4] = { 0, U'▀', U'▄', U'█' };
+        for (size_t i = 0; i < m_Cells.size(); i++)
+            m_Glyphs[i] = s_HalfBlocks[m_Cells[i] & 3];
+    }
+    else tuim::ConvertBrailleCells(m_Cells.data(), m_Glyphs.data(), m_Cells.size());
+    m_Dirty = false;
+    return m_Glyphs;
+}
+
+inline void tuim::ConvertBrailleCells(const uint8_t* cells, char32_t* glyphs, size_t count) {
+    size_t i = 0;
+
+    // Widen 16 cells at once and add the first braille character, empty cells stay 0.
+    #ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base = _mm_set1_epi32(0x2800);
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i));
+        __m128i words[2] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+        for (int w = 0; w < 2; w++) {
+            __m128i dwords[2] = { _mm_unpacklo_epi16(words[w], zero), _mm_unpackhi_epi16(words[w], zero) };
+            for (int d = 0; d < 2; d++) {
+                __m128i empty = _mm_cmpeq_epi32(dwords[d], zero);
+                __m128i glyph = _mm_andnot_si128(empty, _mm_add_epi32(dwords[d], base));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(glyphs + i + w * 8 + d * 4), glyph);
+            }
+        }
+    }
+    #endif
+
+    for (; i < count; i++)
+        glyphs[i] = (cells[i] != 0) ? 0x2800 + cells[i] : 0;
+}
+
+inline void tuim::Canvas(CanvasData& canvas) {
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    vec2 terminalSize = tuim::GetCtx()->m_TerminalSize;
+    vec2 start = frame->m_Cursor;
+
+    // Empty cells are skipped, so that the canvas is transparent.
+    const std::vector<char32_t>& glyphs = canvas.GetGlyphs();
+    for (int y = 0; y < canvas.m_Size.y; y++) {
+        for (int x = 0; x < canvas.m_Size.x; x++) {
+            size_t cell = y * canvas.m_Size.x + x;
+            if (glyphs[cell] == 0)
+                continue;
+            frame->m_Cursor = vec2(start.x + x, start.y + y);
+            CellStyle style;
+            style.m_Foreground = canvas.m_Colors[cell];
+            frame->DrawCluster(std::u32string_view(&glyphs[cell], 1), style, terminalSize);
+        }
+    }
+    frame->m_Cursor = vec2(0, start.y + canvas.m_Size.y);
+}
+
+/***********************************************************
+*                         CHARTS                           *
+***********************************************************/
+
+inline tuim::SeriesBuffer::SeriesBuffer(size_t capacity) {
+    m_Samples.resize(std::max<size_t>(1, capacity));
+
+    // Blocks are numbered by their first sample, two more are needed for the partial blocks at both ends.
+    size_t blockCount = m_Samples.size() / SERIES_BLOCK_SIZE + 2;
+    m_BlockMin.resize(blockCount);
+    m_BlockMax.resize(blockCount);
+    Clear();
+}
+
+inline void tuim::SeriesBuffer::Push(float value) {
+    size_t block = (m_PushCount / SERIES_BLOCK_SIZE) % m_BlockMin.size();
+    if (m_PushCount % SERIES_BLOCK_SIZE == 0) {
+        m_BlockMin[block] = std::numeric_limits<float>::infinity();
+        m_BlockMax[block] = -std::numeric_limits<float>::infinity();
+    }
+    if (value == value) {
+        m_BlockMin[block] = std::min(m_BlockMin[block], value);
+        m_BlockMax[block] = std::max(m_BlockMax[block], value);
+    }
+
+    m_Samples[(m_Start + m_Size) % m_Samples.size()] = value;
+    if (m_Size < m_Samples.size()) m_Size++;
+    else m_Start = (m_Start + 1) % m_Samples.size();
+    m_PushCount++;
+}
+
+inline void tuim::SeriesBuffer::Clear() {
+    m_Start = 0;
+    m_Size = 0;
+    m_PushCount = 0;
+}
+
+inline void tuim::SeriesBuffer::GetRange(size_t first, size_t last, float& min, float& max) const {
+    last = std::min(last, m_Size);
+    if (first >= last)
+        return;
+
+    // Samples are read directly up to the first whole block, and after the last one.
+    auto Scan = [&](size_t from, size_t to) {
+        size_t begin = (m_Start + from) % m_Samples.size();
+        size_t count = to - from;
+        size_t contiguous = std::min(count, m_Samples.size() - begin);
+        tuim::FindMinMax(m_Samples.data() + begin, contiguous, min, max);
+        tuim::FindMinMax(m_Samples.data(), count - contiguous, min, max);
+    };
+
+    uint64_t oldest = m_PushCount - m_Size;
+    uint64_t begin = oldest + first, end = oldest + last;
+    uint64_t firstBlock = (begin + SERIES_BLOCK_SIZE - 1) / SERIES_BLOCK_SIZE;
+    uint64_t lastBlock = end / SERIES_BLOCK_SIZE;
+    if (firstBlock >= lastBlock) {
+        Scan(first, last);
+        return;
+    }
+
+    Scan(first, firstBlock * SERIES_BLOCK_SIZE - oldest);
+    for (uint64_t block = firstBlock; block < lastBlock; block++) {
+        min = std::min(min, m_BlockMin[block % m_BlockMin.size()]);
+        max = std::max(max, m_BlockMax[block % m_BlockMax.size()]);
+    }
+    Scan(lastBlock * SERIES_BLOCK_SIZE - oldest, last);
+}
+
+inline void tuim::FindMinMax(const float* data, size_t count, float& min, float& max) {
+    size_t i = 0;
+
+    // Reduce 4 lanes at once, comparisons with NaN keep the previous value.
+    #ifdef __SSE2__
+    if (count >= 8) {
+        __m128 low = _mm_set1_ps(min);
+        __m128 high = _mm_set1_ps(max);
+        for (; i + 4 <= count; i += 4) {
+            __m128 values = _mm_loadu_ps(data + i);
+            low = _mm_min_ps(values, low);
+            high = _mm_max_ps(values, high);
+        }
+        alignas(16) float lows[4], highs[4];
+        _mm_store_ps(lows, low);
+        _mm_store_ps(highs, high);
+        for (int lane = 0; lane < 4; lane++) {
+            min = std::min(min, lows[lane]);
+            max = std::max(max, highs[lane]);
+        }
+    }
+    #endif
+
+    for (; i < count; i++) {
+        if (data[i] < min) min = data[i];
+        if (data[i] > max) max = data[i];
+    }
+}
+
+template <typename Func> inline void tuim::DownsampleLTTB(size_t count, size_t threshold, Func&& at, std::vector<size_t>& indices) {
+    indices.clear();
+    if (threshold >= count || threshold < 3) {
+        for (size_t i = 0; i < count; i++)
+            indices.push_back(i);
+        return;
+    }
+
+    // The first and last samples are kept, the others are split in buckets that each keep one sample:
+    // the one forming the largest triangle with the previously kept sample and the average of the next bucket.
+    double bucketSize = static_cast<double>(count - 2) / (threshold - 2);
+    size_t previous = 0;
+    indices.push_back(0);
+    for (size_t bucket = 0; bucket < threshold - 2; bucket++) {
+        size_t begin = static_cast<size_t>(bucket * bucketSize) + 1;
+        size_t end = static_cast<size_t>((bucket + 1) * bucketSize) + 1;
+        size_t nextBegin = end;
+        size_t nextEnd = std::min(count, static_cast<size_t>((bucket + 2) * bucketSize) + 1);
+
+        double averageX = 0, averageY = 0;
+        for (size_t i = nextBegin; i < nextEnd; i++)
+            averageY += at(i);
+        averageX = (nextBegin + nextEnd - 1) / 2.0;
+        averageY /= std::max<size_t>(1, nextEnd - nextBegin);
+
+        double previousY = at(previous);
+        double largestArea = -1;
+        size_t selected = begin;
+        for (size_t i = begin; i < end; i++) {
+            double area = std::abs((previous - averageX) * (at(i) - previousY) - (previous - static_cast<double>(i)) * (averageY - previousY));
+            if (area > largestArea) {
+                largestArea = area;
+                selected = i;
+            }
+        }
+        indices.push_back(selected);
+        previous = selected;
+    }
+    indices.push_back(count - 1);
+}
+
+template <typename RangeFunc, typename AtFunc> inline void tuim::PlotSeries(CanvasData& canvas, size_t count, ChartFlags flags, RangeFunc&& range, AtFunc&& at) {
+    canvas.Clear();
+    vec2 pixels = canvas.GetPixelSize();
+    if (count == 0 || pixels.x <= 0 || pixels.y <= 0)
+        return;
+
+    float low = std::numeric_limits<float>::infinity();
+    float high = -std::numeric_limits<float>::infinity();
+    range(0, count, low, high);
+    if (low > high)
+        return;
+    if (low == high) {
+        low -= 1;
+        high += 1;
+    }
+    auto ToPixel = [&](float value) {
+        return pixels.y - 1 - static_cast<int>((value - low) / (high - low) * (pixels.y - 1) + 0.5f);
+    };
+
+    if (flags & CHART_FLAGS_LTTB) {
+        static thread_local std::vector<size_t> s_Indices;
+        tuim::DownsampleLTTB(count, pixels.x, at, s_Indices);
+        auto ToColumn = [&](size_t index) { return count > 1 ? static_cast<int>(index * (pixels.x - 1) / (count - 1)) : 0; };
+        for (size_t i = 1; i < s_Indices.size(); i++) {
+            float from = at(s_Indices[i-1]), to = at(s_Indices[i]);
+            if (from == from && to == to)
+                canvas.DrawLine(vec2(ToColumn(s_Indices[i-1]), ToPixel(from)), vec2(ToColumn(s_Indices[i]), ToPixel(to)));
+        }
+        if (s_Indices.size() == 1 && at(0) == at(0))
+            canvas.SetPixel(0, ToPixel(at(0)));
+        return;
+    }
+
+    // Each column joins the previous one, so that steep changes stay connected.
+    int previousTop = -1, previousBottom = -1;
+    int columns = std::min<size_t>(pixels.x, count);
+    for (int x = 0; x < columns; x++) {
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+        range(x * count / columns, (x + 1) * count / columns, min, max);
+        if (min > max) {
+            previousTop = -1;
+            continue;
+        }
+
+        int top = ToPixel(max), bottom = ToPixel(min);
+        if (previousTop >= 0) {
+            top = std::min(top, previousBottom);
+            bottom = std::max(bottom, previousTop);
+        }
+        int column = (columns < pixels.x) ? x * (pixels.x - 1) / std::max(1, columns - 1) : x;
+        for (int y = top; y <= bottom; y++)
+            canvas.SetPixel(column, y);
+        previousTop = ToPixel(max);
+        previousBottom = ToPixel(min);
+    }
+}
+
+inline void tuim::LineChart(const std::string& id, std::span<const float> samples, vec2 size, ChartFlags flags, std::optional<Color> color) {
+    // The canvas is kept between frames so that its buffers are not allocated again.
+    CanvasData& canvas = tuim::GetState<CanvasData>(tuim::StringToId(id));
+    CanvasFlags canvasFlags = (flags & CHART_FLAGS_HALF_BLOCK) ? CANVAS_FLAGS_HALF_BLOCK : CANVAS_FLAGS_NONE;
+    if (canvas.m_Size != size || canvas.m_Flags != canvasFlags) {
+        canvas.m_Flags = canvasFlags;
+        canvas.Resize(size);
+    }
+    canvas.SetColor(color);
+
+    tuim::PlotSeries(canvas, samples.size(), flags,
+        [&](size_t first, size_t last, float& min, float& max) { tuim::FindMinMax(samples.data() + first, last - first, min, max); },
+        [&](size_t index) { return samples[index]; }
+    );
+    tuim::Canvas(canvas);
+}
+
+inline void tuim::LineChart(const std::string& id, const SeriesBuffer& series, vec2 size, ChartFlags flags, std::optional<Color> color) {
+    CanvasData& canvas = tuim::GetState<CanvasData>(tuim::StringToId(id));
+    CanvasFlags canvasFlags = (flags & CHART_FLAGS_HALF_BLOCK) ? CANVAS_FLAGS_HALF_BLOCK : CANVAS_FLAGS_NONE;
+    if (canvas.m_Size != size || canvas.m_Flags != canvasFlags) {
+        canvas.m_Flags = canvasFlags;
+        canvas.Resize(size);
+    }
+    canvas.SetColor(color);
+
+    // The block summaries of the series are used for whole blocks, so most samples are not read.
+    tuim::PlotSeries(canvas, series.GetSize(), flags,
+        [&](size_t first, size_t last, float& min, float& max) { series.GetRange(first, last, min, max); },
+        [&](size_t index) { return series.At(index); }
+    );
+    tuim::Canvas(canvas);
+}
+
+template <typename RangeFunc> inline void tuim::DrawSparkline(size_t count, int width, std::optional<Color> color, RangeFunc&& range) {
+    static constexpr char32_t s_Levels[8] = { U'▁', U'▂', U'▃', U'▄', U'▅', U'▆', U'▇', U'█' };
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    vec2 terminalSize = tuim::GetCtx()->m_TerminalSize;
+    CellStyle style;
+    style.m_Foreground = color;
+
+    float low = std::numeric_limits<float>::infinity();
+    float high = -std::numeric_limits<float>::infinity();
+    range(0, count, low, high);
+
+    int columns = std::min<size_t>(std::max(0, width), count);
+    for (int x = 0; x < columns; x++) {
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+        range(x * count / columns, (x + 1) * count / columns, min, max);
+
+        char32_t glyph = U' ';
+        if (min <= max)
+            glyph = s_Levels[(high > low) ? static_cast<int>((max - low) / (high - low) * 7 + 0.5f) : 0];
+        frame->DrawCluster(std::u32string_view(&glyph, 1), style, terminalSize);
+    }
+}
+
+inline void tuim::Sparkline(std::span<const float> samples, int width, std::optional<Color> color) {
+    tuim::DrawSparkline(samples.size(), width, color, [&](size_t first, size_t last, float& min, float& max) {
+        tuim::FindMinMax(samples.data() + first, last - first, min, max);
+    });
+}
+
+inline void tuim::Sparkline(const SeriesBuffer& series, int width, std::optional<Color> color) {
+    tuim::DrawSparkline(series.GetSize(), width, color, [&](size_t first, size_t last, float& min, float& max) {
+        series.GetRange(first, last, min, max);
+    });
+}
+
+/***********************************************************
+*                         IMAGES                           *
+***********************************************************/
+
+inline void tuim::ImageData::SetLines(const std::vector<std::string>& lines) {
+    Context* ctx = tuim::GetCtx();
+
+    // Print the lines once in a frame of their own, and keep its cells.
+    std::shared_ptr<Frame> offscreen = std::make_shared<Frame>(vec2(0, 0));
+    std::shared_ptr<Frame>& current = ctx->m_ContainersStack.empty() ? ctx->m_Frame : tuim::GetCurrentContainer()->m_Frame;
+    std::swap(current, offscreen);
+    for (const std::string& line : lines)
+        tuim::Print(line + "\n");
+    std::swap(current, offscreen);
+
+    int width = 0;
+    for (const std::vector<std::shared_ptr<Cell>>& row : offscreen->m_Cells)
+        width = std::max<int>(width, row.size());
+    rect area = rect(0, 0, width, lines.size());
+    SetCells(*offscreen, area, area);
+}
+
+inline void tuim::ImageData::SetCells(const Frame& frame, const rect& area, const rect& clip) {
+    Context* ctx = tuim::GetCtx();
+    m_Size = vec2(area.w, area.h);
+    m_Cells.assign(area.w * area.h, nullptr);
+    m_Clusters.clear();
+
+    rect visible = area.Intersect(clip).Intersect(rect(0, 0, std::numeric_limits<int>::max(), frame.m_Cells.size()));
+    for (int y = visible.y; y < visible.y + visible.h; y++) {
+        const std::vector<std::shared_ptr<Cell>>& row = frame.m_Cells[y];
+        for (int x = visible.x; x < visible.x + visible.w && x < (int) row.size(); x++) {
+            size_t index = (y - area.y) * area.w + (x - area.x);
+            m_Cells[index] = row[x];
+            if (row[x] != nullptr && row[x]->m_Cluster != 0)
+                m_Clusters.emplace_back(index, ctx->m_Clusters.Get(row[x]->m_Cluster));
+        }
+    }
+}
+
+inline void tuim::ImageData::SetPixels(const uint8_t* rgb, vec2 pixelSize, vec2 size, ImageFlags flags) {
+    if (pixelSize.x <= 0 || pixelSize.y <= 0) {
+        m_Size = vec2(0, 0);
+        m_Cells.clear();
+        return;
+    }
+
+    // Each cell shows two pixels, so a missing dimension keeps the aspect ratio with twice as many pixel rows.
+    if (size.x <= 0 && size.y <= 0) size = vec2(pixelSize.x, (pixelSize.y + 1) / 2);
+    else if (size.x <= 0) size.x = std::max(1, pixelSize.x * size.y * 2 / pixelSize.y);
+    else if (size.y <= 0) size.y = std::max(1, pixelSize.y * size.x / pixelSize.x / 2);
+
+    std::vector<uint8_t> pixels;
+    tuim::ScaleImage(rgb, pixelSize, pixels, vec2(size.x, size.y * 2));
+
+    // The top pixel is the foreground of an upper half block, the bottom one is its background.
+    m_Size = size;
+    m_Cells.resize(size.x * size.y);
+    m_Clusters.clear();
+    for (int y = 0; y < size.y; y++) {
+        for (int x = 0; x < size.x; x++) {
+            const uint8_t* top = &pixels[((2 * y) * size.x + x) * 3];
+            const uint8_t* bottom = &pixels[((2 * y + 1) * size.x + x) * 3];
+            std::shared_ptr<Cell> cell = std::make_shared<Cell>(U'▀');
+            cell->m_Foreground = tuim::QuantizeColor(Color(top[0], top[1], top[2]), flags);
+            cell->m_Background = tuim::QuantizeColor(Color(bottom[0], bottom[1], bottom[2], true), flags);
+            m_Cells[y * size.x + x] = cell;
+        }
+    }
+}
+
+inline bool tuim::ImageData::LoadPPM(const std::string& path, vec2 size, ImageFlags flags) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    // The header is made of the format, the size and the maximum value, separated by spaces or comments.
+    auto ReadToken = [&]() {
+        std::string token;
+        char c;
+        while (file.get(c)) {
+            if (c == '#') {
+                std::string comment;
+                std::getline(file, comment);
+            }
+            else if (std::isspace(static_cast<unsigned char>(c))) {
+                if (!token.empty())
+                    break;
+            }
+            else token += c;
+        }
+        return token;
+    };
+
+    std::string format = ReadToken();
+    int width = 0, height = 0, maxValue = 0;
+    try {
+        width = std::stoi(ReadToken());
+        height = std::stoi(ReadToken());
+        maxValue = std::stoi(ReadToken());
+    }
+    catch (const std::exception&) {
+        return false;
+    }
+    if ((format != "P6" && format != "P3") || width <= 0 || height <= 0 || maxValue <= 0 || maxValue > 65535)
+        return false;
+
+    size_t count = static_cast<size_t>(width) * height * 3;
+    std::vector<uint8_t> pixels(count);
+    if (format == "P6") {
+        // Values are stored on two bytes (most significant first) when they do not fit in one.
+        size_t sampleSize = (maxValue < 256) ? 1 : 2;
+        std::vector<uint8_t> data(count * sampleSize);
+        if (!file.read(reinterpret_cast<char*>(data.data()), data.size()))
+            return false;
+        for (size_t i = 0; i < count; i++) {
+            int value = (sampleSize == 1) ? data[i] : (data[2*i] << 8 | data[2*i+1]);
+            pixels[i] = value * 255 / maxValue;
+        }
+    }
+    else {
+        for (size_t i = 0; i < count; i++) {
+            int value = 0;
+            if (!(file >> value))
+                return false;
+            pixels[i] = std::clamp(value, 0, maxValue) * 255 / maxValue;
+        }
+    }
+
+    SetPixels(pixels.data(), vec2(width, height), size, flags);
+    return true;
+}
+
+inline void tuim::ScaleImage(const uint8_t* rgb, vec2 size, std::vector<uint8_t>& out, vec2 outSize) {
+    out.assign(outSize.x * outSize.y * 3, 0);
+    if (size.x <= 0 || size.y <= 0 || outSize.x <= 0 || outSize.y <= 0)
+        return;
+
+    // Sum the rows covered by each output row, then the columns covered by each output pixel.
+    size_t rowLength = size.x * 3;
+    std::vector<uint32_t> sums(rowLength);
+    for (int y = 0; y < outSize.y; y++) {
+        int y0 = y * size.y / outSize.y;
+        int y1 = std::max(y0 + 1, (y + 1) * size.y / outSize.y);
+        std::fill(sums.begin(), sums.end(), 0);
+        for (int row = y0; row < y1; row++)
+            tuim::AccumulateRow(rgb + row * rowLength, sums.data(), rowLength);
+
+        for (int x = 0; x < outSize.x; x++) {
+            int x0 = x * size.x / outSize.x;
+            int x1 = std::max(x0 + 1, (x + 1) * size.x / outSize.x);
+            uint32_t area = (x1 - x0) * (y1 - y0);
+            for (int channel = 0; channel < 3; channel++) {
+                uint32_t sum = 0;
+                for (int column = x0; column < x1; column++)
+                    sum += sums[column * 3 + channel];
+                out[(y * outSize.x + x) * 3 + channel] = (sum + area / 2) / area;
+            }
+        }
+    }
+}
+
+inline void tuim::AccumulateRow(const uint8_t* row, uint32_t* sums, size_t count) {
+    size_t i = 0;
+
+    // Widen 16 bytes at once to add them to the sums.
+    #ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+        __m128i words[2] = { _mm_unpacklo_epi8(bytes, zero), _mm_unpackhi_epi8(bytes, zero) };
+        for (int w = 0; w < 2; w++) {
+            __m128i dwords[2] = { _mm_unpacklo_epi16(words[w], zero), _mm_unpackhi_epi16(words[w], zero) };
+            for (int d = 0; d < 2; d++) {
+                __m128i* target = reinterpret_cast<__m128i*>(sums + i + w * 8 + d * 4);
+                _mm_storeu_si128(target, _mm_add_epi32(_mm_loadu_si128(target), dwords[d]));
+            }
         }
+    }
+    #endif
 
-        line += word;
-        lineCharLength += wordChLen;
+    for (; i < count; i++)
+        sums[i] += row[i];
+}
 
-        if (skipNextLine)
-            lineBreak = true;
+inline tuim::Color tuim::QuantizeColor(const Color& color, ImageFlags flags) {
+    auto Distance = [](int r, int g, int b, const Color& other) {
+        return (r - other.r) * (r - other.r) + (g - other.g) * (g - other.g) + (b - other.b) * (b - other.b);
+    };
 
-        i = wordPos + 1;
+    if (flags & IMAGE_FLAGS_16_COLORS) {
+        static const Color s_Palette[16] = {
+            Color(0, 0, 0), Color(128, 0, 0), Color(0, 128, 0), Color(128, 128, 0),
+            Color(0, 0, 128), Color(128, 0, 128), Color(0, 128, 128), Color(192, 192, 192),
+            Color(128, 128, 128), Color(255, 0, 0), Color(0, 255, 0), Color(255, 255, 0),
+            Color(0, 0, 255), Color(255, 0, 255), Color(0, 255, 255), Color(255, 255, 255)
+        };
+        const Color* nearest = &s_Palette[0];
+        for (const Color& entry : s_Palette) {
+            if (Distance(color.r, color.g, color.b, entry) < Distance(color.r, color.g, color.b, *nearest))
+                nearest = &entry;
+        }
+        return Color(nearest->r, nearest->g, nearest->b, color.bg);
     }
 
-    if (lineCharLength > 0) {
-        tuim::Print(line);
+    if (flags & IMAGE_FLAGS_256_COLORS) {
+        // The palette is made of a 6x6x6 color cube and a ramp of 24 grays.
+        static constexpr uint8_t s_Levels[6] = { 0, 95, 135, 175, 215, 255 };
+        auto NearestLevel = [](uint8_t value) { return value < 48 ? 0 : value < 115 ? 1 : (value - 35) / 40; };
+        Color cube(s_Levels[NearestLevel(color.r)], s_Levels[NearestLevel(color.g)], s_Levels[NearestLevel(color.b)]);
+
+        int average = (color.r + color.g + color.b) / 3;
+        uint8_t grayLevel = 8 + 10 * std::clamp((average - 3) / 10, 0, 23);
+        Color gray(grayLevel, grayLevel, grayLevel);
+
+        const Color& nearest = (Distance(color.r, color.g, color.b, gray) < Distance(color.r, color.g, color.b, cube)) ? gray : cube;
+        return Color(nearest.r, nearest.g, nearest.b, color.bg);
     }
+    return color;
+}
 
-    tuim::Print("&r");
-    for(int i = 0; i < 1 + lineBreak; i++)
-        tuim::Print("\n");
+inline void tuim::DrawImage(const ImageData& image) {
+    Context* ctx = tuim::GetCtx();
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    vec2 start = frame->m_Cursor;
+
+    // Clusters are stored in a pool cleared with each frame, so they are interned again.
+    std::vector<std::pair<size_t, std::u32string>>::const_iterator cluster = image.m_Clusters.begin();
+    for (int y = 0; y < image.m_Size.y; y++) {
+        for (int x = 0; x < image.m_Size.x; x++) {
+            size_t index = y * image.m_Size.x + x;
+            const std::shared_ptr<Cell>& cell = image.m_Cells[index];
+            if (cell == nullptr)
+                continue;
+
+            if (cluster != image.m_Clusters.end() && cluster->first == index) {
+                std::shared_ptr<Cell> copy = std::make_shared<Cell>(*cell);
+                copy->m_Cluster = ctx->m_Clusters.Intern(cluster->second);
+                frame->Set(vec2(start.x + x, start.y + y), copy);
+                cluster++;
+            }
+            else frame->Set(vec2(start.x + x, start.y + y), cell);
+        }
+    }
 }
 
 /***********************************************************
@@ -2029,32 +6986,47 @@ inline char32_t tuim::Utf8Decode(const char* bytes, size_t length) {
     return ch; 
 }
 
-inline void tuim::Utf8IterateString(std::string_view sv, std::function<void(char32_t, size_t)> func) {
+inline uint8_t tuim::Utf8DecodeNext(std::string_view sv, size_t index, char32_t& ch) {
+    char8_t lead = static_cast<char8_t>(sv[index]);
+    if (lead < 0x80) {
+        ch = lead;
+        return 1;
+    }
+
+    // Determine the number of bytes of the character and check if there are enough bytes left in the string.
+    uint8_t length = tuim::Utf8CharLength(sv[index]);
+    if (length == 0 || index + length > sv.size()) {
+        ch = 0xFFFD;
+        return 1;
+    }
+
+    // Decode the full UTF8 character from the string by reading several bytes.
+    char32_t value = lead & ((1 << (7 - length)) - 1); // Mask initial bits.
+    for (size_t i = 1; i < length; ++i) {
+        char8_t cont = static_cast<char8_t>(sv[index + i]);
+        if ((cont & UTF8_CONT_MASK) != UTF8_CONT_TAG) {
+            ch = 0xFFFD;
+            return 1;
+        }
+        value = (value << 6) | (cont & 0b00111111);
+    }
+
+    // Overlong encodings (C0/C1, E0 80..9F, F0 80..8F), surrogates (ED A0..BF) and values beyond U+10FFFF are invalid.
+    static constexpr char32_t s_MinValues[5] = { 0, 0, 0x80, 0x800, 0x10000 };
+    if (value < s_MinValues[length] || (value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF) {
+        ch = 0xFFFD;
+        return 1;
+    }
+
+    ch = value;
+    return length;
+}
+
+template <typename Func> inline void tuim::Utf8IterateString(std::string_view sv, Func&& func) {
     size_t index = 0;
     while (index < sv.size()) {
-        // Determine the number of bytes for the next character
-        // and check if there are enough bytes left in the string.
-        uint8_t length = tuim::Utf8CharLength(sv[index]);
-        if (index + length > sv.size())
-            return;
-        
-        // Decode the full UTF8 character from the string by reading several bytes.
-        char32_t ch = 0;
-        char8_t lead = static_cast<char8_t>(sv[index]);
-        if (length == 1) {
-            ch = lead;
-        }
-        else {
-            ch = lead & ((1 << (7 - length)) - 1); // Mask initial bits.
-            for (size_t i = 1; i < length; ++i) {
-                char8_t cont = static_cast<char8_t>(sv[index + i]);
-                if ((cont & UTF8_CONT_MASK) != UTF8_CONT_TAG) {
-                    // throw std::runtime_error("error: invalid UTF-8 continuation byte.");
-                    return;
-                }
-                ch = (ch << 6) | (cont & 0b00111111);
-            }
-        }
+        char32_t ch;
+        uint8_t length = tuim::Utf8DecodeNext(sv, index, ch);
 
         // Call the callback function and advance to the next character.
         func(ch, index);
@@ -2062,6 +7034,61 @@ inline void tuim::Utf8IterateString(std::string_view sv, std::function<void(char
     }
 }
 
+inline void tuim::Utf8DecodeString(std::string_view sv, std::u32string& chars, std::vector<uint32_t>* offsets) {
+    const char* data = sv.data();
+    const size_t size = sv.size();
+    chars.reserve(chars.size() + size);
+    if (offsets != nullptr)
+        offsets->reserve(offsets->size() + size + 1);
+
+    // Widen a block of ASCII characters (already validated).
+    auto WidenAscii = [&](size_t index, size_t count) {
+        size_t start = chars.size();
+        chars.resize(start + count);
+        for (size_t k = 0; k < count; k++)
+            chars[start + k] = static_cast<unsigned char>(data[index + k]);
+        if (offsets != nullptr) {
+            for (size_t k = 0; k < count; k++)
+                offsets->push_back(index + k);
+        }
+    };
+
+    size_t i = 0;
+    while (i < size) {
+        // Skip over blocks of ASCII characters by checking the high bit of 16 or 8 bytes at once.
+        #ifdef __SSE2__
+        while (i + 16 <= size) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            if (_mm_movemask_epi8(block) != 0)
+                break;
+            WidenAscii(i, 16);
+            i += 16;
+        }
+        #endif
+        while (i + 8 <= size) {
+            uint64_t block;
+            std::memcpy(&block, data + i, sizeof(block));
+            if (block & 0x8080808080808080ULL)
+                break;
+            WidenAscii(i, 8);
+            i += 8;
+        }
+        if (i >= size)
+            break;
+
+        // Decode a single character (which might be multi-bytes).
+        char32_t ch;
+        uint8_t length = tuim::Utf8DecodeNext(sv, i, ch);
+        chars.push_back(ch);
+        if (offsets != nullptr)
+            offsets->push_back(i);
+        i += length;
+    }
+
+    if (offsets != nullptr)
+        offsets->push_back(size);
+}
+
 // http://www.cse.yorku.ca/~oz/hash.html
 inline tuim::ItemId tuim::StringToId(std::string_view sv) {
     unsigned long hash = 5381;
@@ -2114,6 +7141,53 @@ inline bool tuim::IsAlphaNumeric(const std::string& str) {
 }
 
 inline size_t tuim::CalcTextWidth(std::string_view sv) {
+    return tuim::GetTextMetrics(sv).m_Width;
+}
+
+inline const tuim::TextMetrics& tuim::GetTextMetrics(std::string_view sv) {
+    // Measure the text directly if there is no context to hold the cache.
+    static thread_local TextMetrics s_Metrics;
+    if (tuim::ctx == nullptr) {
+        s_Metrics = tuim::CalcTextMetrics(sv);
+        return s_Metrics;
+    }
+    return tuim::ctx->m_TextCache.Get(sv);
+}
+
+inline size_t tuim::CalcPlainTextWidth(std::string_view sv) {
+    // Printable ASCII characters are a single column wide.
+    size_t i = 0;
+    while (i < sv.size() && sv[i] >= 0x20 && sv[i] < 0x7F) i++;
+    if (i == sv.size())
+        return sv.size();
+
+    static thread_local std::u32string s_Chars;
+    s_Chars.clear();
+    tuim::Utf8DecodeString(sv, s_Chars, nullptr);
+    std::u32string_view chars = s_Chars;
+
+    size_t width = 0;
+    for (size_t j = 0; j < chars.size();) {
+        size_t clusterLength = tuim::GraphemeLength(chars, j);
+        width += std::max(0, tuim::GraphemeWidth(chars.substr(j, clusterLength)));
+        j += clusterLength;
+    }
+    return width;
+}
+
+inline tuim::TextMetrics tuim::CalcTextMetrics(std::string_view sv) {
+    TextMetrics metrics;
+
+    // Decode the whole string with the same decoder as Print, the offsets give the byte position of each line.
+    static thread_local std::u32string s_Chars;
+    static thread_local std::vector<uint32_t> s_Offsets;
+    s_Chars.clear();
+    s_Offsets.clear();
+    tuim::Utf8DecodeString(sv, s_Chars, &s_Offsets);
+    const std::u32string& chars = s_Chars;
+    const size_t length = chars.size();
+    metrics.m_LineStarts.push_back(0);
+
     // Keep two variables to keep track of the largest line if there are several.
     size_t width = 0;
     size_t maxWidth = 0;
@@ -2121,9 +7195,9 @@ inline size_t tuim::CalcTextWidth(std::string_view sv) {
     bool escaped = false;
 
     size_t i = 0;
-    while (i < sv.length()) {
-        char c = sv[i];
-        char cc = (i+1 < sv.length()) ? sv[i+1] : '\0';
+    while (i < length) {
+        char32_t c = chars[i];
+        char32_t cc = (i+1 < length) ? chars[i+1] : U'\0';
 
         // Skip color and style formatting tags.
         if (!escaped) {
@@ -2136,8 +7210,8 @@ inline size_t tuim::CalcTextWidth(std::string_view sv) {
                 }
                 
                 // Make sure that it doesn't go beyond the string length.
-                size_t codeSize = 1 + (cc == '_') + (cc == '#' ? 6 : 1);
-                if (i + codeSize <= sv.length()) {
+                size_t codeSize = 1 + (cc == '_') + (c == '#' ? 6 : 1);
+                if (i + codeSize <= length) {
                     i += codeSize;
                     continue;
                 }
@@ -2145,32 +7219,476 @@ inline size_t tuim::CalcTextWidth(std::string_view sv) {
         }
         escaped = false;
 
-        // Handle regular characters (not style tags).
-        uint8_t charLength = tuim::Utf8CharLength(c);
-        if (charLength == 0 || i + charLength > sv.length()) {
-            // Invalid UTF-8 sequence, treat as single byte and advance.
-            charLength = 1;
-        }
-        char32_t ch = tuim::Utf8Decode(sv.data() + i, charLength);
-
         // new line: check if it was the largest line.
-        if (ch == '\n') {
+        if (c == '\n') {
+            metrics.m_LineWidths.push_back(width);
+            metrics.m_LineStarts.push_back(s_Offsets[i + 1]);
             maxWidth = std::max(width, maxWidth);
             width = 0;
+            i++;
         }
         // tab: increase width by 4.
-        else if (ch == '\t') {
+        else if (c == '\t') {
             width += 4;
+            i++;
         }
         else {
-            width += tuim::Utf8CharWidth(ch);
+            // Measure the whole grapheme cluster the same way it will be printed.
+            size_t clusterLength = tuim::GraphemeLength(chars, i);
+            if (clusterLength > 1) width += tuim::GraphemeWidth(std::u32string_view(chars).substr(i, clusterLength));
+            else width += tuim::Utf8CharWidth(c);
+            i += clusterLength;
         }
+    }
+
+    metrics.m_LineWidths.push_back(width);
+    metrics.m_Width = std::max(width, maxWidth);
+    return metrics;
+}
+
+/***********************************************************
+*                       TEXT CACHE                         *
+***********************************************************/
+
+template <typename T> inline T* tuim::LruCache<T>::Find(std::string_view key) {
+    auto it = m_Index.find(key);
+    if (it == m_Index.end()) {
+        m_Misses++;
+        return nullptr;
+    }
+
+    // Move the entry to the front of the list.
+    m_Hits++;
+    m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+    return &it->second->second;
+}
+
+template <typename T> inline T& tuim::LruCache<T>::Insert(std::string_view key, T value) {
+    auto it = m_Index.find(key);
+    if (it != m_Index.end()) {
+        m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+        it->second->second = std::move(value);
+        return it->second->second;
+    }
 
-        // Move to the next UTF-8 character
-        i += charLength;
+    // Evict the least recently used entries to make room for the new one.
+    while (!m_Entries.empty() && m_Entries.size() >= std::max<size_t>(m_Capacity, 1)) {
+        m_Index.erase(m_Entries.back().first);
+        m_Entries.pop_back();
     }
 
-    return std::max(width, maxWidth);
+    m_Entries.emplace_front(std::string(key), std::move(value));
+    m_Index.emplace(m_Entries.front().first, m_Entries.begin());
+    return m_Entries.front().second;
+}
+
+template <typename T> inline void tuim::LruCache<T>::SetCapacity(size_t capacity) {
+    m_Capacity = capacity;
+    while (m_Entries.size() > m_Capacity) {
+        m_Index.erase(m_Entries.back().first);
+        m_Entries.pop_back();
+    }
+}
+
+template <typename T> inline void tuim::LruCache<T>::Clear() {
+    m_Entries.clear();
+    m_Index.clear();
+    m_Hits = 0;
+    m_Misses = 0;
+}
+
+inline const tuim::TextMetrics& tuim::TextCache::Get(std::string_view sv) {
+    if (m_Capacity == 0) {
+        m_Misses++;
+        m_Uncached = tuim::CalcTextMetrics(sv);
+        return m_Uncached;
+    }
+
+    if (TextMetrics* metrics = Find(sv))
+        return *metrics;
+    return Insert(sv, tuim::CalcTextMetrics(sv));
+}
+
+/***********************************************************
+*                         UNICODE                          *
+***********************************************************/
+
+namespace tuim {
+    // Grapheme_Cluster_Break property ranges from the Unicode Character Database (14.0.0),
+    // merged with the Extended_Pictographic property. Hangul syllables (LV/LVT) are not
+    // listed because they can be computed directly from their code point.
+    inline constexpr GraphemeBreakRange GRAPHEME_BREAK_RANGES[] = {
+        { 0x0000, 0x0009, GraphemeBreak::CONTROL }, { 0x000A, 0x000A, GraphemeBreak::LF }, { 0x000B, 0x000C, GraphemeBreak::CONTROL },
+        { 0x000D, 0x000D, GraphemeBreak::CR }, { 0x000E, 0x001F, GraphemeBreak::CONTROL }, { 0x007F, 0x009F, GraphemeBreak::CONTROL },
+        { 0x00A9, 0x00A9, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x00AD, 0x00AD, GraphemeBreak::CONTROL }, { 0x00AE, 0x00AE, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x0300, 0x036F, GraphemeBreak::EXTEND }, { 0x0483, 0x0489, GraphemeBreak::EXTEND }, { 0x0591, 0x05BD, GraphemeBreak::EXTEND },
+        { 0x05BF, 0x05BF, GraphemeBreak::EXTEND }, { 0x05C1, 0x05C2, GraphemeBreak::EXTEND }, { 0x05C4, 0x05C5, GraphemeBreak::EXTEND },
+        { 0x05C7, 0x05C7, GraphemeBreak::EXTEND }, { 0x0600, 0x0605, GraphemeBreak::PREPEND }, { 0x0610, 0x061A, GraphemeBreak::EXTEND },
+        { 0x061C, 0x061C, GraphemeBreak::CONTROL }, { 0x064B, 0x065F, GraphemeBreak::EXTEND }, { 0x0670, 0x0670, GraphemeBreak::EXTEND },
+        { 0x06D6, 0x06DC, GraphemeBreak::EXTEND }, { 0x06DD, 0x06DD, GraphemeBreak::PREPEND }, { 0x06DF, 0x06E4, GraphemeBreak::EXTEND },
+        { 0x06E7, 0x06E8, GraphemeBreak::EXTEND }, { 0x06EA, 0x06ED, GraphemeBreak::EXTEND }, { 0x070F, 0x070F, GraphemeBreak::PREPEND },
+        { 0x0711, 0x0711, GraphemeBreak::EXTEND }, { 0x0730, 0x074A, GraphemeBreak::EXTEND }, { 0x07A6, 0x07B0, GraphemeBreak::EXTEND },
+        { 0x07EB, 0x07F3, GraphemeBreak::EXTEND }, { 0x07FD, 0x07FD, GraphemeBreak::EXTEND }, { 0x0816, 0x0819, GraphemeBreak::EXTEND },
+        { 0x081B, 0x0823, GraphemeBreak::EXTEND }, { 0x0825, 0x0827, GraphemeBreak::EXTEND }, { 0x0829, 0x082D, GraphemeBreak::EXTEND },
+        { 0x0859, 0x085B, GraphemeBreak::EXTEND }, { 0x0890, 0x0891, GraphemeBreak::PREPEND }, { 0x0898, 0x089F, GraphemeBreak::EXTEND },
+        { 0x08CA, 0x08E1, GraphemeBreak::EXTEND }, { 0x08E2, 0x08E2, GraphemeBreak::PREPEND }, { 0x08E3, 0x0902, GraphemeBreak::EXTEND },
+        { 0x0903, 0x0903, GraphemeBreak::SPACING_MARK }, { 0x093A, 0x093A, GraphemeBreak::EXTEND }, { 0x093B, 0x093B, GraphemeBreak::SPACING_MARK },
+        { 0x093C, 0x093C, GraphemeBreak::EXTEND }, { 0x093E, 0x0940, GraphemeBreak::SPACING_MARK }, { 0x0941, 0x0948, GraphemeBreak::EXTEND },
+        { 0x0949, 0x094C, GraphemeBreak::SPACING_MARK }, { 0x094D, 0x094D, GraphemeBreak::EXTEND }, { 0x094E, 0x094F, GraphemeBreak::SPACING_MARK },
+        { 0x0951, 0x0957, GraphemeBreak::EXTEND }, { 0x0962, 0x0963, GraphemeBreak::EXTEND }, { 0x0981, 0x0981, GraphemeBreak::EXTEND },
+        { 0x0982, 0x0983, GraphemeBreak::SPACING_MARK }, { 0x09BC, 0x09BC, GraphemeBreak::EXTEND }, { 0x09BE, 0x09BE, GraphemeBreak::EXTEND },
+        { 0x09BF, 0x09C0, GraphemeBreak::SPACING_MARK }, { 0x09C1, 0x09C4, GraphemeBreak::EXTEND }, { 0x09C7, 0x09C8, GraphemeBreak::SPACING_MARK },
+        { 0x09CB, 0x09CC, GraphemeBreak::SPACING_MARK }, { 0x09CD, 0x09CD, GraphemeBreak::EXTEND }, { 0x09D7, 0x09D7, GraphemeBreak::EXTEND },
+        { 0x09E2, 0x09E3, GraphemeBreak::EXTEND }, { 0x09FE, 0x09FE, GraphemeBreak::EXTEND }, { 0x0A01, 0x0A02, GraphemeBreak::EXTEND },
+        { 0x0A03, 0x0A03, GraphemeBreak::SPACING_MARK }, { 0x0A3C, 0x0A3C, GraphemeBreak::EXTEND }, { 0x0A3E, 0x0A40, GraphemeBreak::SPACING_MARK },
+        { 0x0A41, 0x0A42, GraphemeBreak::EXTEND }, { 0x0A47, 0x0A48, GraphemeBreak::EXTEND }, { 0x0A4B, 0x0A4D, GraphemeBreak::EXTEND },
+        { 0x0A51, 0x0A51, GraphemeBreak::EXTEND }, { 0x0A70, 0x0A71, GraphemeBreak::EXTEND }, { 0x0A75, 0x0A75, GraphemeBreak::EXTEND },
+        { 0x0A81, 0x0A82, GraphemeBreak::EXTEND }, { 0x0A83, 0x0A83, GraphemeBreak::SPACING_MARK }, { 0x0ABC, 0x0ABC, GraphemeBreak::EXTEND },
+        { 0x0ABE, 0x0AC0, GraphemeBreak::SPACING_MARK }, { 0x0AC1, 0x0AC5, GraphemeBreak::EXTEND }, { 0x0AC7, 0x0AC8, GraphemeBreak::EXTEND },
+        { 0x0AC9, 0x0AC9, GraphemeBreak::SPACING_MARK }, { 0x0ACB, 0x0ACC, GraphemeBreak::SPACING_MARK }, { 0x0ACD, 0x0ACD, GraphemeBreak::EXTEND },
+        { 0x0AE2, 0x0AE3, GraphemeBreak::EXTEND }, { 0x0AFA, 0x0AFF, GraphemeBreak::EXTEND }, { 0x0B01, 0x0B01, GraphemeBreak::EXTEND },
+        { 0x0B02, 0x0B03, GraphemeBreak::SPACING_MARK }, { 0x0B3C, 0x0B3C, GraphemeBreak::EXTEND }, { 0x0B3E, 0x0B3F, GraphemeBreak::EXTEND },
+        { 0x0B40, 0x0B40, GraphemeBreak::SPACING_MARK }, { 0x0B41, 0x0B44, GraphemeBreak::EXTEND }, { 0x0B47, 0x0B48, GraphemeBreak::SPACING_MARK },
+        { 0x0B4B, 0x0B4C, GraphemeBreak::SPACING_MARK }, { 0x0B4D, 0x0B4D, GraphemeBreak::EXTEND }, { 0x0B55, 0x0B57, GraphemeBreak::EXTEND },
+        { 0x0B62, 0x0B63, GraphemeBreak::EXTEND }, { 0x0B82, 0x0B82, GraphemeBreak::EXTEND }, { 0x0BBE, 0x0BBE, GraphemeBreak::EXTEND },
+        { 0x0BBF, 0x0BBF, GraphemeBreak::SPACING_MARK }, { 0x0BC0, 0x0BC0, GraphemeBreak::EXTEND }, { 0x0BC1, 0x0BC2, GraphemeBreak::SPACING_MARK },
+        { 0x0BC6, 0x0BC8, GraphemeBreak::SPACING_MARK }, { 0x0BCA, 0x0BCC, GraphemeBreak::SPACING_MARK }, { 0x0BCD, 0x0BCD, GraphemeBreak::EXTEND },
+        { 0x0BD7, 0x0BD7, GraphemeBreak::EXTEND }, { 0x0C00, 0x0C00, GraphemeBreak::EXTEND }, { 0x0C01, 0x0C03, GraphemeBreak::SPACING_MARK },
+        { 0x0C04, 0x0C04, GraphemeBreak::EXTEND }, { 0x0C3C, 0x0C3C, GraphemeBreak::EXTEND }, { 0x0C3E, 0x0C40, GraphemeBreak::EXTEND },
+        { 0x0C41, 0x0C44, GraphemeBreak::SPACING_MARK }, { 0x0C46, 0x0C48, GraphemeBreak::EXTEND }, { 0x0C4A, 0x0C4D, GraphemeBreak::EXTEND },
+        { 0x0C55, 0x0C56, GraphemeBreak::EXTEND }, { 0x0C62, 0x0C63, GraphemeBreak::EXTEND }, { 0x0C81, 0x0C81, GraphemeBreak::EXTEND },
+        { 0x0C82, 0x0C83, GraphemeBreak::SPACING_MARK }, { 0x0CBC, 0x0CBC, GraphemeBreak::EXTEND }, { 0x0CBE, 0x0CBE, GraphemeBreak::SPACING_MARK },
+        { 0x0CBF, 0x0CBF, GraphemeBreak::EXTEND }, { 0x0CC0, 0x0CC1, GraphemeBreak::SPACING_MARK }, { 0x0CC2, 0x0CC2, GraphemeBreak::EXTEND },
+        { 0x0CC3, 0x0CC4, GraphemeBreak::SPACING_MARK }, { 0x0CC6, 0x0CC6, GraphemeBreak::EXTEND }, { 0x0CC7, 0x0CC8, GraphemeBreak::SPACING_MARK },
+        { 0x0CCA, 0x0CCB, GraphemeBreak::SPACING_MARK }, { 0x0CCC, 0x0CCD, GraphemeBreak::EXTEND }, { 0x0CD5, 0x0CD6, GraphemeBreak::EXTEND },
+        { 0x0CE2, 0x0CE3, GraphemeBreak::EXTEND }, { 0x0D00, 0x0D01, GraphemeBreak::EXTEND }, { 0x0D02, 0x0D03, GraphemeBreak::SPACING_MARK },
+        { 0x0D3B, 0x0D3C, GraphemeBreak::EXTEND }, { 0x0D3E, 0x0D3E, GraphemeBreak::EXTEND }, { 0x0D3F, 0x0D40, GraphemeBreak::SPACING_MARK },
+        { 0x0D41, 0x0D44, GraphemeBreak::EXTEND }, { 0x0D46, 0x0D48, GraphemeBreak::SPACING_MARK }, { 0x0D4A, 0x0D4C, GraphemeBreak::SPACING_MARK },
+        { 0x0D4D, 0x0D4D, GraphemeBreak::EXTEND }, { 0x0D4E, 0x0D4E, GraphemeBreak::PREPEND }, { 0x0D57, 0x0D57, GraphemeBreak::EXTEND },
+        { 0x0D62, 0x0D63, GraphemeBreak::EXTEND }, { 0x0D81, 0x0D81, GraphemeBreak::EXTEND }, { 0x0D82, 0x0D83, GraphemeBreak::SPACING_MARK },
+        { 0x0DCA, 0x0DCA, GraphemeBreak::EXTEND }, { 0x0DCF, 0x0DCF, GraphemeBreak::EXTEND }, { 0x0DD0, 0x0DD1, GraphemeBreak::SPACING_MARK },
+        { 0x0DD2, 0x0DD4, GraphemeBreak::EXTEND }, { 0x0DD6, 0x0DD6, GraphemeBreak::EXTEND }, { 0x0DD8, 0x0DDE, GraphemeBreak::SPACING_MARK },
+        { 0x0DDF, 0x0DDF, GraphemeBreak::EXTEND }, { 0x0DF2, 0x0DF3, GraphemeBreak::SPACING_MARK }, { 0x0E31, 0x0E31, GraphemeBreak::EXTEND },
+        { 0x0E33, 0x0E33, GraphemeBreak::SPACING_MARK }, { 0x0E34, 0x0E3A, GraphemeBreak::EXTEND }, { 0x0E47, 0x0E4E, GraphemeBreak::EXTEND },
+        { 0x0EB1, 0x0EB1, GraphemeBreak::EXTEND }, { 0x0EB3, 0x0EB3, GraphemeBreak::SPACING_MARK }, { 0x0EB4, 0x0EBC, GraphemeBreak::EXTEND },
+        { 0x0EC8, 0x0ECD, GraphemeBreak::EXTEND }, { 0x0F18, 0x0F19, GraphemeBreak::EXTEND }, { 0x0F35, 0x0F35, GraphemeBreak::EXTEND },
+        { 0x0F37, 0x0F37, GraphemeBreak::EXTEND }, { 0x0F39, 0x0F39, GraphemeBreak::EXTEND }, { 0x0F3E, 0x0F3F, GraphemeBreak::SPACING_MARK },
+        { 0x0F71, 0x0F7E, GraphemeBreak::EXTEND }, { 0x0F7F, 0x0F7F, GraphemeBreak::SPACING_MARK }, { 0x0F80, 0x0F84, GraphemeBreak::EXTEND },
+        { 0x0F86, 0x0F87, GraphemeBreak::EXTEND }, { 0x0F8D, 0x0F97, GraphemeBreak::EXTEND }, { 0x0F99, 0x0FBC, GraphemeBreak::EXTEND },
+        { 0x0FC6, 0x0FC6, GraphemeBreak::EXTEND }, { 0x102D, 0x1030, GraphemeBreak::EXTEND }, { 0x1031, 0x1031, GraphemeBreak::SPACING_MARK },
+        { 0x1032, 0x1037, GraphemeBreak::EXTEND }, { 0x1039, 0x103A, GraphemeBreak::EXTEND }, { 0x103B, 0x103C, GraphemeBreak::SPACING_MARK },
+        { 0x103D, 0x103E, GraphemeBreak::EXTEND }, { 0x1056, 0x1057, GraphemeBreak::SPACING_MARK }, { 0x1058, 0x1059, GraphemeBreak::EXTEND },
+        { 0x105E, 0x1060, GraphemeBreak::EXTEND }, { 0x1071, 0x1074, GraphemeBreak::EXTEND }, { 0x1082, 0x1082, GraphemeBreak::EXTEND },
+        { 0x1084, 0x1084, GraphemeBreak::SPACING_MARK }, { 0x1085, 0x1086, GraphemeBreak::EXTEND }, { 0x108D, 0x108D, GraphemeBreak::EXTEND },
+        { 0x109D, 0x109D, GraphemeBreak::EXTEND }, { 0x1100, 0x115F, GraphemeBreak::L }, { 0x1160, 0x11A7, GraphemeBreak::V },
+        { 0x11A8, 0x11FF, GraphemeBreak::T }, { 0x135D, 0x135F, GraphemeBreak::EXTEND }, { 0x1712, 0x1714, GraphemeBreak::EXTEND },
+        { 0x1715, 0x1715, GraphemeBreak::SPACING_MARK }, { 0x1732, 0x1733, GraphemeBreak::EXTEND }, { 0x1734, 0x1734, GraphemeBreak::SPACING_MARK },
+        { 0x1752, 0x1753, GraphemeBreak::EXTEND }, { 0x1772, 0x1773, GraphemeBreak::EXTEND }, { 0x17B4, 0x17B5, GraphemeBreak::EXTEND },
+        { 0x17B6, 0x17B6, GraphemeBreak::SPACING_MARK }, { 0x17B7, 0x17BD, GraphemeBreak::EXTEND }, { 0x17BE, 0x17C5, GraphemeBreak::SPACING_MARK },
+        { 0x17C6, 0x17C6, GraphemeBreak::EXTEND }, { 0x17C7, 0x17C8, GraphemeBreak::SPACING_MARK }, { 0x17C9, 0x17D3, GraphemeBreak::EXTEND },
+        { 0x17DD, 0x17DD, GraphemeBreak::EXTEND }, { 0x180B, 0x180D, GraphemeBreak::EXTEND }, { 0x180E, 0x180E, GraphemeBreak::CONTROL },
+        { 0x180F, 0x180F, GraphemeBreak::EXTEND }, { 0x1885, 0x1886, GraphemeBreak::EXTEND }, { 0x18A9, 0x18A9, GraphemeBreak::EXTEND },
+        { 0x1920, 0x1922, GraphemeBreak::EXTEND }, { 0x1923, 0x1926, GraphemeBreak::SPACING_MARK }, { 0x1927, 0x1928, GraphemeBreak::EXTEND },
+        { 0x1929, 0x192B, GraphemeBreak::SPACING_MARK }, { 0x1930, 0x1931, GraphemeBreak::SPACING_MARK }, { 0x1932, 0x1932, GraphemeBreak::EXTEND },
+        { 0x1933, 0x1938, GraphemeBreak::SPACING_MARK }, { 0x1939, 0x193B, GraphemeBreak::EXTEND }, { 0x1A17, 0x1A18, GraphemeBreak::EXTEND },
+        { 0x1A19, 0x1A1A, GraphemeBreak::SPACING_MARK }, { 0x1A1B, 0x1A1B, GraphemeBreak::EXTEND }, { 0x1A55, 0x1A55, GraphemeBreak::SPACING_MARK },
+        { 0x1A56, 0x1A56, GraphemeBreak::EXTEND }, { 0x1A57, 0x1A57, GraphemeBreak::SPACING_MARK }, { 0x1A58, 0x1A5E, GraphemeBreak::EXTEND },
+        { 0x1A60, 0x1A60, GraphemeBreak::EXTEND }, { 0x1A62, 0x1A62, GraphemeBreak::EXTEND }, { 0x1A65, 0x1A6C, GraphemeBreak::EXTEND },
+        { 0x1A6D, 0x1A72, GraphemeBreak::SPACING_MARK }, { 0x1A73, 0x1A7C, GraphemeBreak::EXTEND }, { 0x1A7F, 0x1A7F, GraphemeBreak::EXTEND },
+        { 0x1AB0, 0x1ACE, GraphemeBreak::EXTEND }, { 0x1B00, 0x1B03, GraphemeBreak::EXTEND }, { 0x1B04, 0x1B04, GraphemeBreak::SPACING_MARK },
+        { 0x1B34, 0x1B3A, GraphemeBreak::EXTEND }, { 0x1B3B, 0x1B3B, GraphemeBreak::SPACING_MARK }, { 0x1B3C, 0x1B3C, GraphemeBreak::EXTEND },
+        { 0x1B3D, 0x1B41, GraphemeBreak::SPACING_MARK }, { 0x1B42, 0x1B42, GraphemeBreak::EXTEND }, { 0x1B43, 0x1B44, GraphemeBreak::SPACING_MARK },
+        { 0x1B6B, 0x1B73, GraphemeBreak::EXTEND }, { 0x1B80, 0x1B81, GraphemeBreak::EXTEND }, { 0x1B82, 0x1B82, GraphemeBreak::SPACING_MARK },
+        { 0x1BA1, 0x1BA1, GraphemeBreak::SPACING_MARK }, { 0x1BA2, 0x1BA5, GraphemeBreak::EXTEND }, { 0x1BA6, 0x1BA7, GraphemeBreak::SPACING_MARK },
+        { 0x1BA8, 0x1BA9, GraphemeBreak::EXTEND }, { 0x1BAA, 0x1BAA, GraphemeBreak::SPACING_MARK }, { 0x1BAB, 0x1BAD, GraphemeBreak::EXTEND },
+        { 0x1BE6, 0x1BE6, GraphemeBreak::EXTEND }, { 0x1BE7, 0x1BE7, GraphemeBreak::SPACING_MARK }, { 0x1BE8, 0x1BE9, GraphemeBreak::EXTEND },
+        { 0x1BEA, 0x1BEC, GraphemeBreak::SPACING_MARK }, { 0x1BED, 0x1BED, GraphemeBreak::EXTEND }, { 0x1BEE, 0x1BEE, GraphemeBreak::SPACING_MARK },
+        { 0x1BEF, 0x1BF1, GraphemeBreak::EXTEND }, { 0x1BF2, 0x1BF3, GraphemeBreak::SPACING_MARK }, { 0x1C24, 0x1C2B, GraphemeBreak::SPACING_MARK },
+        { 0x1C2C, 0x1C33, GraphemeBreak::EXTEND }, { 0x1C34, 0x1C35, GraphemeBreak::SPACING_MARK }, { 0x1C36, 0x1C37, GraphemeBreak::EXTEND },
+        { 0x1CD0, 0x1CD2, GraphemeBreak::EXTEND }, { 0x1CD4, 0x1CE0, GraphemeBreak::EXTEND }, { 0x1CE1, 0x1CE1, GraphemeBreak::SPACING_MARK },
+        { 0x1CE2, 0x1CE8, GraphemeBreak::EXTEND }, { 0x1CED, 0x1CED, GraphemeBreak::EXTEND }, { 0x1CF4, 0x1CF4, GraphemeBreak::EXTEND },
+        { 0x1CF7, 0x1CF7, GraphemeBreak::SPACING_MARK }, { 0x1CF8, 0x1CF9, GraphemeBreak::EXTEND }, { 0x1DC0, 0x1DFF, GraphemeBreak::EXTEND },
+        { 0x200B, 0x200B, GraphemeBreak::CONTROL }, { 0x200C, 0x200C, GraphemeBreak::EXTEND }, { 0x200D, 0x200D, GraphemeBreak::ZWJ },
+        { 0x200E, 0x200F, GraphemeBreak::CONTROL }, { 0x2028, 0x202E, GraphemeBreak::CONTROL }, { 0x203C, 0x203C, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2049, 0x2049, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2060, 0x206F, GraphemeBreak::CONTROL }, { 0x20D0, 0x20F0, GraphemeBreak::EXTEND },
+        { 0x2122, 0x2122, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2139, 0x2139, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2194, 0x2199, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x21A9, 0x21AA, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x231A, 0x231B, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2328, 0x2328, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2388, 0x2388, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x23CF, 0x23CF, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x23E9, 0x23F3, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x23F8, 0x23FA, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x24C2, 0x24C2, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x25AA, 0x25AB, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x25B6, 0x25B6, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x25C0, 0x25C0, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x25FB, 0x25FE, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2600, 0x2605, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2607, 0x2612, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2614, 0x2685, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2690, 0x2705, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2708, 0x2712, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2714, 0x2714, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2716, 0x2716, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x271D, 0x271D, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2721, 0x2721, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2728, 0x2728, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2733, 0x2734, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2744, 0x2744, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2747, 0x2747, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x274C, 0x274C, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x274E, 0x274E, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2753, 0x2755, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2757, 0x2757, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2763, 0x2767, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2795, 0x2797, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x27A1, 0x27A1, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x27B0, 0x27B0, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x27BF, 0x27BF, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2934, 0x2935, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2B05, 0x2B07, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2B1B, 0x2B1C, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2B50, 0x2B50, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x2B55, 0x2B55, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x2CEF, 0x2CF1, GraphemeBreak::EXTEND }, { 0x2D7F, 0x2D7F, GraphemeBreak::EXTEND }, { 0x2DE0, 0x2DFF, GraphemeBreak::EXTEND },
+        { 0x302A, 0x302F, GraphemeBreak::EXTEND }, { 0x3030, 0x3030, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x303D, 0x303D, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x3099, 0x309A, GraphemeBreak::EXTEND }, { 0x3297, 0x3297, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x3299, 0x3299, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0xA66F, 0xA672, GraphemeBreak::EXTEND }, { 0xA674, 0xA67D, GraphemeBreak::EXTEND }, { 0xA69E, 0xA69F, GraphemeBreak::EXTEND },
+        { 0xA6F0, 0xA6F1, GraphemeBreak::EXTEND }, { 0xA802, 0xA802, GraphemeBreak::EXTEND }, { 0xA806, 0xA806, GraphemeBreak::EXTEND },
+        { 0xA80B, 0xA80B, GraphemeBreak::EXTEND }, { 0xA823, 0xA824, GraphemeBreak::SPACING_MARK }, { 0xA825, 0xA826, GraphemeBreak::EXTEND },
+        { 0xA827, 0xA827, GraphemeBreak::SPACING_MARK }, { 0xA82C, 0xA82C, GraphemeBreak::EXTEND }, { 0xA880, 0xA881, GraphemeBreak::SPACING_MARK },
+        { 0xA8B4, 0xA8C3, GraphemeBreak::SPACING_MARK }, { 0xA8C4, 0xA8C5, GraphemeBreak::EXTEND }, { 0xA8E0, 0xA8F1, GraphemeBreak::EXTEND },
+        { 0xA8FF, 0xA8FF, GraphemeBreak::EXTEND }, { 0xA926, 0xA92D, GraphemeBreak::EXTEND }, { 0xA947, 0xA951, GraphemeBreak::EXTEND },
+        { 0xA952, 0xA953, GraphemeBreak::SPACING_MARK }, { 0xA960, 0xA97C, GraphemeBreak::L }, { 0xA980, 0xA982, GraphemeBreak::EXTEND },
+        { 0xA983, 0xA983, GraphemeBreak::SPACING_MARK }, { 0xA9B3, 0xA9B3, GraphemeBreak::EXTEND }, { 0xA9B4, 0xA9B5, GraphemeBreak::SPACING_MARK },
+        { 0xA9B6, 0xA9B9, GraphemeBreak::EXTEND }, { 0xA9BA, 0xA9BB, GraphemeBreak::SPACING_MARK }, { 0xA9BC, 0xA9BD, GraphemeBreak::EXTEND },
+        { 0xA9BE, 0xA9C0, GraphemeBreak::SPACING_MARK }, { 0xA9E5, 0xA9E5, GraphemeBreak::EXTEND }, { 0xAA29, 0xAA2E, GraphemeBreak::EXTEND },
+        { 0xAA2F, 0xAA30, GraphemeBreak::SPACING_MARK }, { 0xAA31, 0xAA32, GraphemeBreak::EXTEND }, { 0xAA33, 0xAA34, GraphemeBreak::SPACING_MARK },
+        { 0xAA35, 0xAA36, GraphemeBreak::EXTEND }, { 0xAA43, 0xAA43, GraphemeBreak::EXTEND }, { 0xAA4C, 0xAA4C, GraphemeBreak::EXTEND },
+        { 0xAA4D, 0xAA4D, GraphemeBreak::SPACING_MARK }, { 0xAA7C, 0xAA7C, GraphemeBreak::EXTEND }, { 0xAAB0, 0xAAB0, GraphemeBreak::EXTEND },
+        { 0xAAB2, 0xAAB4, GraphemeBreak::EXTEND }, { 0xAAB7, 0xAAB8, GraphemeBreak::EXTEND }, { 0xAABE, 0xAABF, GraphemeBreak::EXTEND },
+        { 0xAAC1, 0xAAC1, GraphemeBreak::EXTEND }, { 0xAAEB, 0xAAEB, GraphemeBreak::SPACING_MARK }, { 0xAAEC, 0xAAED, GraphemeBreak::EXTEND },
+        { 0xAAEE, 0xAAEF, GraphemeBreak::SPACING_MARK }, { 0xAAF5, 0xAAF5, GraphemeBreak::SPACING_MARK }, { 0xAAF6, 0xAAF6, GraphemeBreak::EXTEND },
+        { 0xABE3, 0xABE4, GraphemeBreak::SPACING_MARK }, { 0xABE5, 0xABE5, GraphemeBreak::EXTEND }, { 0xABE6, 0xABE7, GraphemeBreak::SPACING_MARK },
+        { 0xABE8, 0xABE8, GraphemeBreak::EXTEND }, { 0xABE9, 0xABEA, GraphemeBreak::SPACING_MARK }, { 0xABEC, 0xABEC, GraphemeBreak::SPACING_MARK },
+        { 0xABED, 0xABED, GraphemeBreak::EXTEND }, { 0xD7B0, 0xD7C6, GraphemeBreak::V }, { 0xD7CB, 0xD7FB, GraphemeBreak::T },
+        { 0xFB1E, 0xFB1E, GraphemeBreak::EXTEND }, { 0xFE00, 0xFE0F, GraphemeBreak::EXTEND }, { 0xFE20, 0xFE2F, GraphemeBreak::EXTEND },
+        { 0xFEFF, 0xFEFF, GraphemeBreak::CONTROL }, { 0xFF9E, 0xFF9F, GraphemeBreak::EXTEND }, { 0xFFF0, 0xFFFB, GraphemeBreak::CONTROL },
+        { 0x101FD, 0x101FD, GraphemeBreak::EXTEND }, { 0x102E0, 0x102E0, GraphemeBreak::EXTEND }, { 0x10376, 0x1037A, GraphemeBreak::EXTEND },
+        { 0x10A01, 0x10A03, GraphemeBreak::EXTEND }, { 0x10A05, 0x10A06, GraphemeBreak::EXTEND }, { 0x10A0C, 0x10A0F, GraphemeBreak::EXTEND },
+        { 0x10A38, 0x10A3A, GraphemeBreak::EXTEND }, { 0x10A3F, 0x10A3F, GraphemeBreak::EXTEND }, { 0x10AE5, 0x10AE6, GraphemeBreak::EXTEND },
+        { 0x10D24, 0x10D27, GraphemeBreak::EXTEND }, { 0x10EAB, 0x10EAC, GraphemeBreak::EXTEND }, { 0x10F46, 0x10F50, GraphemeBreak::EXTEND },
+        { 0x10F82, 0x10F85, GraphemeBreak::EXTEND }, { 0x11000, 0x11000, GraphemeBreak::SPACING_MARK }, { 0x11001, 0x11001, GraphemeBreak::EXTEND },
+        { 0x11002, 0x11002, GraphemeBreak::SPACING_MARK }, { 0x11038, 0x11046, GraphemeBreak::EXTEND }, { 0x11070, 0x11070, GraphemeBreak::EXTEND },
+        { 0x11073, 0x11074, GraphemeBreak::EXTEND }, { 0x1107F, 0x11081, GraphemeBreak::EXTEND }, { 0x11082, 0x11082, GraphemeBreak::SPACING_MARK },
+        { 0x110B0, 0x110B2, GraphemeBreak::SPACING_MARK }, { 0x110B3, 0x110B6, GraphemeBreak::EXTEND }, { 0x110B7, 0x110B8, GraphemeBreak::SPACING_MARK },
+        { 0x110B9, 0x110BA, GraphemeBreak::EXTEND }, { 0x110BD, 0x110BD, GraphemeBreak::PREPEND }, { 0x110C2, 0x110C2, GraphemeBreak::EXTEND },
+        { 0x110CD, 0x110CD, GraphemeBreak::PREPEND }, { 0x11100, 0x11102, GraphemeBreak::EXTEND }, { 0x11127, 0x1112B, GraphemeBreak::EXTEND },
+        { 0x1112C, 0x1112C, GraphemeBreak::SPACING_MARK }, { 0x1112D, 0x11134, GraphemeBreak::EXTEND }, { 0x11145, 0x11146, GraphemeBreak::SPACING_MARK },
+        { 0x11173, 0x11173, GraphemeBreak::EXTEND }, { 0x11180, 0x11181, GraphemeBreak::EXTEND }, { 0x11182, 0x11182, GraphemeBreak::SPACING_MARK },
+        { 0x111B3, 0x111B5, GraphemeBreak::SPACING_MARK }, { 0x111B6, 0x111BE, GraphemeBreak::EXTEND }, { 0x111BF, 0x111C0, GraphemeBreak::SPACING_MARK },
+        { 0x111C2, 0x111C3, GraphemeBreak::PREPEND }, { 0x111C9, 0x111CC, GraphemeBreak::EXTEND }, { 0x111CE, 0x111CE, GraphemeBreak::SPACING_MARK },
+        { 0x111CF, 0x111CF, GraphemeBreak::EXTEND }, { 0x1122C, 0x1122E, GraphemeBreak::SPACING_MARK }, { 0x1122F, 0x11231, GraphemeBreak::EXTEND },
+        { 0x11232, 0x11233, GraphemeBreak::SPACING_MARK }, { 0x11234, 0x11234, GraphemeBreak::EXTEND }, { 0x11235, 0x11235, GraphemeBreak::SPACING_MARK },
+        { 0x11236, 0x11237, GraphemeBreak::EXTEND }, { 0x1123E, 0x1123E, GraphemeBreak::EXTEND }, { 0x112DF, 0x112DF, GraphemeBreak::EXTEND },
+        { 0x112E0, 0x112E2, GraphemeBreak::SPACING_MARK }, { 0x112E3, 0x112EA, GraphemeBreak::EXTEND }, { 0x11300, 0x11301, GraphemeBreak::EXTEND },
+        { 0x11302, 0x11303, GraphemeBreak::SPACING_MARK }, { 0x1133B, 0x1133C, GraphemeBreak::EXTEND }, { 0x1133E, 0x1133E, GraphemeBreak::EXTEND },
+        { 0x1133F, 0x1133F, GraphemeBreak::SPACING_MARK }, { 0x11340, 0x11340, GraphemeBreak::EXTEND }, { 0x11341, 0x11344, GraphemeBreak::SPACING_MARK },
+        { 0x11347, 0x11348, GraphemeBreak::SPACING_MARK }, { 0x1134B, 0x1134D, GraphemeBreak::SPACING_MARK }, { 0x11357, 0x11357, GraphemeBreak::EXTEND },
+        { 0x11362, 0x11363, GraphemeBreak::SPACING_MARK }, { 0x11366, 0x1136C, GraphemeBreak::EXTEND }, { 0x11370, 0x11374, GraphemeBreak::EXTEND },
+        { 0x11435, 0x11437, GraphemeBreak::SPACING_MARK }, { 0x11438, 0x1143F, GraphemeBreak::EXTEND }, { 0x11440, 0x11441, GraphemeBreak::SPACING_MARK },
+        { 0x11442, 0x11444, GraphemeBreak::EXTEND }, { 0x11445, 0x11445, GraphemeBreak::SPACING_MARK }, { 0x11446, 0x11446, GraphemeBreak::EXTEND },
+        { 0x1145E, 0x1145E, GraphemeBreak::EXTEND }, { 0x114B0, 0x114B0, GraphemeBreak::EXTEND }, { 0x114B1, 0x114B2, GraphemeBreak::SPACING_MARK },
+        { 0x114B3, 0x114B8, GraphemeBreak::EXTEND }, { 0x114B9, 0x114B9, GraphemeBreak::SPACING_MARK }, { 0x114BA, 0x114BA, GraphemeBreak::EXTEND },
+        { 0x114BB, 0x114BC, GraphemeBreak::SPACING_MARK }, { 0x114BD, 0x114BD, GraphemeBreak::EXTEND }, { 0x114BE, 0x114BE, GraphemeBreak::SPACING_MARK },
+        { 0x114BF, 0x114C0, GraphemeBreak::EXTEND }, { 0x114C1, 0x114C1, GraphemeBreak::SPACING_MARK }, { 0x114C2, 0x114C3, GraphemeBreak::EXTEND },
+        { 0x115AF, 0x115AF, GraphemeBreak::EXTEND }, { 0x115B0, 0x115B1, GraphemeBreak::SPACING_MARK }, { 0x115B2, 0x115B5, GraphemeBreak::EXTEND },
+        { 0x115B8, 0x115BB, GraphemeBreak::SPACING_MARK }, { 0x115BC, 0x115BD, GraphemeBreak::EXTEND }, { 0x115BE, 0x115BE, GraphemeBreak::SPACING_MARK },
+        { 0x115BF, 0x115C0, GraphemeBreak::EXTEND }, { 0x115DC, 0x115DD, GraphemeBreak::EXTEND }, { 0x11630, 0x11632, GraphemeBreak::SPACING_MARK },
+        { 0x11633, 0x1163A, GraphemeBreak::EXTEND }, { 0x1163B, 0x1163C, GraphemeBreak::SPACING_MARK }, { 0x1163D, 0x1163D, GraphemeBreak::EXTEND },
+        { 0x1163E, 0x1163E, GraphemeBreak::SPACING_MARK }, { 0x1163F, 0x11640, GraphemeBreak::EXTEND }, { 0x116AB, 0x116AB, GraphemeBreak::EXTEND },
+        { 0x116AC, 0x116AC, GraphemeBreak::SPACING_MARK }, { 0x116AD, 0x116AD, GraphemeBreak::EXTEND }, { 0x116AE, 0x116AF, GraphemeBreak::SPACING_MARK },
+        { 0x116B0, 0x116B5, GraphemeBreak::EXTEND }, { 0x116B6, 0x116B6, GraphemeBreak::SPACING_MARK }, { 0x116B7, 0x116B7, GraphemeBreak::EXTEND },
+        { 0x1171D, 0x1171F, GraphemeBreak::EXTEND }, { 0x11722, 0x11725, GraphemeBreak::EXTEND }, { 0x11726, 0x11726, GraphemeBreak::SPACING_MARK },
+        { 0x11727, 0x1172B, GraphemeBreak::EXTEND }, { 0x1182C, 0x1182E, GraphemeBreak::SPACING_MARK }, { 0x1182F, 0x11837, GraphemeBreak::EXTEND },
+        { 0x11838, 0x11838, GraphemeBreak::SPACING_MARK }, { 0x11839, 0x1183A, GraphemeBreak::EXTEND }, { 0x11930, 0x11930, GraphemeBreak::EXTEND },
+        { 0x11931, 0x11935, GraphemeBreak::SPACING_MARK }, { 0x11937, 0x11938, GraphemeBreak::SPACING_MARK }, { 0x1193B, 0x1193C, GraphemeBreak::EXTEND },
+        { 0x1193D, 0x1193D, GraphemeBreak::SPACING_MARK }, { 0x1193E, 0x1193E, GraphemeBreak::EXTEND }, { 0x1193F, 0x1193F, GraphemeBreak::PREPEND },
+        { 0x11940, 0x11940, GraphemeBreak::SPACING_MARK }, { 0x11941, 0x11941, GraphemeBreak::PREPEND }, { 0x11942, 0x11942, GraphemeBreak::SPACING_MARK },
+        { 0x11943, 0x11943, GraphemeBreak::EXTEND }, { 0x119D1, 0x119D3, GraphemeBreak::SPACING_MARK }, { 0x119D4, 0x119D7, GraphemeBreak::EXTEND },
+        { 0x119DA, 0x119DB, GraphemeBreak::EXTEND }, { 0x119DC, 0x119DF, GraphemeBreak::SPACING_MARK }, { 0x119E0, 0x119E0, GraphemeBreak::EXTEND },
+        { 0x119E4, 0x119E4, GraphemeBreak::SPACING_MARK }, { 0x11A01, 0x11A0A, GraphemeBreak::EXTEND }, { 0x11A33, 0x11A38, GraphemeBreak::EXTEND },
+        { 0x11A39, 0x11A39, GraphemeBreak::SPACING_MARK }, { 0x11A3A, 0x11A3A, GraphemeBreak::PREPEND }, { 0x11A3B, 0x11A3E, GraphemeBreak::EXTEND },
+        { 0x11A47, 0x11A47, GraphemeBreak::EXTEND }, { 0x11A51, 0x11A56, GraphemeBreak::EXTEND }, { 0x11A57, 0x11A58, GraphemeBreak::SPACING_MARK },
+        { 0x11A59, 0x11A5B, GraphemeBreak::EXTEND }, { 0x11A84, 0x11A89, GraphemeBreak::PREPEND }, { 0x11A8A, 0x11A96, GraphemeBreak::EXTEND },
+        { 0x11A97, 0x11A97, GraphemeBreak::SPACING_MARK }, { 0x11A98, 0x11A99, GraphemeBreak::EXTEND }, { 0x11C2F, 0x11C2F, GraphemeBreak::SPACING_MARK },
+        { 0x11C30, 0x11C36, GraphemeBreak::EXTEND }, { 0x11C38, 0x11C3D, GraphemeBreak::EXTEND }, { 0x11C3E, 0x11C3E, GraphemeBreak::SPACING_MARK },
+        { 0x11C3F, 0x11C3F, GraphemeBreak::EXTEND }, { 0x11C92, 0x11CA7, GraphemeBreak::EXTEND }, { 0x11CA9, 0x11CA9, GraphemeBreak::SPACING_MARK },
+        { 0x11CAA, 0x11CB0, GraphemeBreak::EXTEND }, { 0x11CB1, 0x11CB1, GraphemeBreak::SPACING_MARK }, { 0x11CB2, 0x11CB3, GraphemeBreak::EXTEND },
+        { 0x11CB4, 0x11CB4, GraphemeBreak::SPACING_MARK }, { 0x11CB5, 0x11CB6, GraphemeBreak::EXTEND }, { 0x11D31, 0x11D36, GraphemeBreak::EXTEND },
+        { 0x11D3A, 0x11D3A, GraphemeBreak::EXTEND }, { 0x11D3C, 0x11D3D, GraphemeBreak::EXTEND }, { 0x11D3F, 0x11D45, GraphemeBreak::EXTEND },
+        { 0x11D46, 0x11D46, GraphemeBreak::PREPEND }, { 0x11D47, 0x11D47, GraphemeBreak::EXTEND }, { 0x11D8A, 0x11D8E, GraphemeBreak::SPACING_MARK },
+        { 0x11D90, 0x11D91, GraphemeBreak::EXTEND }, { 0x11D93, 0x11D94, GraphemeBreak::SPACING_MARK }, { 0x11D95, 0x11D95, GraphemeBreak::EXTEND },
+        { 0x11D96, 0x11D96, GraphemeBreak::SPACING_MARK }, { 0x11D97, 0x11D97, GraphemeBreak::EXTEND }, { 0x11EF3, 0x11EF4, GraphemeBreak::EXTEND },
+        { 0x11EF5, 0x11EF6, GraphemeBreak::SPACING_MARK }, { 0x13430, 0x13438, GraphemeBreak::CONTROL }, { 0x16AF0, 0x16AF4, GraphemeBreak::EXTEND },
+        { 0x16B30, 0x16B36, GraphemeBreak::EXTEND }, { 0x16F4F, 0x16F4F, GraphemeBreak::EXTEND }, { 0x16F51, 0x16F87, GraphemeBreak::SPACING_MARK },
+        { 0x16F8F, 0x16F92, GraphemeBreak::EXTEND }, { 0x16FE4, 0x16FE4, GraphemeBreak::EXTEND }, { 0x16FF0, 0x16FF1, GraphemeBreak::SPACING_MARK },
+        { 0x1BC9D, 0x1BC9E, GraphemeBreak::EXTEND }, { 0x1BCA0, 0x1BCA3, GraphemeBreak::CONTROL }, { 0x1CF00, 0x1CF2D, GraphemeBreak::EXTEND },
+        { 0x1CF30, 0x1CF46, GraphemeBreak::EXTEND }, { 0x1D165, 0x1D165, GraphemeBreak::EXTEND }, { 0x1D166, 0x1D166, GraphemeBreak::SPACING_MARK },
+        { 0x1D167, 0x1D169, GraphemeBreak::EXTEND }, { 0x1D16D, 0x1D16D, GraphemeBreak::SPACING_MARK }, { 0x1D16E, 0x1D172, GraphemeBreak::EXTEND },
+        { 0x1D173, 0x1D17A, GraphemeBreak::CONTROL }, { 0x1D17B, 0x1D182, GraphemeBreak::EXTEND }, { 0x1D185, 0x1D18B, GraphemeBreak::EXTEND },
+        { 0x1D1AA, 0x1D1AD, GraphemeBreak::EXTEND }, { 0x1D242, 0x1D244, GraphemeBreak::EXTEND }, { 0x1DA00, 0x1DA36, GraphemeBreak::EXTEND },
+        { 0x1DA3B, 0x1DA6C, GraphemeBreak::EXTEND }, { 0x1DA75, 0x1DA75, GraphemeBreak::EXTEND }, { 0x1DA84, 0x1DA84, GraphemeBreak::EXTEND },
+        { 0x1DA9B, 0x1DA9F, GraphemeBreak::EXTEND }, { 0x1DAA1, 0x1DAAF, GraphemeBreak::EXTEND }, { 0x1E000, 0x1E006, GraphemeBreak::EXTEND },
+        { 0x1E008, 0x1E018, GraphemeBreak::EXTEND }, { 0x1E01B, 0x1E021, GraphemeBreak::EXTEND }, { 0x1E023, 0x1E024, GraphemeBreak::EXTEND },
+        { 0x1E026, 0x1E02A, GraphemeBreak::EXTEND }, { 0x1E130, 0x1E136, GraphemeBreak::EXTEND }, { 0x1E2AE, 0x1E2AE, GraphemeBreak::EXTEND },
+        { 0x1E2EC, 0x1E2EF, GraphemeBreak::EXTEND }, { 0x1E8D0, 0x1E8D6, GraphemeBreak::EXTEND }, { 0x1E944, 0x1E94A, GraphemeBreak::EXTEND },
+        { 0x1F000, 0x1F0FF, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F10D, 0x1F10F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F12F, 0x1F12F, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F16C, 0x1F171, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F17E, 0x1F17F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F18E, 0x1F18E, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F191, 0x1F19A, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F1AD, 0x1F1E5, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F1E6, 0x1F1FF, GraphemeBreak::REGIONAL_INDICATOR },
+        { 0x1F201, 0x1F20F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F21A, 0x1F21A, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F22F, 0x1F22F, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F232, 0x1F23A, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F23C, 0x1F23F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F249, 0x1F3FA, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F3FB, 0x1F3FF, GraphemeBreak::EXTEND }, { 0x1F400, 0x1F53D, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F546, 0x1F64F, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F680, 0x1F6FF, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F774, 0x1F77F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F7D5, 0x1F7FF, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F80C, 0x1F80F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F848, 0x1F84F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F85A, 0x1F85F, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F888, 0x1F88F, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F8AE, 0x1F8FF, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F90C, 0x1F93A, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0x1F93C, 0x1F945, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1F947, 0x1FAFF, GraphemeBreak::EXTENDED_PICTOGRAPHIC }, { 0x1FC00, 0x1FFFD, GraphemeBreak::EXTENDED_PICTOGRAPHIC },
+        { 0xE0000, 0xE001F, GraphemeBreak::CONTROL }, { 0xE0020, 0xE007F, GraphemeBreak::EXTEND }, { 0xE0080, 0xE00FF, GraphemeBreak::CONTROL },
+        { 0xE0100, 0xE01EF, GraphemeBreak::EXTEND }, { 0xE01F0, 0xE0FFF, GraphemeBreak::CONTROL },
+    };
+}
+
+inline tuim::GraphemeBreak tuim::GetGraphemeBreak(char32_t ch) {
+    // Fast path for ASCII characters.
+    if (ch < 0x7F) {
+        if (ch == '\r') return GraphemeBreak::CR;
+        if (ch == '\n') return GraphemeBreak::LF;
+        if (ch < 0x20) return GraphemeBreak::CONTROL;
+        return GraphemeBreak::OTHER;
+    }
+
+    // Hangul syllables are either LV or LVT depending on their trailing consonant.
+    if (ch >= 0xAC00 && ch <= 0xD7A3)
+        return ((ch - 0xAC00) % 28 == 0) ? GraphemeBreak::LV : GraphemeBreak::LVT;
+
+    // Binary search the range that contains the character.
+    size_t low = 0;
+    size_t high = std::size(GRAPHEME_BREAK_RANGES);
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        const GraphemeBreakRange& range = GRAPHEME_BREAK_RANGES[mid];
+        if (ch < range.first) high = mid;
+        else if (ch > range.last) low = mid + 1;
+        else return range.value;
+    }
+    return GraphemeBreak::OTHER;
+}
+
+// https://www.unicode.org/reports/tr29/#Grapheme_Cluster_Boundary_Rules
+inline bool tuim::IsGraphemeBreak(GraphemeBreak prev, GraphemeBreak next, bool pictographicZwj, size_t regionalCount) {
+    using GB = GraphemeBreak;
+
+    // GB3, GB4, GB5: CR x LF, break around other controls.
+    if (prev == GB::CR && next == GB::LF) return false;
+    if (prev == GB::CR || prev == GB::LF || prev == GB::CONTROL) return true;
+    if (next == GB::CR || next == GB::LF || next == GB::CONTROL) return true;
+
+    // GB6, GB7, GB8: do not break Hangul syllable sequences.
+    if (prev == GB::L && (next == GB::L || next == GB::V || next == GB::LV || next == GB::LVT)) return false;
+    if ((prev == GB::LV || prev == GB::V) && (next == GB::V || next == GB::T)) return false;
+    if ((prev == GB::LVT || prev == GB::T) && next == GB::T) return false;
+
+    // GB9, GB9a, GB9b: do not break before extending characters or spacing marks, nor after prepend characters.
+    if (next == GB::EXTEND || next == GB::ZWJ || next == GB::SPACING_MARK) return false;
+    if (prev == GB::PREPEND) return false;
+
+    // GB11: do not break within emoji ZWJ sequences.
+    if (prev == GB::ZWJ && next == GB::EXTENDED_PICTOGRAPHIC && pictographicZwj) return false;
+
+    // GB12, GB13: do not break within emoji flags (pairs of regional indicators).
+    if (prev == GB::REGIONAL_INDICATOR && next == GB::REGIONAL_INDICATOR && regionalCount % 2 == 1) return false;
+
+    // GB999: otherwise, break everywhere.
+    return true;
+}
+
+inline tuim::GraphemeSegmenter::GraphemeSegmenter(char32_t first) {
+    m_Prev = tuim::GetGraphemeBreak(first);
+    m_Pictographic = (m_Prev == GraphemeBreak::EXTENDED_PICTOGRAPHIC);
+    m_PictographicZwj = false;
+    m_RegionalCount = (m_Prev == GraphemeBreak::REGIONAL_INDICATOR);
+}
+
+inline bool tuim::GraphemeSegmenter::Next(char32_t ch) {
+    GraphemeBreak next = tuim::GetGraphemeBreak(ch);
+    if (tuim::IsGraphemeBreak(m_Prev, next, m_PictographicZwj, m_RegionalCount))
+        return true;
+
+    m_PictographicZwj = (next == GraphemeBreak::ZWJ && m_Pictographic);
+    m_Pictographic = (next == GraphemeBreak::EXTENDED_PICTOGRAPHIC) || (next == GraphemeBreak::EXTEND && m_Pictographic);
+    m_RegionalCount = (next == GraphemeBreak::REGIONAL_INDICATOR) ? m_RegionalCount + 1 : 0;
+    m_Prev = next;
+    return false;
+}
+
+inline size_t tuim::GraphemeLength(std::u32string_view chars, size_t index) {
+    if (index >= chars.size())
+        return 0;
+
+    // Fast path: an ASCII character followed by another one is always a cluster on its own (except CR LF).
+    if (chars[index] < 0x80 && chars[index] != '\r' && (index + 1 == chars.size() || chars[index + 1] < 0x80))
+        return 1;
+
+    GraphemeSegmenter segmenter(chars[index]);
+    size_t end = index + 1;
+    while (end < chars.size() && !segmenter.Next(chars[end]))
+        end++;
+    return end - index;
+}
+
+inline size_t tuim::Utf8GraphemeLength(std::string_view sv, size_t index) {
+    if (index >= sv.size())
+        return 0;
+
+    // Invalid characters are always a cluster on their own.
+    char32_t ch;
+    uint8_t length = tuim::Utf8DecodeNext(sv, index, ch);
+    if (ch == 0xFFFD && length == 1)
+        return 1;
+
+    GraphemeSegmenter segmenter(ch);
+    size_t end = index + length;
+    while (end < sv.size()) {
+        length = tuim::Utf8DecodeNext(sv, end, ch);
+        if ((ch == 0xFFFD && length == 1) || segmenter.Next(ch))
+            break;
+        end += length;
+    }
+
+    return end - index;
+}
+
+inline size_t tuim::Utf8FitWidth(std::string_view sv, int maxWidth) {
+    // Printable ASCII characters are a single column wide.
+    size_t i = 0;
+    size_t ascii = std::min(sv.size(), (size_t) std::max(0, maxWidth));
+    while (i < ascii && sv[i] >= 0x20 && sv[i] < 0x7F) i++;
+    if (i == sv.size())
+        return i;
+
+    // The last ASCII character may be extended by a combining mark.
+    if (i > 0) i--;
+
+    // Only the clusters that are drawn are decoded, whatever the length of the line.
+    int width = i;
+    while (i < sv.size()) {
+        size_t length = tuim::Utf8GraphemeLength(sv, i);
+        width += tuim::CalcPlainTextWidth(sv.substr(i, length));
+        if (width > maxWidth)
+            break;
+        i += length;
+    }
+    return i;
+}
+
+inline std::u32string tuim::Utf8DecodeString(std::string_view sv) {
+    std::u32string str;
+    tuim::Utf8DecodeString(sv, str, nullptr);
+    return str;
+}
+
+inline int tuim::GraphemeWidth(std::u32string_view cluster) {
+    if (cluster.empty())
+        return 0;
+
+    int width = std::max(0, tuim::Utf8CharWidth(cluster.front()));
+
+    // Flags made of two regional indicators are drawn as a single wide emoji.
+    if (cluster.size() > 1 && tuim::GetGraphemeBreak(cluster.front()) == GraphemeBreak::REGIONAL_INDICATOR)
+        return 2;
+
+    // The variation selector 16 requests the emoji presentation, which is always wide.
+    for (size_t i = 1; i < cluster.size(); i++) {
+        if (cluster[i] == 0xFE0F)
+            return 2;
+    }
+
+    return width;
 }
 
 /**********************************************************
@@ -2179,6 +7697,13 @@ inline size_t tuim::CalcTextWidth(std::string_view sv) {
 
 inline void tuim::AddItem(std::shared_ptr<tuim::Item> item) {
     Context* ctx = tuim::GetCtx();
+    item->m_Layer = ctx->m_LayersStack.empty() ? LAYER_BASE : ctx->m_LayersStack.top();
+
+    // Items inside containers are positioned in their viewport, which is offset in the screen.
+    std::shared_ptr<Frame> frame = tuim::GetCurrentFrame();
+    if (frame->m_Target != nullptr)
+        item->m_Pos = item->m_Pos + frame->m_Offset;
+    ctx->m_ItemIndex.Add(*item);
     ctx->m_ItemsOrdered.push_back(item);
     ctx->m_Items.emplace(item->m_Id, item);
 }
@@ -2208,6 +7733,8 @@ inline void tuim::MergeFrame(std::shared_ptr<tuim::Frame> src) {
             dst->m_Cells[origin.y + y][origin.x + x] = src->m_Cells[y][x];
         }
     }
+    vec2 srcSize = src->GetSize();
+    dst->m_Drawn = dst->m_Drawn.Union(rect(origin.x, origin.y, srcSize.x, srcSize.y));
 
     // Move the dest frame cursor to not overwrite when printing characters after merging.
     dst->m_Cursor = vec2(0, origin.y + src->m_Cells.size());
@@ -2238,7 +7765,7 @@ inline std::shared_ptr<tuim::Container> tuim::GetCurrentContainer() {
         // Make sure that the container's frame is the current screen frame,
         // and that it has the right size.
         ctx->m_DefaultContainer->m_Frame = ctx->m_Frame;
-        ctx->m_DefaultContainer->m_Size = tuim::Terminal::GetTerminalSize();
+        ctx->m_DefaultContainer->m_Size = ctx->m_TerminalSize;
         ctx->m_DefaultContainer->m_Pos = vec2(0, 0);
         return ctx->m_DefaultContainer;
     }